@@ -18,10 +18,15 @@ public class Enfer : ModuleRules
 			"StateTreeModule",
 			"GameplayStateTreeModule",
 			"UMG",
-			"NavigationSystem"
+			"NavigationSystem",
+			"MassEntity"
 		});
 
-		PrivateDependencyModuleNames.AddRange(new string[] { });
+		PrivateDependencyModuleNames.AddRange(new string[] {
+			"RenderCore",
+			"Navmesh",
+			"AnimationBudgetAllocator"
+		});
 
 		if (Target.bBuildEditor)
 		{
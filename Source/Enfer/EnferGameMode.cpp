@@ -9,6 +9,28 @@ AEnferGameMode::AEnferGameMode()
 {
 	// Create nav mesh manager component
 	NavMeshManager = CreateDefaultSubobject<UJGNavMeshManager>(TEXT("NavMeshManager"));
+
+	// Create chunk significance manager component
+	ChunkSignificanceManager = CreateDefaultSubobject<UJGChunkSignificanceManager>(TEXT("ChunkSignificanceManager"));
+
+	// Create streaming governor component
+	StreamingGovernor = CreateDefaultSubobject<UJGStreamingGovernor>(TEXT("StreamingGovernor"));
+
+	// Create nav benchmark component
+	NavBenchmark = CreateDefaultSubobject<UJGNavBenchmark>(TEXT("NavBenchmark"));
+
+	// Create NPC pool and spawner components
+	NPCPool = CreateDefaultSubobject<UJGNPCPool>(TEXT("NPCPool"));
+	NPCSpawner = CreateDefaultSubobject<UJGNPCSpawner>(TEXT("NPCSpawner"));
+
+	// Create AI LOD manager component
+	AILODManager = CreateDefaultSubobject<UJGAILODManager>(TEXT("AILODManager"));
+
+	// Create animation budget manager component
+	AnimationBudgetManager = CreateDefaultSubobject<UJGAnimationBudgetManager>(TEXT("AnimationBudgetManager"));
+
+	// Create crowd manager component
+	CrowdManager = CreateDefaultSubobject<UJGCrowdManager>(TEXT("CrowdManager"));
 }
 
 bool AEnferGameMode::SetPause(APlayerController* playerController, FCanUnpause canUnpauseDelegate)
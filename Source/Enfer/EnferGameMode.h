@@ -5,6 +5,14 @@
 #include "CoreMinimal.h"
 #include "GameFramework/GameModeBase.h"
 #include "Public/JGNavMeshManager.h"
+#include "Public/JGChunkSignificanceManager.h"
+#include "Public/JGStreamingGovernor.h"
+#include "Public/JGNavBenchmark.h"
+#include "Public/JGCrowdManager.h"
+#include "Public/JGNPCPool.h"
+#include "Public/JGNPCSpawner.h"
+#include "Public/JGAILODManager.h"
+#include "Public/JGAnimationBudgetManager.h"
 #include "EnferGameMode.generated.h"
 
 class UUserWidget;
@@ -31,6 +39,38 @@ protected:
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Navigation")
 	UJGNavMeshManager* NavMeshManager;
 
+	// Chunk significance manager component
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Rendering")
+	UJGChunkSignificanceManager* ChunkSignificanceManager;
+
+	// Streaming governor component, sizes the chunk window from frame time
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Streaming")
+	UJGStreamingGovernor* StreamingGovernor;
+
+	// Nav rebuild benchmark component, only runs with -JGNavBenchmark
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Navigation")
+	UJGNavBenchmark* NavBenchmark;
+
+	// Pool of the NPCs placed by the spawner and promoted from the crowd
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "NPC")
+	UJGNPCPool* NPCPool;
+
+	// Places NPCs in the chunks entering the window
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "NPC")
+	UJGNPCSpawner* NPCSpawner;
+
+	// Puts the NPCs' AI in distance and visibility tiers
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "NPC")
+	UJGAILODManager* AILODManager;
+
+	// Budgets the animation of the NPC meshes
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "NPC")
+	UJGAnimationBudgetManager* AnimationBudgetManager;
+
+	// Ambient sidewalk crowd component
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Crowd")
+	UJGCrowdManager* CrowdManager;
+
 	UPROPERTY(VisibleAnywhere, BlueprintReadWrite, Category = "Pause")
 	UUserWidget* PauseMenuInstance;
 };
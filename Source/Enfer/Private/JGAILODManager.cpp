@@ -0,0 +1,239 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Public/JGAILODManager.h"
+#include "Public/JGPlayerContextSubsystem.h"
+#include "Public/JGSidewalkLane.h"
+#include "AIController.h"
+#include "BrainComponent.h"
+#include "BehaviorTree/BehaviorTreeComponent.h"
+#include "Components/CapsuleComponent.h"
+#include "Engine/World.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "GameFramework/GameModeBase.h"
+#include "Navigation/PathFollowingComponent.h"
+#include "ProfilingDebugging/CsvProfiler.h"
+#include "JGNPC.h"
+
+DECLARE_STATS_GROUP(TEXT("JG AI"), STATGROUP_JGAI, STATCAT_Advanced);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Full tier NPCs"), STAT_JGAIFullTier, STATGROUP_JGAI);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Reduced tier NPCs"), STAT_JGAIReducedTier, STATGROUP_JGAI);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Far tier NPCs"), STAT_JGAIFarTier, STATGROUP_JGAI);
+
+CSV_DEFINE_CATEGORY(JGAI, true);
+
+UJGAILODManager::UJGAILODManager()
+{
+	PrimaryComponentTick.bCanEverTick = true;
+	TimeSinceEvaluation = 0.0f;
+
+	FullDistance = 2500.0f;
+	FarDistance = 6000.0f;
+	Hysteresis = 300.0f;
+	VisibilityTolerance = 0.25f;
+	ReducedServiceIntervalScale = 3.0f;
+	EvaluationInterval = 0.1f;
+}
+
+UJGAILODManager* UJGAILODManager::Get(const UWorld* world)
+{
+	const AGameModeBase* gameMode = world ? world->GetAuthGameMode() : nullptr;
+	return gameMode ? gameMode->FindComponentByClass<UJGAILODManager>() : nullptr;
+}
+
+float UJGAILODManager::GetServiceIntervalScale(const UBehaviorTreeComponent& ownerComp)
+{
+	const AAIController* ai = ownerComp.GetAIOwner();
+	const AJGNPC* npc = ai ? Cast<AJGNPC>(ai->GetPawn()) : nullptr;
+	if (!npc || npc->AILODTier != EJGAILODTier::Reduced)
+	{
+		return 1.0f;
+	}
+
+	const UJGAILODManager* aiLODManager = Get(ownerComp.GetWorld());
+	return aiLODManager ? aiLODManager->ReducedServiceIntervalScale : 1.0f;
+}
+
+void UJGAILODManager::RegisterNPC(AJGNPC* npc)
+{
+	if (IsValid(npc) && !NPCStates.ContainsByPredicate([npc](const FNPCState& entry) { return entry.NPC == npc; }))
+	{
+		FNPCState& state = NPCStates.AddDefaulted_GetRef();
+		state.NPC = npc;
+	}
+}
+
+void UJGAILODManager::UnregisterNPC(AJGNPC* npc)
+{
+	NPCStates.RemoveAll([npc](const FNPCState& entry) { return entry.NPC == npc; });
+}
+
+void UJGAILODManager::ResetTier(AJGNPC* npc)
+{
+	FNPCState* state = NPCStates.FindByPredicate([npc](const FNPCState& entry) { return entry.NPC == npc; });
+	if (state)
+	{
+		SetTier(*state, EJGAILODTier::Full);
+	}
+}
+
+void UJGAILODManager::TickComponent(float deltaTime, ELevelTick tickType, FActorComponentTickFunction* thisTickFunction)
+{
+	Super::TickComponent(deltaTime, tickType, thisTickFunction);
+
+	TimeSinceEvaluation += deltaTime;
+	if (TimeSinceEvaluation >= EvaluationInterval)
+	{
+		EvaluateTiers();
+		TimeSinceEvaluation = 0.0f;
+	}
+
+	MoveFarNPCs(deltaTime);
+}
+
+void UJGAILODManager::EvaluateTiers()
+{
+	NPCStates.RemoveAll([](const FNPCState& entry) { return !entry.NPC.IsValid(); });
+
+	Stats.FullCount = 0;
+	Stats.ReducedCount = 0;
+	Stats.FarCount = 0;
+
+	for (FNPCState& state : NPCStates)
+	{
+		AJGNPC* npc = state.NPC.Get();
+
+		// Pooled NPCs are reset by the pool
+		if (npc->IsHidden())
+		{
+			continue;
+		}
+
+		const FJGPlayerContext* player = UJGPlayerContextSubsystem::FindClosest(GetWorld(), npc->GetActorLocation());
+		const float distance = player ? FVector2D::Distance(player->Location2D, FVector2D(npc->GetActorLocation())) : 0.0f;
+
+		// Leaving a tier takes Hysteresis past its threshold
+		const EJGAILODTier currentTier = npc->AILODTier;
+		const float fullThreshold = currentTier == EJGAILODTier::Full ? FullDistance + Hysteresis : FullDistance;
+		const float farThreshold = currentTier == EJGAILODTier::Far ? FarDistance - Hysteresis : FarDistance;
+
+		EJGAILODTier tier = EJGAILODTier::Reduced;
+		if (distance > farThreshold)
+		{
+			tier = EJGAILODTier::Far;
+		}
+		else if (distance <= fullThreshold && npc->WasRecentlyRendered(VisibilityTolerance))
+		{
+			tier = EJGAILODTier::Full;
+		}
+
+		if (static_cast<uint8>(tier) > static_cast<uint8>(npc->MaxAILODTier))
+		{
+			tier = npc->MaxAILODTier;
+		}
+
+		SetTier(state, tier);
+
+		switch (tier)
+		{
+		case EJGAILODTier::Full:
+			Stats.FullCount++;
+			break;
+		case EJGAILODTier::Reduced:
+			Stats.ReducedCount++;
+			break;
+		case EJGAILODTier::Far:
+			Stats.FarCount++;
+			break;
+		}
+	}
+
+	SET_DWORD_STAT(STAT_JGAIFullTier, Stats.FullCount);
+	SET_DWORD_STAT(STAT_JGAIReducedTier, Stats.ReducedCount);
+	SET_DWORD_STAT(STAT_JGAIFarTier, Stats.FarCount);
+	CSV_CUSTOM_STAT(JGAI, FullTier, Stats.FullCount, ECsvCustomStatOp::Set);
+	CSV_CUSTOM_STAT(JGAI, ReducedTier, Stats.ReducedCount, ECsvCustomStatOp::Set);
+	CSV_CUSTOM_STAT(JGAI, FarTier, Stats.FarCount, ECsvCustomStatOp::Set);
+}
+
+void UJGAILODManager::SetTier(FNPCState& state, EJGAILODTier tier)
+{
+	AJGNPC* npc = state.NPC.Get();
+	if (!IsValid(npc) || npc->AILODTier == tier)
+	{
+		return;
+	}
+
+	const bool wasFar = npc->AILODTier == EJGAILODTier::Far;
+	const bool isFar = tier == EJGAILODTier::Far;
+	npc->AILODTier = tier;
+	Stats.TotalTransitions++;
+
+	// Between full and reduced only the service intervals change, the services read the tier
+	if (wasFar == isFar)
+	{
+		return;
+	}
+
+	AAIController* ai = Cast<AAIController>(npc->GetController());
+	UBrainComponent* brain = ai ? ai->GetBrainComponent() : nullptr;
+	UPathFollowingComponent* pathFollowing = ai ? ai->GetPathFollowingComponent() : nullptr;
+	UCharacterMovementComponent* characterMovement = npc->GetCharacterMovement();
+
+	if (isFar)
+	{
+		// The walk goes on along the lane, the velocity is left on the movement component for the animation
+		state.FarVelocity = FVector(characterMovement->Velocity.X, 0.0f, 0.0f);
+		characterMovement->SetComponentTickEnabled(false);
+
+		if (pathFollowing)
+		{
+			pathFollowing->PauseMove(FAIRequestID::CurrentRequest, EPathFollowingVelocityMode::Keep);
+		}
+		if (brain)
+		{
+			brain->PauseLogic(TEXT("AI LOD"));
+		}
+		return;
+	}
+
+	state.FarVelocity = FVector::ZeroVector;
+	characterMovement->SetComponentTickEnabled(true);
+
+	// The path following picks up the segment closest to where the lane walk left the NPC
+	if (pathFollowing)
+	{
+		pathFollowing->ResumeMove();
+	}
+	if (brain && brain->IsPaused())
+	{
+		brain->ResumeLogic(TEXT("AI LOD"));
+	}
+}
+
+void UJGAILODManager::MoveFarNPCs(float deltaTime)
+{
+	const FJGSidewalkLane* lane = FJGSidewalkLane::Get(GetWorld());
+
+	for (FNPCState& state : NPCStates)
+	{
+		AJGNPC* npc = state.NPC.Get();
+		if (!IsValid(npc) || npc->AILODTier != EJGAILODTier::Far || npc->IsHidden() || state.FarVelocity.IsNearlyZero())
+		{
+			continue;
+		}
+
+		const FVector halfHeight(0.0f, 0.0f, npc->GetCapsuleComponent()->GetScaledCapsuleHalfHeight());
+		const FVector target = npc->GetActorLocation() + state.FarVelocity * deltaTime - halfHeight;
+
+		// Stops at the end of its walkable interval, the behavior tree picks a way around once it resumes
+		FVector groundLocation;
+		if (!lane || !lane->FindNearestWalkablePoint(target, groundLocation, 1.0f))
+		{
+			state.FarVelocity = FVector::ZeroVector;
+			npc->GetCharacterMovement()->Velocity = FVector::ZeroVector;
+			continue;
+		}
+
+		npc->SetActorLocation(groundLocation + halfHeight, false, nullptr, ETeleportType::TeleportPhysics);
+	}
+}
@@ -0,0 +1,120 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Public/JGAnimationBudgetManager.h"
+#include "Animation/AnimInstance.h"
+#include "AnimationBudgetAllocatorParameters.h"
+#include "Engine/World.h"
+#include "GameFramework/GameModeBase.h"
+#include "IAnimationBudgetAllocator.h"
+#include "Public/JGPlayerContextSubsystem.h"
+#include "SkeletalMeshComponentBudgeted.h"
+
+UJGAnimationBudgetManager::UJGAnimationBudgetManager()
+{
+	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.TickGroup = TG_PostUpdateWork;
+
+	UseAnimationBudget = true;
+	BudgetMs = 1.0f;
+	MaxTickRate = 10;
+	SignificanceDistance = 6000.0f;
+	BehindCameraDot = -0.2f;
+	BehindCameraScale = 0.25f;
+	OffscreenScale = 0.1f;
+}
+
+UJGAnimationBudgetManager* UJGAnimationBudgetManager::Get(const UWorld* world)
+{
+	const AGameModeBase* gameMode = world ? world->GetAuthGameMode() : nullptr;
+	return gameMode ? gameMode->FindComponentByClass<UJGAnimationBudgetManager>() : nullptr;
+}
+
+void UJGAnimationBudgetManager::BeginPlay()
+{
+	Super::BeginPlay();
+
+	IAnimationBudgetAllocator* allocator = IAnimationBudgetAllocator::Get(GetWorld());
+	if (!UseAnimationBudget || !allocator)
+	{
+		SetComponentTickEnabled(false);
+		return;
+	}
+
+	FAnimationBudgetAllocatorParameters parameters;
+	parameters.BudgetInMs = BudgetMs;
+	parameters.MaxTickRate = MaxTickRate;
+	allocator->SetParameters(parameters);
+	allocator->SetEnabled(true);
+}
+
+void UJGAnimationBudgetManager::RegisterMesh(USkeletalMeshComponent* mesh)
+{
+	USkeletalMeshComponentBudgeted* budgetedMesh = Cast<USkeletalMeshComponentBudgeted>(mesh);
+	if (!budgetedMesh || !UseAnimationBudget)
+	{
+		return;
+	}
+
+	// Significance comes from TickComponent
+	budgetedMesh->SetAutoCalculateSignificance(false);
+	Meshes.AddUnique(budgetedMesh);
+}
+
+void UJGAnimationBudgetManager::UnregisterMesh(USkeletalMeshComponent* mesh)
+{
+	Meshes.Remove(Cast<USkeletalMeshComponentBudgeted>(mesh));
+}
+
+void UJGAnimationBudgetManager::TickComponent(float deltaTime, ELevelTick tickType, FActorComponentTickFunction* thisTickFunction)
+{
+	Super::TickComponent(deltaTime, tickType, thisTickFunction);
+
+	IAnimationBudgetAllocator* allocator = IAnimationBudgetAllocator::Get(GetWorld());
+	if (!allocator)
+	{
+		return;
+	}
+
+	Meshes.RemoveAll([](const TWeakObjectPtr<USkeletalMeshComponentBudgeted>& mesh) { return !mesh.IsValid(); });
+	for (const TWeakObjectPtr<USkeletalMeshComponentBudgeted>& weakMesh : Meshes)
+	{
+		USkeletalMeshComponentBudgeted* mesh = weakMesh.Get();
+		// Pooled NPCs are hidden and taken off the allocator
+		if (!mesh->IsRegistered() || mesh->GetOwner()->IsHidden())
+		{
+			continue;
+		}
+
+		// Montages run at full rate even off-screen, behavior tree tasks wait for them to end
+		const UAnimInstance* animInstance = mesh->GetAnimInstance();
+		if (animInstance && animInstance->IsAnyMontagePlaying())
+		{
+			allocator->SetComponentSignificance(mesh, 1.0f, true, true, false);
+			continue;
+		}
+
+		// Budgeted against the closest player, like the rest of the NPC logic
+		const FVector meshLocation = mesh->GetComponentLocation();
+		const FJGPlayerContext* player = UJGPlayerContextSubsystem::FindClosest(GetWorld(), meshLocation);
+		if (!player)
+		{
+			continue;
+		}
+
+		float significance = FMath::Clamp(1.0f - FVector::Dist(player->Location, meshLocation) / SignificanceDistance, 0.0f, 1.0f);
+
+		// Facing is evaluated in 2D, like the chunk significance
+		const FVector2D toMesh2D = FVector2D(meshLocation - player->Location).GetSafeNormal();
+		if (FVector2D::DotProduct(toMesh2D, player->Forward2D) < BehindCameraDot)
+		{
+			significance *= BehindCameraScale;
+		}
+
+		if (!mesh->WasRecentlyRendered())
+		{
+			significance *= OffscreenScale;
+		}
+
+		allocator->SetComponentSignificance(mesh, significance);
+	}
+}
@@ -4,8 +4,28 @@
 #include "Public/JGChunk.h"
 #include "Components/StaticMeshComponent.h"
 #include "Components/PrimitiveComponent.h"
+#include "Components/ChildActorComponent.h"
+#include "Components/ShapeComponent.h"
+#include "Engine/BlueprintGeneratedClass.h"
+#include "Engine/SCS_Node.h"
+#include "Engine/SimpleConstructionScript.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/StaticMeshActor.h"
+#include "Engine/Texture.h"
 #include "Engine/World.h"
+#include "Kismet/GameplayStatics.h"
+#include "Materials/MaterialInterface.h"
+#include "NavigationSystem.h"
+#include "NavMesh/NavMeshBoundsVolume.h"
+#include "NavMesh/RecastNavMesh.h"
+#include "NavMesh/RecastNavMeshDataChunk.h"
+#include "Public/JGNavTileGrid.h"
+#include "Algo/BinarySearch.h"
 #include "AssetRegistry/AssetData.h"
+#include "AssetRegistry/AssetRegistryModule.h"
+#include "Misc/PackageName.h"
+#include "UObject/Package.h"
+#include "UObject/SavePackage.h"
 
 // Sets default values
 AJGChunk::AJGChunk()
@@ -37,6 +57,15 @@ AJGChunk::AJGChunk()
 	TriggerBoxComponent->SetGenerateOverlapEvents(true);
 }
 
+void AJGChunk::CreateBuilding()
+{
+	if (!IsValid(BuildingChildActor) || BuildingChildActor->IsRegistered())
+		return;
+
+	BuildingChildActor->bAutoRegister = true;
+	BuildingChildActor->RegisterComponent();
+}
+
 void AJGChunk::SetIndex(int32 index)
 {
 	ChunkLogicalIndex = index;
@@ -226,4 +255,757 @@ void AJGChunk::SetupWallBoxCollision()
 	// Configure collision settings
 	WallBoxCollision->SetCollisionProfileName(TEXT("BlockAll"));
 	WallBoxCollision->SetGenerateOverlapEvents(true);
-}
\ No newline at end of file
+}
+
+void AJGChunk::SetupVisibilitySets()
+{
+	VisibilityComponentNames.Reset();
+	VisibilityCells.Reset();
+
+	TSubclassOf<AActor> buildingActorClass = IsValid(BuildingChildActor) ? BuildingChildActor->GetChildActorClass() : nullptr;
+	if (!IsValid(buildingActorClass))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("No valid building actor class found in BuildingChildActor"));
+		return;
+	}
+
+	UWorld* world = GetWorld();
+#if WITH_EDITOR
+	if (!IsValid(world) && GEditor)
+	{
+		world = GEditor->GetEditorWorldContext().World();
+	}
+#endif
+	if (!IsValid(world))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Could not get valid world context for the visibility bake"));
+		return;
+	}
+
+	// Spawn the building where the child actor component puts it, so that its bounds are in chunk space
+	FActorSpawnParameters spawnParams;
+	spawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	AActor* tempActor = world->SpawnActor<AActor>(buildingActorClass, BuildingChildActor->GetRelativeTransform(), spawnParams);
+	if (!IsValid(tempActor))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Could not spawn temporary building actor"));
+		return;
+	}
+
+	TArray<UPrimitiveComponent*> primitiveComponents;
+	tempActor->GetComponents<UPrimitiveComponent>(primitiveComponents);
+
+	TArray<FJGVisibilityComponent> visibilityComponents;
+	FBox buildingBounds(ForceInit);
+	for (UPrimitiveComponent* component : primitiveComponents)
+	{
+		// Only rendered components can be skipped
+		if (!IsValid(component) || component->IsA<UShapeComponent>() || !component->IsVisible() || component->bHiddenInGame)
+		{
+			continue;
+		}
+
+		FJGVisibilityComponent& visibilityComponent = visibilityComponents.AddDefaulted_GetRef();
+		visibilityComponent.Bounds = component->Bounds.GetBox();
+		visibilityComponent.IsOccluder = FJGCorridorVisibility::IsOccluderSize(visibilityComponent.Bounds, VisibilityBakeSettings)
+			&& !component->ComponentHasTag(VisibilityBakeSettings.SeeThroughTag);
+		VisibilityComponentNames.Add(component->GetFName());
+		buildingBounds += visibilityComponent.Bounds;
+	}
+
+	tempActor->Destroy();
+
+	if (!buildingBounds.IsValid)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("No rendered components found for the visibility bake"));
+		return;
+	}
+
+	VisibilityCellsMinX = buildingBounds.Min.X - VisibilityBakeSettings.NeighbourDistance;
+	const float visibilityCellsMaxX = buildingBounds.Max.X + VisibilityBakeSettings.NeighbourDistance;
+	FJGCorridorVisibility::ComputeCells(visibilityComponents, VisibilityCellsMinX, visibilityCellsMaxX, VisibilityBakeSettings, VisibilityCells);
+
+	int32 hiddenCount = 0;
+	for (const FJGVisibilityCell& cell : VisibilityCells)
+	{
+		hiddenCount += cell.HiddenComponents.Num();
+	}
+
+	UE_LOG(LogTemp, Log, TEXT("Baked %d visibility cells for %d components, %.1f hidden per cell on average"),
+		VisibilityCells.Num(), VisibilityComponentNames.Num(), VisibilityCells.Num() > 0 ? float(hiddenCount) / VisibilityCells.Num() : 0.0f);
+}
+
+void AJGChunk::UpdateVisibilityCell(const FVector& cameraLocation)
+{
+	if (VisibilityCells.Num() == 0 || IsBuildingDeferred)
+		return;
+
+	// Mirror chunks are rotated half a turn, the sidewalk is at the same chunk space Y for both rows
+	const FVector localCamera = GetActorTransform().InverseTransformPosition(cameraLocation);
+	int32 cellIndex = FMath::FloorToInt((localCamera.X - VisibilityCellsMinX) / VisibilityBakeSettings.CellSize);
+	const bool isOnSidewalk = FMath::Abs(localCamera.Y - VisibilityBakeSettings.SidewalkY) <= VisibilityBakeSettings.SidewalkHalfWidth;
+	if (!VisibilityCells.IsValidIndex(cellIndex) || !isOnSidewalk)
+	{
+		cellIndex = INDEX_NONE;
+	}
+
+	if (cellIndex == CurrentVisibilityCell)
+		return;
+
+	if (!HasResolvedVisibilityComponents)
+	{
+		HasResolvedVisibilityComponents = true;
+
+		TMap<FName, UPrimitiveComponent*> componentsByName;
+		AActor* buildingActor = IsValid(BuildingChildActor) ? BuildingChildActor->GetChildActor() : nullptr;
+		if (IsValid(buildingActor))
+		{
+			TArray<UPrimitiveComponent*> primitiveComponents;
+			buildingActor->GetComponents<UPrimitiveComponent>(primitiveComponents);
+			for (UPrimitiveComponent* component : primitiveComponents)
+			{
+				componentsByName.Add(component->GetFName(), component);
+			}
+		}
+
+		for (const FName& componentName : VisibilityComponentNames)
+		{
+			UPrimitiveComponent** component = componentsByName.Find(componentName);
+			VisibilityComponents.Add(component ? *component : nullptr);
+		}
+	}
+
+	static const TArray<int32> noHiddenComponents;
+	const TArray<int32>& previousHidden = CurrentVisibilityCell != INDEX_NONE ? VisibilityCells[CurrentVisibilityCell].HiddenComponents : noHiddenComponents;
+	const TArray<int32>& newHidden = cellIndex != INDEX_NONE ? VisibilityCells[cellIndex].HiddenComponents : noHiddenComponents;
+
+	// Hidden in game rather than invisible, so that the detail toggle of the render state keeps its own flag
+	for (int32 componentIndex : previousHidden)
+	{
+		if (Algo::BinarySearch(newHidden, componentIndex) == INDEX_NONE && VisibilityComponents.IsValidIndex(componentIndex) && VisibilityComponents[componentIndex].IsValid())
+		{
+			VisibilityComponents[componentIndex]->SetHiddenInGame(false);
+		}
+	}
+
+	for (int32 componentIndex : newHidden)
+	{
+		if (Algo::BinarySearch(previousHidden, componentIndex) == INDEX_NONE && VisibilityComponents.IsValidIndex(componentIndex) && VisibilityComponents[componentIndex].IsValid())
+		{
+			VisibilityComponents[componentIndex]->SetHiddenInGame(true);
+		}
+	}
+
+	CurrentVisibilityCell = cellIndex;
+}
+
+void AJGChunk::SetupNavTiles()
+{
+#if WITH_RECAST
+	BakedNavTiles = nullptr;
+	BakedNavTileSize = 0.0f;
+
+	UWorld* world = GetWorld();
+#if WITH_EDITOR
+	if (!IsValid(world) && GEditor)
+	{
+		world = GEditor->GetEditorWorldContext().World();
+	}
+#endif
+	UNavigationSystemV1* navSystem = FNavigationSystem::GetCurrent<UNavigationSystemV1>(world);
+	ARecastNavMesh* navMesh = IsValid(navSystem) ? Cast<ARecastNavMesh>(navSystem->GetDefaultNavDataInstance()) : nullptr;
+	ANavMeshBoundsVolume* boundsVolume = IsValid(world) ? Cast<ANavMeshBoundsVolume>(UGameplayStatics::GetActorOfClass(world, ANavMeshBoundsVolume::StaticClass())) : nullptr;
+	const FJGNavTileGrid navTileGrid = FJGNavTileGrid::FromWorld(world);
+	if (!IsValid(navMesh) || !IsValid(boundsVolume) || !navTileGrid.IsValid())
+	{
+		UE_LOG(LogTemp, Warning, TEXT("The nav tile bake needs a level with a Recast navmesh and a NavMeshBoundsVolume"));
+		return;
+	}
+
+	for (int32 variantIndex = 0; variantIndex < Variants.Num(); variantIndex++)
+	{
+		if (DoesVariantChangeGeometry(variantIndex))
+		{
+			UE_LOG(LogTemp, Warning, TEXT("Variant %d swaps or removes components, chunks spawned with it will build their nav tiles at runtime"), variantIndex);
+		}
+	}
+
+	// Lay the chunk and its mirror chunk out like the level generator does, the row on Y = 0 and the chunk on a tile boundary
+	FActorSpawnParameters spawnParams;
+	spawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+	const FVector chunkLocation(navTileGrid.SnapDownX(0.0f), 0.0f, 0.0f);
+	AJGChunk* tempChunk = world->SpawnActor<AJGChunk>(GetClass(), FTransform(chunkLocation), spawnParams);
+	if (!IsValid(tempChunk))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Could not spawn temporary chunk"));
+		return;
+	}
+
+	FVector origin;
+	FVector extent;
+	tempChunk->GetActorBounds(true, origin, extent, true);
+
+	const FTransform mirrorTransform(FRotator(0.0f, 180.0f, 0.0f), chunkLocation + FVector(extent.X * 2.0f, NavBakeMirrorYOffset, 0.0f));
+	AJGChunk* tempMirrorChunk = world->SpawnActor<AJGChunk>(GetClass(), mirrorTransform, spawnParams);
+
+	// The pair owns the tile columns from its location to the next tile boundary, the generator's floor strip fills the padding
+	const float chunkEndX = chunkLocation.X + extent.X * 2.0f;
+	const float pairEndX = navTileGrid.SnapUpX(chunkEndX);
+	AStaticMeshActor* tempPaddingFloor = nullptr;
+	if (pairEndX - chunkEndX > 1.0f)
+	{
+		UStaticMesh* cubeMesh = LoadObject<UStaticMesh>(nullptr, TEXT("/Engine/BasicShapes/Cube.Cube"));
+		tempPaddingFloor = world->SpawnActor<AStaticMeshActor>(AStaticMeshActor::StaticClass(), FTransform(FVector((chunkEndX + pairEndX) * 0.5f, NavBakeMirrorYOffset * 0.5f, -50.0f)), spawnParams);
+		if (IsValid(tempPaddingFloor) && IsValid(cubeMesh))
+		{
+			tempPaddingFloor->GetStaticMeshComponent()->SetStaticMesh(cubeMesh);
+			tempPaddingFloor->SetActorScale3D(FVector((pairEndX - chunkEndX) / 100.0f, FMath::Max(NavBakeMirrorYOffset, 500.0f) / 100.0f, 1.0f));
+		}
+	}
+
+	FBox pairBounds = tempChunk->GetComponentsBoundingBox(true, true);
+	if (IsValid(tempMirrorChunk))
+	{
+		pairBounds += tempMirrorChunk->GetComponentsBoundingBox(true, true);
+	}
+	pairBounds.Min.X = chunkLocation.X;
+	pairBounds.Max.X = pairEndX;
+
+	// Build the pair's tiles only
+	const FTransform previousVolumeTransform = boundsVolume->GetActorTransform();
+	boundsVolume->SetActorLocation(pairBounds.GetCenter());
+	boundsVolume->SetActorScale3D(pairBounds.GetSize() / 200.0f);
+	navSystem->OnNavigationBoundsUpdated(boundsVolume);
+	navSystem->Build();
+
+	// Tiles strictly inside the pair's columns, the neighbouring columns only touch its edges
+	TArray<int32> tileIndices;
+	navMesh->GetNavMeshTilesIn({ pairBounds.ExpandBy(FVector(-1.0f, 0.0f, 0.0f)) }, tileIndices);
+
+	// In a package of its own, so that it survives the Blueprint being recompiled
+	const FString navTilesPackageName = GetClass()->GetOutermost()->GetName() + TEXT("_NavTiles");
+	UPackage* navTilesPackage = CreatePackage(*navTilesPackageName);
+	navTilesPackage->FullyLoad();
+	BakedNavTiles = NewObject<URecastNavMeshDataChunk>(navTilesPackage, *FPackageName::GetShortName(navTilesPackageName), RF_Public | RF_Standalone);
+	BakedNavTiles->NavigationDataName = navMesh->GetFName();
+	BakedNavTiles->GatherTiles(navMesh->GetRecastNavMeshImpl(), tileIndices, EGatherTilesCopyMode::CopyData, false);
+	navTileGrid.GetRecastTile(navMesh, navTileGrid.GetTileCoord(chunkLocation + FVector(navTileGrid.TileSize * 0.5f, 0.0f, 0.0f)), BakedNavTileOrigin);
+	BakedNavTileSize = navTileGrid.TileSize;
+	BakedNavMirrorYOffset = NavBakeMirrorYOffset;
+
+	tempChunk->Destroy();
+	if (IsValid(tempMirrorChunk))
+	{
+		tempMirrorChunk->Destroy();
+	}
+	if (IsValid(tempPaddingFloor))
+	{
+		tempPaddingFloor->Destroy();
+	}
+
+	// Rebuild the level's navmesh over its own bounds, without the temporary pair
+	boundsVolume->SetActorTransform(previousVolumeTransform);
+	navSystem->OnNavigationBoundsUpdated(boundsVolume);
+	navSystem->Build();
+
+#if WITH_EDITOR
+	FAssetRegistryModule::AssetCreated(BakedNavTiles);
+	FSavePackageArgs saveArgs;
+	saveArgs.TopLevelFlags = RF_Public | RF_Standalone;
+	const FString navTilesFilename = FPackageName::LongPackageNameToFilename(navTilesPackageName, FPackageName::GetAssetPackageExtension());
+	if (!UPackage::SavePackage(navTilesPackage, BakedNavTiles, *navTilesFilename, saveArgs))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Could not save the nav tiles package %s"), *navTilesPackageName);
+	}
+#endif
+
+	UE_LOG(LogTemp, Log, TEXT("Baked %d nav tiles of size %.1f"), tileIndices.Num(), BakedNavTileSize);
+#else
+	UE_LOG(LogTemp, Warning, TEXT("The nav tile bake needs Recast"));
+#endif
+}
+
+bool AJGChunk::HasBakedNavTiles(float navTileSize, float mirrorYOffset) const
+{
+	return BakedNavTiles != nullptr && navTileSize > 0.0f && FMath::IsNearlyEqual(BakedNavTileSize, navTileSize)
+		&& FMath::IsNearlyEqual(BakedNavMirrorYOffset, mirrorYOffset) && !DoesVariantChangeGeometry(VariantIndex);
+}
+
+void AJGChunk::DisableNavigationRelevance()
+{
+	// Building components included
+	TArray<UActorComponent*> components;
+	GetComponents(components, true);
+	for (UActorComponent* component : components)
+	{
+		if (IsValid(component) && component->CanEverAffectNavigation())
+		{
+			component->SetCanEverAffectNavigation(false);
+		}
+	}
+}
+
+void AJGChunk::DisableNavigationRelevanceOutside(const FBox& navBounds)
+{
+	// Building components included. X is left out, a component overhanging the end of the pair is still over the sidewalk.
+	TArray<UPrimitiveComponent*> components;
+	GetComponents<UPrimitiveComponent>(components, true);
+	int32 disabledCount = 0;
+	for (UPrimitiveComponent* component : components)
+	{
+		if (!IsValid(component) || !component->CanEverAffectNavigation())
+			continue;
+
+		// Strict comparisons, a facade flush with the edge of the band does not reach into it
+		const FBox bounds = component->Bounds.GetBox();
+		const bool reachesNavBounds = bounds.Max.Y > navBounds.Min.Y && bounds.Min.Y < navBounds.Max.Y
+			&& bounds.Max.Z > navBounds.Min.Z && bounds.Min.Z < navBounds.Max.Z;
+		if (!reachesNavBounds)
+		{
+			component->SetCanEverAffectNavigation(false);
+			disabledCount++;
+		}
+	}
+
+	UE_LOG(LogTemp, Verbose, TEXT("Chunk %d: %d of %d components left out of navigation"), ChunkLogicalIndex, disabledCount, components.Num());
+}
+
+int32 AJGChunk::PickRandomVariant(const FRandomStream& randomStream) const
+{
+	float totalChance = 0.0f;
+	for (const FJGChunkVariant& variant : Variants)
+	{
+		totalChance += FMath::Max(0.0f, variant.Chance);
+	}
+
+	if (totalChance <= 0.0f)
+	{
+		return INDEX_NONE;
+	}
+
+	float roll = randomStream.FRandRange(0.0f, totalChance);
+	for (int32 variantIndex = 0; variantIndex < Variants.Num(); variantIndex++)
+	{
+		const float chance = FMath::Max(0.0f, Variants[variantIndex].Chance);
+		if (chance > 0.0f && roll <= chance)
+		{
+			return variantIndex;
+		}
+		roll -= chance;
+	}
+
+	// Fallback: last variant with a chance if rounding errors prevented selection
+	return Variants.FindLastByPredicate([](const FJGChunkVariant& variant) { return variant.Chance > 0.0f; });
+}
+
+void AJGChunk::ApplyVariant(int32 variantIndex)
+{
+	if (!Variants.IsValidIndex(variantIndex))
+	{
+		return;
+	}
+
+	VariantIndex = variantIndex;
+	const FJGChunkVariant& variant = Variants[variantIndex];
+
+	TArray<UPrimitiveComponent*> primitiveComponents;
+	GetComponents<UPrimitiveComponent>(primitiveComponents, true);
+
+	for (UPrimitiveComponent* component : primitiveComponents)
+	{
+		if (!IsValid(component) || component->IsA<UShapeComponent>())
+		{
+			continue;
+		}
+
+		const FName componentName = component->GetFName();
+		if (variant.RemovedComponents.Contains(componentName))
+		{
+			component->DestroyComponent();
+			continue;
+		}
+
+		if (UStaticMeshComponent* staticMeshComponent = Cast<UStaticMeshComponent>(component))
+		{
+			const FJGChunkMeshSwap* meshSwap = variant.MeshSwaps.FindByPredicate([componentName](const FJGChunkMeshSwap& swap)
+			{
+				return swap.ComponentName == componentName;
+			});
+
+			if (meshSwap && IsValid(meshSwap->Mesh))
+			{
+				staticMeshComponent->SetStaticMesh(meshSwap->Mesh);
+			}
+		}
+
+		for (int32 dataIndex = 0; dataIndex < variant.CustomPrimitiveData.Num(); dataIndex++)
+		{
+			component->SetCustomPrimitiveDataFloat(dataIndex, variant.CustomPrimitiveData[dataIndex]);
+		}
+	}
+}
+
+bool AJGChunk::DoesVariantChangeGeometry(int32 variantIndex) const
+{
+	if (!Variants.IsValidIndex(variantIndex))
+	{
+		return false;
+	}
+
+	const FJGChunkVariant& variant = Variants[variantIndex];
+	return variant.MeshSwaps.Num() > 0 || variant.RemovedComponents.Num() > 0;
+}
+
+void AJGChunk::DisableLocalFloor(float navMinX, float navMaxX)
+{
+	if (!IsValid(FloorParent))
+		return;
+
+	// The mirror chunk is rotated, so the span is converted back to the chunk's local X
+	const float localStartX = GetActorTransform().InverseTransformPosition(FVector(navMinX, 0.0f, 0.0f)).X;
+	const float localEndX = GetActorTransform().InverseTransformPosition(FVector(navMaxX, 0.0f, 0.0f)).X;
+	const float localMinX = FMath::Min(localStartX, localEndX);
+	const float localMaxX = FMath::Max(localStartX, localEndX);
+
+	FVector floorLocation = FloorParent->GetRelativeLocation();
+	FVector floorScale = FloorParent->GetRelativeScale3D();
+	floorLocation.X = (localMinX + localMaxX) * 0.5f;
+	floorScale.X = (localMaxX - localMinX) / 100.0f;
+	FloorParent->SetRelativeLocationAndRotation(floorLocation, FRotator::ZeroRotator);
+	FloorParent->SetRelativeScale3D(floorScale);
+
+	// Static per chunk, so a window change only dirties the tiles of the chunks it adds or removes, unlike the resized strip
+	TArray<USceneComponent*> floorComponents;
+	FloorParent->GetChildrenComponents(true, floorComponents);
+	for (USceneComponent* floorComponent : floorComponents)
+	{
+		UPrimitiveComponent* floorPrimitive = Cast<UPrimitiveComponent>(floorComponent);
+		if (!IsValid(floorPrimitive))
+			continue;
+
+		floorPrimitive->SetVisibility(false);
+		floorPrimitive->SetCustomNavigableGeometry(EHasCustomNavigableGeometry::EvenIfNotCollidable);
+		floorPrimitive->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+		FNavigationSystem::UpdateComponentData(*floorPrimitive);
+	}
+}
+
+UMaterialInterface* AJGChunk::GetFloorMaterial() const
+{
+	if (!IsValid(FloorParent))
+		return nullptr;
+
+	TArray<USceneComponent*> floorComponents;
+	FloorParent->GetChildrenComponents(true, floorComponents);
+	for (USceneComponent* floorComponent : floorComponents)
+	{
+		UStaticMeshComponent* floorMesh = Cast<UStaticMeshComponent>(floorComponent);
+		if (IsValid(floorMesh) && floorMesh->GetNumMaterials() > 0)
+		{
+			return floorMesh->GetMaterial(0);
+		}
+	}
+
+	return nullptr;
+}
+
+const FBox& AJGChunk::GetChunkBounds()
+{
+	if (!CachedChunkBounds.IsValid)
+	{
+		CachedChunkBounds = GetComponentsBoundingBox(true, true);
+	}
+
+	return CachedChunkBounds;
+}
+
+int64 AJGChunk::EstimateAssetMemory() const
+{
+	UWorld* world = GetWorld();
+	if (!IsValid(world))
+	{
+		return 0;
+	}
+
+	// Assets shared between components are only counted once
+	TSet<UObject*> assets;
+	TArray<UStaticMeshComponent*> meshComponents;
+	GetComponents<UStaticMeshComponent>(meshComponents, true);
+	for (UStaticMeshComponent* meshComponent : meshComponents)
+	{
+		if (!IsValid(meshComponent) || !IsValid(meshComponent->GetStaticMesh()))
+		{
+			continue;
+		}
+
+		assets.Add(meshComponent->GetStaticMesh());
+
+		for (int32 materialIndex = 0; materialIndex < meshComponent->GetNumMaterials(); materialIndex++)
+		{
+			UMaterialInterface* material = meshComponent->GetMaterial(materialIndex);
+			if (!IsValid(material))
+			{
+				continue;
+			}
+
+			assets.Add(material);
+
+			TArray<UTexture*> textures;
+			material->GetUsedTextures(textures, EMaterialQualityLevel::Num, true, world->GetFeatureLevel(), false);
+			for (UTexture* texture : textures)
+			{
+				if (IsValid(texture))
+				{
+					assets.Add(texture);
+				}
+			}
+		}
+	}
+
+	int64 totalBytes = 0;
+	for (UObject* asset : assets)
+	{
+		totalBytes += asset->GetResourceSizeBytes(EResourceSizeMode::EstimatedTotal);
+	}
+
+	return totalBytes;
+}
+
+void AJGChunk::DeferBuilding()
+{
+	if (!IsValid(BuildingChildActor) || BuildingChildActor->IsRegistered())
+		return;
+
+	BuildingChildActor->bAutoRegister = false;
+	IsBuildingDeferred = true;
+}
+
+void AJGChunk::FinishDeferredBuilding()
+{
+	if (!IsBuildingDeferred)
+		return;
+
+	IsBuildingDeferred = false;
+	CreateBuilding();
+	ApplyVariant(VariantIndex);
+
+	// Bounds read before the building existed are missing it
+	CachedChunkBounds = FBox(ForceInit);
+}
+
+bool AJGChunk::IsCollisionReady() const
+{
+	if (IsBuildingDeferred)
+		return false;
+
+	AActor* buildingActor = IsValid(BuildingChildActor) ? BuildingChildActor->GetChildActor() : nullptr;
+	if (!IsValid(buildingActor))
+	{
+		// Nothing to wait for when the chunk has no building class
+		return !IsValid(BuildingChildActor) || !BuildingChildActor->GetChildActorClass();
+	}
+
+	TArray<UPrimitiveComponent*> buildingComponents;
+	buildingActor->GetComponents(buildingComponents);
+	for (const UPrimitiveComponent* component : buildingComponents)
+	{
+		if (component->IsCollisionEnabled() && !component->IsPhysicsStateCreated())
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void AJGChunk::GetClassStaticMeshes(UClass* chunkClass, TArray<UStaticMesh*>& outMeshes)
+{
+	auto gatherClassMeshes = [&outMeshes](UClass* actorClass)
+	{
+		if (!IsValid(actorClass))
+			return;
+
+		// Native components live on the class default object
+		TArray<UStaticMeshComponent*> meshComponents;
+		actorClass->GetDefaultObject<AActor>()->GetComponents<UStaticMeshComponent>(meshComponents);
+
+		// Blueprint components are templates of the construction scripts of the class hierarchy
+		for (UBlueprintGeneratedClass* blueprintClass = Cast<UBlueprintGeneratedClass>(actorClass); blueprintClass; blueprintClass = Cast<UBlueprintGeneratedClass>(blueprintClass->GetSuperClass()))
+		{
+			if (!blueprintClass->SimpleConstructionScript)
+				continue;
+
+			for (USCS_Node* node : blueprintClass->SimpleConstructionScript->GetAllNodes())
+			{
+				if (UStaticMeshComponent* meshTemplate = node ? Cast<UStaticMeshComponent>(node->ComponentTemplate) : nullptr)
+				{
+					meshComponents.Add(meshTemplate);
+				}
+			}
+		}
+
+		for (UStaticMeshComponent* meshComponent : meshComponents)
+		{
+			if (IsValid(meshComponent) && IsValid(meshComponent->GetStaticMesh()))
+			{
+				outMeshes.AddUnique(meshComponent->GetStaticMesh());
+			}
+		}
+	};
+
+	gatherClassMeshes(chunkClass);
+
+	const AJGChunk* chunkDefaults = IsValid(chunkClass) ? Cast<AJGChunk>(chunkClass->GetDefaultObject()) : nullptr;
+	if (chunkDefaults && IsValid(chunkDefaults->BuildingChildActor))
+	{
+		gatherClassMeshes(chunkDefaults->BuildingChildActor->GetChildActorClass());
+	}
+}
+
+void AJGChunk::CacheRenderComponents(FName detailComponentTag, float detailMaxRadius)
+{
+	HasCachedRenderComponents = true;
+
+	// Chunk components plus the ones of the building child actor
+	TArray<UPrimitiveComponent*> primitiveComponents;
+	GetComponents<UPrimitiveComponent>(primitiveComponents, true);
+
+	for (UPrimitiveComponent* component : primitiveComponents)
+	{
+		// Trigger and wall boxes are not rendered
+		if (!IsValid(component) || component->IsA<UShapeComponent>())
+		{
+			continue;
+		}
+
+		if (component->CastShadow)
+		{
+			ShadowComponents.Add(component);
+		}
+
+		const bool isTaggedDetail = !detailComponentTag.IsNone() && component->ComponentHasTag(detailComponentTag);
+		const bool isSmallProp = detailMaxRadius > 0.0f && component->Bounds.SphereRadius <= detailMaxRadius;
+		if ((isTaggedDetail || isSmallProp) && component->IsVisible())
+		{
+			DetailComponents.Add(component);
+		}
+	}
+
+	AActor* buildingActor = IsValid(BuildingChildActor) ? BuildingChildActor->GetChildActor() : nullptr;
+	if (IsValid(buildingActor))
+	{
+		if (buildingActor->IsActorTickEnabled())
+		{
+			TickingActors.Add(buildingActor);
+		}
+
+		TArray<UActorComponent*> buildingComponents;
+		buildingActor->GetComponents(buildingComponents);
+		for (UActorComponent* component : buildingComponents)
+		{
+			if (IsValid(component) && component->IsComponentTickEnabled())
+			{
+				TickingComponents.Add(component);
+			}
+		}
+	}
+}
+
+void AJGChunk::ApplyRenderState(const FJGChunkRenderState& renderState, FName detailComponentTag, float detailMaxRadius)
+{
+	if (!HasCachedRenderComponents)
+	{
+		CacheRenderComponents(detailComponentTag, detailMaxRadius);
+	}
+
+	if (renderState.CastShadows != RenderState.CastShadows)
+	{
+		for (const TWeakObjectPtr<UPrimitiveComponent>& component : ShadowComponents)
+		{
+			if (component.IsValid())
+			{
+				component->SetCastShadow(renderState.CastShadows);
+			}
+		}
+	}
+
+	if (renderState.ShowDetails != RenderState.ShowDetails)
+	{
+		for (const TWeakObjectPtr<UPrimitiveComponent>& component : DetailComponents)
+		{
+			if (component.IsValid())
+			{
+				component->SetVisibility(renderState.ShowDetails);
+			}
+		}
+	}
+
+	if (renderState.TickEnabled != RenderState.TickEnabled)
+	{
+		for (const TWeakObjectPtr<AActor>& actor : TickingActors)
+		{
+			if (actor.IsValid())
+			{
+				actor->SetActorTickEnabled(renderState.TickEnabled);
+			}
+		}
+
+		for (const TWeakObjectPtr<UActorComponent>& component : TickingComponents)
+		{
+			if (component.IsValid())
+			{
+				component->SetComponentTickEnabled(renderState.TickEnabled);
+			}
+		}
+	}
+
+	RenderState = renderState;
+}
+
+void AJGChunk::ApplyCullDistances(const FJGCullDistanceSettings& settings, float sidewalkCenterY, float scale)
+{
+	if (AuthoredCullDistances.Num() == 0)
+	{
+		TArray<UPrimitiveComponent*> primitiveComponents;
+		GetComponents<UPrimitiveComponent>(primitiveComponents, true);
+
+		for (UPrimitiveComponent* component : primitiveComponents)
+		{
+			if (IsValid(component) && !component->IsA<UShapeComponent>())
+			{
+				AuthoredCullDistances.Add(component, component->LDMaxDrawDistance);
+			}
+		}
+	}
+
+	for (const TPair<TWeakObjectPtr<UPrimitiveComponent>, float>& entry : AuthoredCullDistances)
+	{
+		UPrimitiveComponent* component = entry.Key.Get();
+		if (!IsValid(component))
+		{
+			continue;
+		}
+
+		const float authoredDistance = entry.Value;
+		const FBoxSphereBounds& bounds = component->Bounds;
+		if (scale <= 0.0f || bounds.SphereRadius >= settings.NeverCullRadius)
+		{
+			component->SetCullDistance(authoredDistance);
+			continue;
+		}
+
+		// Props far from the sidewalk line need to be further away to be seen at the same angle, so they keep a longer distance
+		const float lateralDistance = FMath::Abs(bounds.Origin.Y - sidewalkCenterY);
+		float cullDistance = (bounds.SphereRadius * settings.DistancePerRadius + lateralDistance) * scale;
+		cullDistance = FMath::Clamp(cullDistance, settings.MinDistance, settings.MaxDistance);
+
+		// A hand-tuned distance shorter than ours wins
+		if (authoredDistance > 0.0f)
+		{
+			cullDistance = FMath::Min(cullDistance, authoredDistance);
+		}
+
+		component->SetCullDistance(cullDistance);
+	}
+}
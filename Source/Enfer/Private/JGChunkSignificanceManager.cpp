@@ -0,0 +1,133 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Public/JGChunkSignificanceManager.h"
+#include "Public/JGLevelGenerator.h"
+#include "Camera/PlayerCameraManager.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+
+UJGChunkSignificanceManager::UJGChunkSignificanceManager()
+{
+	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.TickGroup = TG_PostUpdateWork;
+	LevelGenerator = nullptr;
+
+	SignificanceDistance = 12000.0f;
+	BehindCameraDot = -0.2f;
+	BehindCameraScale = 0.25f;
+	ShadowThreshold = 0.5f;
+	DetailThreshold = 0.35f;
+	TickThreshold = 0.2f;
+	DetailComponentTag = TEXT("Detail");
+	DetailMaxRadius = 150.0f;
+	ChunksPerBatch = 4;
+	UseVisibilitySets = true;
+}
+
+void UJGChunkSignificanceManager::BeginPlay()
+{
+	Super::BeginPlay();
+
+	LevelGenerator = GetOwner()->FindComponentByClass<UJGLevelGenerator>();
+	if (!IsValid(LevelGenerator))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("JGChunkSignificanceManager: Could not find level generator component!"));
+		SetComponentTickEnabled(false);
+	}
+}
+
+void UJGChunkSignificanceManager::TickComponent(float deltaTime, ELevelTick tickType, FActorComponentTickFunction* thisTickFunction)
+{
+	Super::TickComponent(deltaTime, tickType, thisTickFunction);
+
+	APlayerController* playerController = GetWorld()->GetFirstPlayerController();
+	if (!IsValid(LevelGenerator) || !IsValid(playerController) || !IsValid(playerController->PlayerCameraManager))
+	{
+		return;
+	}
+
+	const FVector cameraLocation = playerController->PlayerCameraManager->GetCameraLocation();
+	const FVector cameraForward = playerController->PlayerCameraManager->GetCameraRotation().Vector();
+
+	// Score every chunk, keeping only the ones whose render state has to change
+	PendingRenderStates.Reset();
+	for (const FChunkData& chunkData : LevelGenerator->GetActiveChunks())
+	{
+		EvaluateChunk(chunkData.ChunkActor, cameraLocation, cameraForward);
+		EvaluateChunk(chunkData.MirrorChunkActor, cameraLocation, cameraForward);
+	}
+
+	// Most significant chunks first so that what the player looks at is restored before anything else
+	PendingRenderStates.Sort([](const FPendingRenderState& a, const FPendingRenderState& b)
+	{
+		return a.Significance > b.Significance;
+	});
+
+	const int32 numToApply = FMath::Min(ChunksPerBatch, PendingRenderStates.Num());
+	for (int32 i = 0; i < numToApply; i++)
+	{
+		if (AJGChunk* chunk = PendingRenderStates[i].Chunk.Get())
+		{
+			chunk->ApplyRenderState(PendingRenderStates[i].RenderState, DetailComponentTag, DetailMaxRadius);
+		}
+	}
+}
+
+void UJGChunkSignificanceManager::EvaluateChunk(AJGChunk* chunk, const FVector& cameraLocation, const FVector& cameraForward)
+{
+	// Chunks waiting for their building would cache their render components without it
+	if (!IsValid(chunk) || !chunk->IsCollisionReady())
+	{
+		return;
+	}
+
+	if (UseVisibilitySets)
+	{
+		chunk->UpdateVisibilityCell(cameraLocation);
+	}
+
+	const float significance = ComputeSignificance(chunk, cameraLocation, cameraForward);
+	const FJGChunkRenderState renderState = GetRenderStateForSignificance(significance);
+	if (renderState != chunk->GetRenderState())
+	{
+		PendingRenderStates.Add({ chunk, renderState, significance });
+	}
+}
+
+float UJGChunkSignificanceManager::ComputeSignificance(AJGChunk* chunk, const FVector& cameraLocation, const FVector& cameraForward) const
+{
+	if (!IsValid(chunk))
+	{
+		return 0.0f;
+	}
+
+	const FBox& chunkBounds = chunk->GetChunkBounds();
+	if (!chunkBounds.IsValid || chunkBounds.IsInside(cameraLocation))
+	{
+		return 1.0f;
+	}
+
+	// Distance to the closest point of the chunk, so that long chunks are not penalized by their center
+	const FVector closestPoint = chunkBounds.GetClosestPointTo(cameraLocation);
+	const float distance = FVector::Dist(cameraLocation, closestPoint);
+	float significance = FMath::Clamp(1.0f - distance / SignificanceDistance, 0.0f, 1.0f);
+
+	// Facing is evaluated in 2D, the corridor is flat and the camera pitch should not matter
+	const FVector2D toChunk2D = FVector2D(closestPoint - cameraLocation).GetSafeNormal();
+	const FVector2D forward2D = FVector2D(cameraForward).GetSafeNormal();
+	if (FVector2D::DotProduct(toChunk2D, forward2D) < BehindCameraDot)
+	{
+		significance *= BehindCameraScale;
+	}
+
+	return significance;
+}
+
+FJGChunkRenderState UJGChunkSignificanceManager::GetRenderStateForSignificance(float significance) const
+{
+	FJGChunkRenderState renderState;
+	renderState.CastShadows = significance >= ShadowThreshold;
+	renderState.ShowDetails = significance >= DetailThreshold;
+	renderState.TickEnabled = significance >= TickThreshold;
+	return renderState;
+}
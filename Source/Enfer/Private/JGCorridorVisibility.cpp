@@ -0,0 +1,135 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Public/JGCorridorVisibility.h"
+
+void FJGCorridorVisibility::ComputeCells(TConstArrayView<FJGVisibilityComponent> components, float minX, float maxX, const FJGVisibilityBakeSettings& settings, TArray<FJGVisibilityCell>& outCells)
+{
+	outCells.Reset();
+
+	const float cellSize = FMath::Max(settings.CellSize, 10.0f);
+	const int32 numCells = FMath::Max(1, FMath::CeilToInt((maxX - minX) / cellSize));
+	outCells.SetNum(numCells);
+
+	for (int32 cellIndex = 0; cellIndex < numCells; cellIndex++)
+	{
+		const float cellMinX = minX + cellIndex * cellSize;
+		const float cellMaxX = cellMinX + cellSize;
+
+		for (int32 componentIndex = 0; componentIndex < components.Num(); componentIndex++)
+		{
+			if (!IsVisibleFromCell(components, componentIndex, cellMinX, cellMaxX, settings))
+			{
+				outCells[cellIndex].HiddenComponents.Add(componentIndex);
+			}
+		}
+	}
+}
+
+bool FJGCorridorVisibility::IsVisibleFromCell(TConstArrayView<FJGVisibilityComponent> components, int32 componentIndex, float cellMinX, float cellMaxX, const FJGVisibilityBakeSettings& settings)
+{
+	const FBox& targetBounds = components[componentIndex].Bounds;
+	if (!targetBounds.IsValid)
+	{
+		return true;
+	}
+
+	const FBox cameraBox = GetCameraBox(cellMinX, cellMaxX, settings);
+
+	// A camera standing in the target sees it
+	if (cameraBox.Intersect(targetBounds))
+	{
+		return true;
+	}
+
+	for (int32 i = 0; i < components.Num(); i++)
+	{
+		if (i == componentIndex || !components[i].IsOccluder || !components[i].Bounds.IsValid)
+		{
+			continue;
+		}
+
+		// Shrunk, since a mesh rarely fills its bounding box
+		const FBox occluder = components[i].Bounds.ExpandBy(-settings.OccluderShrink);
+		if (occluder.Min.X < occluder.Max.X && occluder.Min.Y < occluder.Max.Y && occluder.Min.Z < occluder.Max.Z
+			&& IsBoxHiddenBy(cameraBox, targetBounds, occluder))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool FJGCorridorVisibility::IsBoxHiddenBy(const FBox& cameraBox, const FBox& targetBounds, const FBox& occluder)
+{
+	// Look for a plane through the occluder with the camera box strictly on one side and the target strictly on the other:
+	// every segment crosses it, and is hidden if the occluder covers everywhere the segments can cross it
+	for (int32 axis = 0; axis < 3; axis++)
+	{
+		const double planes[] = { occluder.Min[axis], (occluder.Min[axis] + occluder.Max[axis]) * 0.5, occluder.Max[axis] };
+		for (const double plane : planes)
+		{
+			const bool isTargetAfter = cameraBox.Max[axis] < plane && plane < targetBounds.Min[axis];
+			const bool isTargetBefore = targetBounds.Max[axis] < plane && plane < cameraBox.Min[axis];
+			if (!isTargetAfter && !isTargetBefore)
+			{
+				continue;
+			}
+
+			// Fraction of the way from the camera to the target at which the segments cross the plane, extreme at the box faces
+			double minAlpha = 1.0;
+			double maxAlpha = 0.0;
+			for (const double cameraCoord : { cameraBox.Min[axis], cameraBox.Max[axis] })
+			{
+				for (const double targetCoord : { targetBounds.Min[axis], targetBounds.Max[axis] })
+				{
+					const double alpha = (plane - cameraCoord) / (targetCoord - cameraCoord);
+					minAlpha = FMath::Min(minAlpha, alpha);
+					maxAlpha = FMath::Max(maxAlpha, alpha);
+				}
+			}
+
+			bool coversCrossings = true;
+			for (int32 otherAxis = 0; otherAxis < 3 && coversCrossings; otherAxis++)
+			{
+				if (otherAxis == axis)
+				{
+					continue;
+				}
+
+				const double crossingMin = FMath::Min(
+					FMath::Lerp(cameraBox.Min[otherAxis], targetBounds.Min[otherAxis], minAlpha),
+					FMath::Lerp(cameraBox.Min[otherAxis], targetBounds.Min[otherAxis], maxAlpha));
+				const double crossingMax = FMath::Max(
+					FMath::Lerp(cameraBox.Max[otherAxis], targetBounds.Max[otherAxis], minAlpha),
+					FMath::Lerp(cameraBox.Max[otherAxis], targetBounds.Max[otherAxis], maxAlpha));
+				coversCrossings = occluder.Min[otherAxis] <= crossingMin && crossingMax <= occluder.Max[otherAxis];
+			}
+
+			if (coversCrossings)
+			{
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+bool FJGCorridorVisibility::IsOccluderSize(const FBox& bounds, const FJGVisibilityBakeSettings& settings)
+{
+	if (!bounds.IsValid)
+	{
+		return false;
+	}
+
+	const FVector size = bounds.GetSize();
+	return size.Z >= settings.OccluderMinSize && FMath::Max(size.X, size.Y) >= settings.OccluderMinSize;
+}
+
+FBox FJGCorridorVisibility::GetCameraBox(float cellMinX, float cellMaxX, const FJGVisibilityBakeSettings& settings)
+{
+	return FBox(
+		FVector(cellMinX, settings.SidewalkY - settings.SidewalkHalfWidth, settings.EyeHeight - settings.EyeHeightRange),
+		FVector(cellMaxX, settings.SidewalkY + settings.SidewalkHalfWidth, settings.EyeHeight + settings.EyeHeightRange));
+}
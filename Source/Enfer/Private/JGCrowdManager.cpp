@@ -0,0 +1,317 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Public/JGCrowdManager.h"
+#include "Public/JGLevelGenerator.h"
+#include "Public/JGNPCPool.h"
+#include "Components/InstancedStaticMeshComponent.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/World.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "GameFramework/GameModeBase.h"
+#include "MassEntitySubsystem.h"
+#include "JGNPC.h"
+
+UJGCrowdManager::UJGCrowdManager()
+{
+	PrimaryComponentTick.bCanEverTick = false;
+	LevelGenerator = nullptr;
+	EntitySubsystem = nullptr;
+	NPCPool = nullptr;
+
+	AgentsPerChunk = 12.0f;
+	MaxAgents = 600;
+	MinWalkSpeed = 90.0f;
+	MaxWalkSpeed = 160.0f;
+	CastInstanceShadows = false;
+	VisibleDistance = 10000.0f;
+	PromoteDistance = 1500.0f;
+	DemoteDistance = 2000.0f;
+	MaxPromotedAgents = 8;
+	PromotedLookAhead = 100.0f;
+}
+
+UJGCrowdManager* UJGCrowdManager::Get(const UWorld* world)
+{
+	const AGameModeBase* gameMode = world ? world->GetAuthGameMode() : nullptr;
+	return gameMode ? gameMode->FindComponentByClass<UJGCrowdManager>() : nullptr;
+}
+
+void UJGCrowdManager::BeginPlay()
+{
+	Super::BeginPlay();
+
+	EntitySubsystem = GetWorld()->GetSubsystem<UMassEntitySubsystem>();
+	if (!IsValid(EntitySubsystem))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("JGCrowdManager: Mass entity subsystem not found, the crowd is disabled"));
+		return;
+	}
+
+	LevelGenerator = GetOwner()->FindComponentByClass<UJGLevelGenerator>();
+	if (!IsValid(LevelGenerator))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("JGCrowdManager: Could not find level generator component!"));
+		return;
+	}
+
+	FMassEntityManager& entityManager = EntitySubsystem->GetMutableEntityManager();
+	AgentArchetype = entityManager.CreateArchetype({ FJGCrowdAgentFragment::StaticStruct(), FJGCrowdRepresentationFragment::StaticStruct() });
+
+	CreateInstanceComponents();
+
+	NPCPool = GetOwner()->FindComponentByClass<UJGNPCPool>();
+	if (CrowdActorClass && IsValid(NPCPool))
+	{
+		// The crowd moves its actors through movement input, a possessing controller would run their behavior tree
+		NPCPool->SetControllerless(CrowdActorClass);
+		NPCPool->Prewarm(CrowdActorClass, MaxPromotedAgents);
+	}
+	else if (CrowdActorClass)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("JGCrowdManager: Could not find NPC pool component, agents will not be promoted"));
+	}
+
+	LevelGenerator->OnChunkWindowChanged().AddUObject(this, &UJGCrowdManager::OnChunkWindowChanged);
+
+	// Chunks spawned before we bound
+	for (const FChunkData& chunkData : LevelGenerator->GetActiveChunks())
+	{
+		if (chunkData.IsValid())
+		{
+			SpawnAgentsInChunk(chunkData.ChunkActor->ChunkLogicalIndex);
+		}
+	}
+}
+
+void UJGCrowdManager::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (IsValid(LevelGenerator))
+	{
+		LevelGenerator->OnChunkWindowChanged().RemoveAll(this);
+	}
+
+	// The entities go with the world's entity manager
+	for (const TPair<FMassEntityHandle, TWeakObjectPtr<AJGNPC>>& promotedActor : PromotedActors)
+	{
+		if (promotedActor.Value.IsValid() && IsValid(NPCPool))
+		{
+			NPCPool->Release(promotedActor.Value.Get());
+		}
+	}
+	PromotedActors.Reset();
+
+	if (Stats.TotalSpawned > 0)
+	{
+		UE_LOG(LogTemp, Log, TEXT("JGCrowdManager: %d agents spawned, %d live at the end, %d promotions"),
+			Stats.TotalSpawned, Stats.AgentCount, Stats.TotalPromotions);
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void UJGCrowdManager::CreateInstanceComponents()
+{
+	AActor* owner = GetOwner();
+	for (UStaticMesh* crowdMesh : CrowdMeshes)
+	{
+		UInstancedStaticMeshComponent* instanceComponent = nullptr;
+		if (IsValid(crowdMesh))
+		{
+			instanceComponent = NewObject<UInstancedStaticMeshComponent>(owner);
+			instanceComponent->SetMobility(EComponentMobility::Movable);
+			instanceComponent->SetUsingAbsoluteLocation(true);
+			instanceComponent->SetUsingAbsoluteRotation(true);
+			instanceComponent->SetUsingAbsoluteScale(true);
+			instanceComponent->SetStaticMesh(crowdMesh);
+			instanceComponent->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+			instanceComponent->SetCanEverAffectNavigation(false);
+			instanceComponent->SetCastShadow(CastInstanceShadows);
+			instanceComponent->RegisterComponent();
+		}
+
+		// Kept for invalid meshes too, agents index them by mesh
+		InstanceComponents.Add(instanceComponent);
+	}
+
+	InstanceTransforms.SetNum(InstanceComponents.Num());
+}
+
+void UJGCrowdManager::OnChunkWindowChanged(const FJGChunkWindowChange& windowChange)
+{
+	// Agents of removed chunks are destroyed by the lane follow processor, their lane is gone
+	for (const FJGChunkWindowEntry& addedEntry : windowChange.AddedChunks)
+	{
+		SpawnAgentsInChunk(addedEntry.LogicalIndex);
+	}
+}
+
+void UJGCrowdManager::SpawnAgentsInChunk(int32 chunkIndex)
+{
+	if (!IsValid(EntitySubsystem) || !AgentArchetype.IsValid())
+	{
+		return;
+	}
+
+	// Fractional densities spawn the extra agent in that fraction of the chunks
+	const int32 wantedCount = FMath::FloorToInt(AgentsPerChunk) + (FMath::FRand() < FMath::Frac(AgentsPerChunk) ? 1 : 0);
+	const int32 agentCount = FMath::Min(wantedCount, MaxAgents - Stats.AgentCount);
+	if (agentCount <= 0)
+	{
+		return;
+	}
+
+	// The chunk may have no walkable interval at all
+	const FJGSidewalkLane& lane = LevelGenerator->GetSidewalkLane();
+	FVector firstLocation;
+	if (!lane.FindRandomPointInChunk(chunkIndex, firstLocation))
+	{
+		return;
+	}
+
+	FMassEntityManager& entityManager = EntitySubsystem->GetMutableEntityManager();
+	TArray<FMassEntityHandle> entities;
+	entityManager.BatchCreateEntities(AgentArchetype, agentCount, entities);
+
+	for (const FMassEntityHandle& entity : entities)
+	{
+		FJGCrowdAgentFragment& agent = entityManager.GetFragmentDataChecked<FJGCrowdAgentFragment>(entity);
+		lane.FindRandomPointInChunk(chunkIndex, agent.Location);
+		agent.Direction = FMath::RandBool() ? 1.0f : -1.0f;
+		agent.Speed = FMath::FRandRange(MinWalkSpeed, FMath::Max(MinWalkSpeed, MaxWalkSpeed));
+		agent.VisualIndex = InstanceComponents.Num() > 0 ? FMath::RandRange(0, InstanceComponents.Num() - 1) : INDEX_NONE;
+	}
+
+	Stats.AgentCount += entities.Num();
+	Stats.TotalSpawned += entities.Num();
+}
+
+void UJGCrowdManager::BeginRepresentation()
+{
+	for (TArray<FTransform>& transforms : InstanceTransforms)
+	{
+		transforms.Reset();
+	}
+
+	Stats.ActorCount = 0;
+	Stats.InstancedCount = 0;
+	Stats.HiddenCount = 0;
+
+	// Agents destroyed without being demoted would hold their actor and promotion slot for good
+	const FMassEntityManager* entityManager = IsValid(EntitySubsystem) ? &EntitySubsystem->GetEntityManager() : nullptr;
+	for (auto it = PromotedActors.CreateIterator(); it; ++it)
+	{
+		if (entityManager && entityManager->IsEntityValid(it.Key()))
+		{
+			continue;
+		}
+
+		if (it.Value().IsValid() && IsValid(NPCPool))
+		{
+			NPCPool->Release(it.Value().Get());
+		}
+		it.RemoveCurrent();
+	}
+}
+
+void UJGCrowdManager::AddInstance(const FJGCrowdAgentFragment& agent)
+{
+	if (InstanceTransforms.IsValidIndex(agent.VisualIndex))
+	{
+		const FRotator rotation(0.0f, agent.Direction > 0.0f ? 0.0f : 180.0f, 0.0f);
+		InstanceTransforms[agent.VisualIndex].Add(FTransform(rotation, agent.Location));
+	}
+}
+
+void UJGCrowdManager::CountAgent(EJGCrowdLOD lod)
+{
+	switch (lod)
+	{
+	case EJGCrowdLOD::Actor:
+		Stats.ActorCount++;
+		break;
+	case EJGCrowdLOD::Instanced:
+		Stats.InstancedCount++;
+		break;
+	case EJGCrowdLOD::Hidden:
+		Stats.HiddenCount++;
+		break;
+	}
+}
+
+void UJGCrowdManager::EndRepresentation()
+{
+	for (int32 meshIndex = 0; meshIndex < InstanceComponents.Num(); meshIndex++)
+	{
+		UInstancedStaticMeshComponent* instanceComponent = InstanceComponents[meshIndex];
+		if (!IsValid(instanceComponent))
+		{
+			continue;
+		}
+
+		// The instances are reused in place, they are only rebuilt when the visible count changes
+		const TArray<FTransform>& transforms = InstanceTransforms[meshIndex];
+		if (instanceComponent->GetInstanceCount() != transforms.Num())
+		{
+			instanceComponent->ClearInstances();
+			instanceComponent->AddInstances(transforms, false, true, false);
+		}
+		else if (transforms.Num() > 0)
+		{
+			instanceComponent->BatchUpdateInstancesTransforms(0, transforms, true, true);
+		}
+	}
+}
+
+AJGNPC* UJGCrowdManager::PromoteAgent(const FMassEntityHandle& entity, const FJGCrowdAgentFragment& agent)
+{
+	if (!CrowdActorClass || !IsValid(NPCPool) || PromotedActors.Num() >= MaxPromotedAgents)
+	{
+		return nullptr;
+	}
+
+	AJGNPC* actor = NPCPool->Acquire(CrowdActorClass, agent.Location, FRotator(0.0f, agent.Direction > 0.0f ? 0.0f : 180.0f, 0.0f));
+	if (!actor)
+	{
+		return nullptr;
+	}
+
+	// Crowd actors keep walking the lane through movement input, with or without a controller
+	actor->MovementDirection = FVector(agent.Direction, 0.0f, 0.0f);
+
+	UCharacterMovementComponent* characterMovement = actor->GetCharacterMovement();
+	characterMovement->bRunPhysicsWithNoController = true;
+	characterMovement->bOrientRotationToMovement = true;
+	characterMovement->MaxWalkSpeed = agent.Speed;
+
+	PromotedActors.Add(entity, actor);
+	Stats.TotalPromotions++;
+	return actor;
+}
+
+void UJGCrowdManager::DemoteAgent(const FMassEntityHandle& entity, FJGCrowdAgentFragment& agent)
+{
+	TWeakObjectPtr<AJGNPC> actor;
+	if (!PromotedActors.RemoveAndCopyValue(entity, actor) || !actor.IsValid())
+	{
+		return;
+	}
+
+	// The lane follow processor puts it back on the ground
+	agent.Location.X = actor->GetActorLocation().X;
+	agent.Location.Y = actor->GetActorLocation().Y;
+	if (IsValid(NPCPool))
+	{
+		NPCPool->Release(actor.Get());
+	}
+}
+
+AJGNPC* UJGCrowdManager::GetPromotedActor(const FMassEntityHandle& entity) const
+{
+	const TWeakObjectPtr<AJGNPC>* actor = PromotedActors.Find(entity);
+	return actor ? actor->Get() : nullptr;
+}
+
+void UJGCrowdManager::NotifyAgentsDestroyed(int32 count)
+{
+	Stats.AgentCount = FMath::Max(0, Stats.AgentCount - count);
+}
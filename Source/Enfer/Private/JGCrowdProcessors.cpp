@@ -0,0 +1,202 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Public/JGCrowdProcessors.h"
+#include "Public/JGCrowdFragments.h"
+#include "Public/JGCrowdManager.h"
+#include "Public/JGPlayerContextSubsystem.h"
+#include "Public/JGSidewalkLane.h"
+#include "MassExecutionContext.h"
+#include "Engine/World.h"
+#include "JGNPC.h"
+
+namespace
+{
+	// Moves the agent distance along its direction, turning it back at the end of its walkable interval.
+	// False once there is no lane under the agent anymore.
+	bool StepAlongLane(const FJGSidewalkLane& lane, FJGCrowdAgentFragment& agent, float distance)
+	{
+		FVector target = agent.Location;
+		target.X += agent.Direction * distance;
+
+		FVector walkable;
+		if (!lane.FindNearestWalkablePoint(target, walkable, distance + 1.0f))
+		{
+			return false;
+		}
+
+		if (!FMath::IsNearlyEqual(walkable.X, target.X))
+		{
+			agent.Direction = -agent.Direction;
+		}
+		agent.Location = walkable;
+		return true;
+	}
+
+	constexpr EProcessorExecutionFlags CrowdExecutionFlags = EProcessorExecutionFlags::Standalone | EProcessorExecutionFlags::Server | EProcessorExecutionFlags::Client;
+}
+
+UJGCrowdLaneFollowProcessor::UJGCrowdLaneFollowProcessor()
+	: EntityQuery(*this)
+{
+	ExecutionFlags = static_cast<int32>(CrowdExecutionFlags);
+	ProcessingPhase = EMassProcessingPhase::PrePhysics;
+
+	// The lane belongs to the level generator, which changes it on the game thread
+	bRequiresGameThreadExecution = true;
+}
+
+void UJGCrowdLaneFollowProcessor::ConfigureQueries(const TSharedRef<FMassEntityManager>& entityManager)
+{
+	EntityQuery.AddRequirement<FJGCrowdAgentFragment>(EMassFragmentAccess::ReadWrite);
+	EntityQuery.AddTagRequirement<FJGCrowdPromotedTag>(EMassFragmentPresence::None);
+}
+
+void UJGCrowdLaneFollowProcessor::Execute(FMassEntityManager& entityManager, FMassExecutionContext& context)
+{
+	UJGCrowdManager* crowdManager = UJGCrowdManager::Get(context.GetWorld());
+	const FJGSidewalkLane* lane = FJGSidewalkLane::Get(context.GetWorld());
+	if (!crowdManager || !lane)
+	{
+		return;
+	}
+
+	int32 destroyedCount = 0;
+	EntityQuery.ForEachEntityChunk(context, [lane, &destroyedCount](FMassExecutionContext& chunkContext)
+	{
+		const TArrayView<FJGCrowdAgentFragment> agents = chunkContext.GetMutableFragmentView<FJGCrowdAgentFragment>();
+		const float deltaTime = chunkContext.GetDeltaTimeSeconds();
+
+		for (int32 entityIndex = 0; entityIndex < chunkContext.GetNumEntities(); entityIndex++)
+		{
+			FJGCrowdAgentFragment& agent = agents[entityIndex];
+			if (!StepAlongLane(*lane, agent, agent.Speed * deltaTime))
+			{
+				// The destroy is deferred, the representation processor still sees the agent this phase
+				agent.IsOffLane = true;
+				chunkContext.Defer().DestroyEntity(chunkContext.GetEntity(entityIndex));
+				destroyedCount++;
+			}
+		}
+	});
+
+	crowdManager->NotifyAgentsDestroyed(destroyedCount);
+}
+
+UJGCrowdRepresentationProcessor::UJGCrowdRepresentationProcessor()
+	: EntityQuery(*this)
+{
+	ExecutionFlags = static_cast<int32>(CrowdExecutionFlags);
+	ProcessingPhase = EMassProcessingPhase::PrePhysics;
+	ExecutionOrder.ExecuteAfter.Add(UJGCrowdLaneFollowProcessor::StaticClass()->GetFName());
+
+	// Spawns and drives actors, and updates the instance components
+	bRequiresGameThreadExecution = true;
+}
+
+void UJGCrowdRepresentationProcessor::ConfigureQueries(const TSharedRef<FMassEntityManager>& entityManager)
+{
+	EntityQuery.AddRequirement<FJGCrowdAgentFragment>(EMassFragmentAccess::ReadWrite);
+	EntityQuery.AddRequirement<FJGCrowdRepresentationFragment>(EMassFragmentAccess::ReadWrite);
+}
+
+void UJGCrowdRepresentationProcessor::Execute(FMassEntityManager& entityManager, FMassExecutionContext& context)
+{
+	UWorld* world = context.GetWorld();
+	UJGCrowdManager* crowdManager = UJGCrowdManager::Get(world);
+	const FJGSidewalkLane* lane = FJGSidewalkLane::Get(world);
+	UJGPlayerContextSubsystem* playerContexts = world ? world->GetSubsystem<UJGPlayerContextSubsystem>() : nullptr;
+	if (!crowdManager || !lane || !playerContexts)
+	{
+		return;
+	}
+
+	TArray<FVector2D, TInlineAllocator<4>> playerLocations;
+	for (const FJGPlayerContext& player : playerContexts->GetPlayers())
+	{
+		if (player.HasPawn)
+		{
+			playerLocations.Add(player.Location2D);
+		}
+	}
+
+	const float promoteDistanceSquared = FMath::Square(crowdManager->PromoteDistance);
+	const float demoteDistanceSquared = FMath::Square(FMath::Max(crowdManager->DemoteDistance, crowdManager->PromoteDistance));
+	const float visibleDistanceSquared = FMath::Square(crowdManager->VisibleDistance);
+
+	int32 destroyedCount = 0;
+	crowdManager->BeginRepresentation();
+	EntityQuery.ForEachEntityChunk(context, [&](FMassExecutionContext& chunkContext)
+	{
+		const TArrayView<FJGCrowdAgentFragment> agents = chunkContext.GetMutableFragmentView<FJGCrowdAgentFragment>();
+		const TArrayView<FJGCrowdRepresentationFragment> representations = chunkContext.GetMutableFragmentView<FJGCrowdRepresentationFragment>();
+		const bool isPromoted = chunkContext.DoesArchetypeHaveTag<FJGCrowdPromotedTag>();
+
+		for (int32 entityIndex = 0; entityIndex < chunkContext.GetNumEntities(); entityIndex++)
+		{
+			const FMassEntityHandle entity = chunkContext.GetEntity(entityIndex);
+			FJGCrowdAgentFragment& agent = agents[entityIndex];
+			FJGCrowdRepresentationFragment& representation = representations[entityIndex];
+			if (agent.IsOffLane)
+			{
+				continue;
+			}
+
+			float distanceSquared = UE_BIG_NUMBER;
+			for (const FVector2D& playerLocation : playerLocations)
+			{
+				distanceSquared = FMath::Min(distanceSquared, FVector2D::DistSquared(playerLocation, FVector2D(agent.Location)));
+			}
+			representation.PlayerDistance = FMath::Sqrt(distanceSquared);
+
+			if (isPromoted)
+			{
+				AJGNPC* actor = crowdManager->GetPromotedActor(entity);
+				if (actor)
+				{
+					agent.Location.X = actor->GetActorLocation().X;
+					agent.Location.Y = actor->GetActorLocation().Y;
+				}
+
+				// Look ahead from where the actor is, so that it turns before walking into the obstacle
+				FJGCrowdAgentFragment probe = agent;
+				const bool isOnLane = StepAlongLane(*lane, probe, crowdManager->PromotedLookAhead);
+				agent.Direction = probe.Direction;
+
+				if (actor && isOnLane && distanceSquared <= demoteDistanceSquared)
+				{
+					actor->MovementDirection = FVector(agent.Direction, 0.0f, 0.0f);
+					actor->AddMovementInput(actor->MovementDirection);
+					representation.LOD = EJGCrowdLOD::Actor;
+					crowdManager->CountAgent(representation.LOD);
+					continue;
+				}
+
+				crowdManager->DemoteAgent(entity, agent);
+				chunkContext.Defer().RemoveTag<FJGCrowdPromotedTag>(entity);
+				if (!isOnLane)
+				{
+					chunkContext.Defer().DestroyEntity(entity);
+					destroyedCount++;
+					continue;
+				}
+			}
+			else if (distanceSquared <= promoteDistanceSquared && crowdManager->PromoteAgent(entity, agent))
+			{
+				chunkContext.Defer().AddTag<FJGCrowdPromotedTag>(entity);
+				representation.LOD = EJGCrowdLOD::Actor;
+				crowdManager->CountAgent(representation.LOD);
+				continue;
+			}
+
+			representation.LOD = distanceSquared <= visibleDistanceSquared ? EJGCrowdLOD::Instanced : EJGCrowdLOD::Hidden;
+			if (representation.LOD == EJGCrowdLOD::Instanced)
+			{
+				crowdManager->AddInstance(agent);
+			}
+			crowdManager->CountAgent(representation.LOD);
+		}
+	});
+	crowdManager->EndRepresentation();
+
+	crowdManager->NotifyAgentsDestroyed(destroyedCount);
+}
@@ -4,25 +4,109 @@
 #include "Public/JGLevelGenerator.h"
 
 #include "JGNPC.h"
+#include "JGNavMeshManager.h"
+#include "Algo/BinarySearch.h"
+#include "Components/StaticMeshComponent.h"
+#include "Engine/AssetManager.h"
 #include "Engine/Engine.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/StreamableManager.h"
+#include "GameFramework/Pawn.h"
 #include "GameFramework/PlayerStart.h"
+#include "HAL/IConsoleManager.h"
 #include "Kismet/GameplayStatics.h"
+#include "PhysicsEngine/BodySetup.h"
+#include "UObject/ConstructorHelpers.h"
+
+static TAutoConsoleVariable<float> CVarChunkCullDistanceScale(
+	TEXT("jg.Chunk.CullDistanceScale"),
+	1.0f,
+	TEXT("Scale applied to the automatic cull distances of chunk components.\n")
+	TEXT("0 restores the authored draw distances. Active chunks are updated on the next chunk transition."),
+	ECVF_Scalability);
 
 UJGLevelGenerator::UJGLevelGenerator()
 {
-	PrimaryComponentTick.bCanEverTick = false;
+	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.bStartWithTickEnabled = false;
 	FrontActor = nullptr;
 	BackActor = nullptr;
+	PlayerCurrentChunkIndex = 0;
+	EffectiveChunksOnEitherSide = 0;
+	EmptyWindowLocation = FVector::ZeroVector;
+	RandomSeed = 0;
 	MirrorYOffset = 500.0f;
+
+	UseCorridorStrips = true;
+	FloorStripMaterial = nullptr;
+	FloorStripWidth = 500.0f;
+	FloorStripThickness = 100.0f;
+	AlignChunksToNavTiles = true;
+	MaxNavTilePadding = 0.25f;
+	UsePrebakedNavTiles = true;
+	UseSidewalkNavBounds = true;
+	SidewalkNavHeight = 400.0f;
+	UseAutomaticCullDistances = true;
+	AppliedCullDistanceScale = 1.0f;
+	LaneEdgeMargin = 50.0f;
+	LaneMinPassableWidth = 100.0f;
+	LaneMaxStepHeight = 45.0f;
+	LaneAgentHeight = 180.0f;
+	FloorStripComponent = nullptr;
+	ChunkAssetBudgetMB = 512;
+	UseDeferredBuildings = true;
+	DeferredWorkBudgetMs = 2.0f;
+	CollisionReadyDistance = 1;
+	ChunkClassEvictions = 0;
+	ChunkClassReloads = 0;
+
+	static ConstructorHelpers::FObjectFinder<UStaticMesh> floorStripMeshFinder(TEXT("/Engine/BasicShapes/Cube.Cube"));
+	FloorStripMesh = floorStripMeshFinder.Object;
 }
 
 void UJGLevelGenerator::BeginPlay()
 {
 	Super::BeginPlay();
 
+	EffectiveChunksOnEitherSide = NumChunksOnEitherSide;
+	SetRandomSeed(RandomSeed != 0 ? RandomSeed : FMath::Rand());
+
+	if (AlignChunksToNavTiles)
+	{
+		NavTileGrid = FJGNavTileGrid::FromWorld(GetWorld());
+		if (NavTileGrid.IsValid())
+		{
+			UE_LOG(LogTemp, Log, TEXT("JGLevelGenerator: Aligning chunks to nav tiles of size %.1f"), NavTileGrid.TileSize);
+		}
+		else
+		{
+			UE_LOG(LogTemp, Warning, TEXT("JGLevelGenerator: No Recast navmesh found, chunks will not be aligned to nav tiles"));
+		}
+	}
+
+	if (UseCorridorStrips)
+	{
+		CreateCorridorStrips();
+	}
+
+	// The resident classes are loaded already, prepare their collision before the first chunks spawn
+	for (const TSubclassOf<AJGChunk>& chunkClass : ChunkClasses)
+	{
+		if (chunkClass)
+		{
+			PrewarmChunkClassCollision(FSoftObjectPath(chunkClass.Get()));
+		}
+	}
+
 	SpawnInitialChunks();
 }
 
+void UJGLevelGenerator::SetRandomSeed(int32 seed)
+{
+	ChunkRandomStream.Initialize(seed);
+	UE_LOG(LogTemp, Log, TEXT("JGLevelGenerator: Random seed %d"), seed);
+}
+
 void UJGLevelGenerator::OnPlayerEnteredChunk(int32 newChunkIndex, int32 previousChunkIndex)
 {
 	UE_LOG(LogTemp, Log, TEXT("Player entered chunk index: %d -> %d"), previousChunkIndex, newChunkIndex);
@@ -30,36 +114,175 @@ void UJGLevelGenerator::OnPlayerEnteredChunk(int32 newChunkIndex, int32 previous
 	// Update the current chunk index
 	PlayerCurrentChunkIndex = newChunkIndex;
 
-	// Determine if the player has moved forward or backward
-	bool forward = newChunkIndex > previousChunkIndex;
-
-	DespawnExtremityChunk(!forward);
-	SpawnChunk(forward);
+	// Recenter the window on the new chunk, this also covers jumps of several chunks
+	RebalanceWindow();
+	FlushDeferredBuildings(CollisionReadyDistance);
+	RefreshCullDistancesIfNeeded();
 
-	// Broadcast the delegate for other systems (like nav mesh manager) to respond
+	// Let other systems (like nav mesh manager) respond
+	BroadcastWindowChange(newChunkIndex, previousChunkIndex);
 	OnPlayerEnteredChunkDelegate.Broadcast(newChunkIndex, previousChunkIndex);
 }
 
-void UJGLevelGenerator::SpawnChunk(bool forward)
+void UJGLevelGenerator::SetEffectiveChunksOnEitherSide(int32 numChunks)
+{
+	numChunks = FMath::Max(1, numChunks);
+	if (numChunks == EffectiveChunksOnEitherSide)
+		return;
+
+	UE_LOG(LogTemp, Log, TEXT("JGLevelGenerator: Streaming window %d -> %d chunks on either side"), EffectiveChunksOnEitherSide, numChunks);
+
+	EffectiveChunksOnEitherSide = numChunks;
+	if (ActiveChunks.Num() == 0)
+		return;
+
+	RebalanceWindow();
+	BroadcastWindowChange(PlayerCurrentChunkIndex, PlayerCurrentChunkIndex);
+}
+
+void UJGLevelGenerator::RespawnWindow()
+{
+	// The new window starts where the player's chunk stands, so that it lines up with the player
+	for (const FChunkData& chunkData : ActiveChunks)
+	{
+		if (chunkData.IsValid() && chunkData.ChunkActor->ChunkLogicalIndex == PlayerCurrentChunkIndex)
+		{
+			EmptyWindowLocation = chunkData.ChunkActor->GetActorLocation();
+		}
+	}
+
+	while (ActiveChunks.Num() > 0)
+	{
+		DespawnExtremityChunk(true);
+	}
+
+	SpawnChunk(true);
+	RebalanceWindow();
+	FlushDeferredBuildings(CollisionReadyDistance);
+	BroadcastWindowChange(PlayerCurrentChunkIndex, PlayerCurrentChunkIndex);
+}
+
+void UJGLevelGenerator::RebalanceWindow()
+{
+	const int32 firstWantedIndex = PlayerCurrentChunkIndex - EffectiveChunksOnEitherSide;
+	const int32 lastWantedIndex = PlayerCurrentChunkIndex + EffectiveChunksOnEitherSide;
+
+	// Trim first, so that a shrinking window never spawns anything
+	while (ActiveChunks.Num() > 0 && ActiveChunks[0].ChunkActor->ChunkLogicalIndex < firstWantedIndex)
+	{
+		DespawnExtremityChunk(false);
+	}
+
+	while (ActiveChunks.Num() > 0 && ActiveChunks.Last().ChunkActor->ChunkLogicalIndex > lastWantedIndex)
+	{
+		DespawnExtremityChunk(true);
+	}
+
+	// The player left the whole window behind, restart it under them
+	if (ActiveChunks.Num() == 0)
+	{
+		if (APawn* playerPawn = UGameplayStatics::GetPlayerPawn(GetWorld(), 0))
+		{
+			EmptyWindowLocation.X = playerPawn->GetActorLocation().X;
+		}
+	}
+
+	while ((ActiveChunks.Num() == 0 || ActiveChunks.Last().ChunkActor->ChunkLogicalIndex < lastWantedIndex) && SpawnChunk(true))
+	{
+	}
+
+	while (ActiveChunks.Num() > 0 && ActiveChunks[0].ChunkActor->ChunkLogicalIndex > firstWantedIndex && SpawnChunk(false))
+	{
+	}
+
+	UpdateCorridorStrips();
+}
+
+void UJGLevelGenerator::BroadcastWindowChange(int32 centerChunkIndex, int32 previousCenterChunkIndex)
+{
+	FJGChunkWindowChange windowChange;
+	windowChange.AddedChunks = AddedWindowEntries;
+	windowChange.RemovedChunks = RemovedWindowEntries;
+	windowChange.CenterChunkIndex = centerChunkIndex;
+	windowChange.PreviousCenterChunkIndex = previousCenterChunkIndex;
+
+	ChunkWindowChangedEvent.Broadcast(windowChange);
+
+	for (const FJGChunkWindowEntry& removedEntry : RemovedWindowEntries)
+	{
+		if (AJGChunk* chunk = removedEntry.ChunkActor.Get())
+		{
+			ReleaseChunkClass(chunk->GetClass());
+			chunk->Destroy();
+		}
+
+		if (AJGChunk* mirrorChunk = removedEntry.MirrorChunkActor.Get())
+		{
+			mirrorChunk->Destroy();
+		}
+	}
+
+	AddedWindowEntries.Reset();
+	RemovedWindowEntries.Reset();
+
+	TrimChunkClassResidency();
+}
+
+bool UJGLevelGenerator::SpawnChunk(bool forward)
 {
-	if (ChunkClasses.Num() == 0)
+	if (!HasChunkClasses())
 	{
 		UE_LOG(LogTemp, Warning, TEXT("No chunk visuals classes defined! Cannot spawn new chunk."));
-		return;		
+		return false;
 	}
 
-	TSubclassOf<AJGChunk> chunkClass = ChunkClasses[FMath::RandRange(0, ChunkClasses.Num() - 1)];
+	TSubclassOf<AJGChunk> chunkClass = PickChunkClass();
+	if (!chunkClass)
+		return false;
+
+	const FSoftObjectPath chunkClassPath(chunkClass.Get());
 	
-	FVector newLocation = FVector::ZeroVector;
-	int32 logicalIndex = 0;
+	FVector newLocation = EmptyWindowLocation;
+	int32 logicalIndex = PlayerCurrentChunkIndex;
 	
-	AJGChunk* newChunk = GetWorld()->SpawnActorDeferred<AJGChunk>(chunkClass, FTransform::Identity);
+	// One variant for the pair, applied before the extents are measured
+	const AJGChunk* chunkDefaults = chunkClass->GetDefaultObject<AJGChunk>();
+	const int32 variantIndex = chunkDefaults->PickRandomVariant(ChunkRandomStream);
+
+	// Classes that spawned before have known extents and bounds, so their building can be created later.
+	// A variant changing the footprint has its own, measured the first time it spawns.
+	const TPair<FSoftObjectPath, int32> measureKey(chunkClassPath, chunkDefaults->DoesVariantChangeGeometry(variantIndex) ? variantIndex : INDEX_NONE);
+	const FVector* knownExtent = ChunkClassExtents.Find(measureKey);
+	const FBox* knownLocalBounds = ChunkClassLocalBounds.Find(measureKey);
+	const bool deferBuilding = UseDeferredBuildings && knownExtent && knownLocalBounds;
+	const FBox classLocalBounds = knownLocalBounds ? *knownLocalBounds : FBox(ForceInit);
+
+	FActorSpawnParameters spawnParams;
+	spawnParams.bDeferConstruction = true;
+	if (deferBuilding)
+	{
+		// Native components register before SpawnActor returns, the building has to be held back before that
+		spawnParams.CustomPreSpawnInitalization = [](AActor* actor)
+		{
+			CastChecked<AJGChunk>(actor)->DeferBuilding();
+		};
+	}
+
+	AJGChunk* newChunk = GetWorld()->SpawnActor<AJGChunk>(chunkClass, FTransform::Identity, spawnParams);
 	if (!newChunk)
-		return;
+		return false;
 
 	FVector extent = FVector::ZeroVector;
 	FVector location = FVector::ZeroVector;
-	newChunk->GetActorBounds(true, location, extent, true);
+	if (knownExtent)
+	{
+		extent = *knownExtent;
+	}
+	else
+	{
+		// First spawn of the class: its building was created at the origin, it is measured there and moves with the chunk
+		newChunk->GetActorBounds(true, location, extent, true);
+	}
 
 	FChunkData extremityChunkData = GetExtremityChunkData(forward);
 	if (extremityChunkData.IsValid()) // if it's the first chunk, extremityChunkData will be invalid and this part is skipped
@@ -67,43 +290,135 @@ void UJGLevelGenerator::SpawnChunk(bool forward)
 		FVector extremityChunkLocation = extremityChunkData.ChunkActor->GetActorLocation();
 		logicalIndex = forward ? extremityChunkData.ChunkActor->ChunkLogicalIndex + 1 : extremityChunkData.ChunkActor->ChunkLogicalIndex - 1;
 		newLocation = extremityChunkLocation + FVector(forward ? extremityChunkData.ActorExtents.X * 2 : -extent.X * 2, 0, 0);
+
+		// Pad the chunk onto the next tile boundary away from the extremity chunk, the floor strip covers the gap
+		if (NavTileGrid.IsValid())
+		{
+			newLocation.X = forward ? NavTileGrid.SnapUpX(newLocation.X) : NavTileGrid.SnapDownX(newLocation.X);
+		}
+	}
+	else if (NavTileGrid.IsValid())
+	{
+		newLocation.X = NavTileGrid.SnapDownX(newLocation.X);
 	}
 
 	newChunk->SetIndex(logicalIndex);
 	newChunk->FinishSpawning(FTransform(newLocation));
+	newChunk->ApplyVariant(variantIndex);
 
-	// Recalculate bounds after spawning to ensure accurate extents
-	newChunk->GetActorBounds(true, location, extent, true);
+	if (!deferBuilding)
+	{
+		// Recalculate bounds after spawning to ensure accurate extents
+		newChunk->GetActorBounds(true, location, extent, true);
+		ChunkClassExtents.Add(measureKey, extent);
+	}
 
 	// Spawn the mirror chunk: rotate 180 degrees about Z and offset on Y
 	FRotator mirrorRotation(0.0f, 180.0f, 0.0f);
 	FVector mirrorLocation = newLocation + FVector(extent.X * 2, MirrorYOffset, 0.0f);
 	FTransform mirrorTransform(mirrorRotation, mirrorLocation);
 
-	AJGChunk* mirrorChunk = GetWorld()->SpawnActorDeferred<AJGChunk>(chunkClass, mirrorTransform);
+	AJGChunk* mirrorChunk = GetWorld()->SpawnActor<AJGChunk>(chunkClass, mirrorTransform, spawnParams);
 	if (IsValid(mirrorChunk))
 	{
 		mirrorChunk->SetIndex(logicalIndex);
 		mirrorChunk->FinishSpawning(mirrorTransform);
+		mirrorChunk->ApplyVariant(variantIndex);
 #if WITH_EDITOR
 		mirrorChunk->SetActorLabel(newChunk->GetActorLabel() + TEXT("_Mirror"));
 #endif
 	}
 
+	float chunkLength = extent.X * 2;
+	if (UseCorridorStrips && NavTileGrid.IsValid())
+	{
+		// Up to the next tile boundary, the floor strip covers the padding
+		chunkLength = NavTileGrid.SnapUpX(newLocation.X + chunkLength) - newLocation.X;
+	}
+
+	// The generator's strip replaces the chunk floors, extents were measured with them above
+	if (UseCorridorStrips)
+	{
+		if (IsValid(FloorStripComponent) && !IsValid(FloorStripMaterial) && !IsValid(FloorStripComponent->GetMaterial(0)))
+		{
+			FloorStripComponent->SetMaterial(0, newChunk->GetFloorMaterial());
+		}
+
+		newChunk->DisableLocalFloor(newLocation.X, newLocation.X + chunkLength);
+		if (IsValid(mirrorChunk))
+		{
+			mirrorChunk->DisableLocalFloor(newLocation.X, newLocation.X + chunkLength);
+		}
+	}
+
+	const FBox sidewalkNavBounds = UseSidewalkNavBounds ? GetSidewalkNavBounds(newLocation, chunkLength) : FBox(ForceInit);
+
+	// Same frame as FinishSpawning, deferred buildings get theirs when they are created
+	ApplyNavigationRelevance(newChunk, sidewalkNavBounds);
+	ApplyNavigationRelevance(mirrorChunk, sidewalkNavBounds);
+
+	FBox chunkBounds(ForceInit);
+	if (deferBuilding)
+	{
+		QueueDeferredBuilding(newChunk);
+		QueueDeferredBuilding(mirrorChunk);
+
+		// Predicted from the class, the buildings are not there yet
+		chunkBounds = classLocalBounds.TransformBy(newChunk->GetActorTransform());
+		if (IsValid(mirrorChunk))
+		{
+			chunkBounds += classLocalBounds.TransformBy(mirrorChunk->GetActorTransform());
+		}
+	}
+	else
+	{
+		FinalizeChunk(newChunk);
+		FinalizeChunk(mirrorChunk);
+
+		chunkBounds = newChunk->GetChunkBounds();
+		ChunkClassLocalBounds.Add(measureKey, chunkBounds.InverseTransformBy(newChunk->GetActorTransform()));
+		if (IsValid(mirrorChunk))
+		{
+			chunkBounds += mirrorChunk->GetChunkBounds();
+		}
+	}
+
+	// Deferred buildings stand beside the sidewalk, the lane only depends on what is already there
+	UpdateSidewalkLane(logicalIndex, newChunk, mirrorChunk, chunkLength);
+
+	const FBox navBounds = UseSidewalkNavBounds ? sidewalkNavBounds : chunkBounds;
 	if (forward)
-		ActiveChunks.Add(FChunkData(newChunk, mirrorChunk, extent));
+		ActiveChunks.Add(FChunkData(newChunk, mirrorChunk, extent, chunkBounds, navBounds));
 	else
-		ActiveChunks.Insert(FChunkData(newChunk, mirrorChunk, extent), 0);
+		ActiveChunks.Insert(FChunkData(newChunk, mirrorChunk, extent, chunkBounds, navBounds), 0);
+
+	RetainChunkClass(newChunk);
+
+	FJGChunkWindowEntry& addedEntry = AddedWindowEntries.AddDefaulted_GetRef();
+	addedEntry.LogicalIndex = logicalIndex;
+	addedEntry.Bounds = chunkBounds;
+	addedEntry.NavBounds = navBounds;
+	addedEntry.ChunkActor = newChunk;
+	addedEntry.MirrorChunkActor = mirrorChunk;
+
+	return true;
 }
 
 void UJGLevelGenerator::DespawnExtremityChunk(bool forward)
 {
 	FChunkData chunkData = GetExtremityChunkData(forward);
-	AJGChunk* chunkToRemove = chunkData.ChunkActor;
-	AJGChunk* mirrorChunkToRemove = chunkData.MirrorChunkActor;
-	
-	chunkToRemove->Destroy();
-	mirrorChunkToRemove->Destroy();
+	if (!chunkData.IsValid())
+		return;
+
+	// The chunk is destroyed once listeners have been told it left the window
+	FJGChunkWindowEntry& removedEntry = RemovedWindowEntries.AddDefaulted_GetRef();
+	removedEntry.LogicalIndex = chunkData.ChunkActor->ChunkLogicalIndex;
+	removedEntry.Bounds = chunkData.Bounds;
+	removedEntry.NavBounds = chunkData.NavBounds;
+	removedEntry.ChunkActor = chunkData.ChunkActor;
+	removedEntry.MirrorChunkActor = chunkData.MirrorChunkActor;
+
+	SidewalkLane.RemoveChunk(removedEntry.LogicalIndex);
 
 	int32 indexToRemove = forward ? ActiveChunks.Num() - 1 : 0;
 	ActiveChunks.RemoveAt(indexToRemove);
@@ -111,23 +426,355 @@ void UJGLevelGenerator::DespawnExtremityChunk(bool forward)
 
 void UJGLevelGenerator::SpawnInitialChunks()
 {
-	if (ChunkClasses.Num() == 0)
+	if (!HasChunkClasses())
 		return;
 
 	// Spawn center chunk
 	SpawnChunk(true);
 		
 	// Spawn additional chunks on either side
-	for (int32 i = 0; i < NumChunksOnEitherSide; i++)
+	for (int32 i = 0; i < EffectiveChunksOnEitherSide; i++)
 	{
 		SpawnChunk(true);
 		SpawnChunk(false);
 	}
 
+	UpdateCorridorStrips();
+	FlushDeferredBuildings(CollisionReadyDistance);
+	BroadcastWindowChange(PlayerCurrentChunkIndex, INDEX_NONE);
+
 	// Spawn front and back actors
 	SpawnFrontAndBackActors();
 }
 
+TSubclassOf<AJGChunk> UJGLevelGenerator::PickChunkClass()
+{
+	TArray<TSoftClassPtr<AJGChunk>> allClasses;
+	for (const TSubclassOf<AJGChunk>& chunkClass : ChunkClasses)
+	{
+		if (chunkClass)
+		{
+			allClasses.Add(TSoftClassPtr<AJGChunk>(chunkClass.Get()));
+		}
+	}
+	allClasses.Append(StreamedChunkClasses);
+
+	// Classes spawned at least once have a known width, unknown ones stay candidates until they are measured
+	TArray<TSoftClassPtr<AJGChunk>> candidates;
+	for (const TSoftClassPtr<AJGChunk>& chunkClass : allClasses)
+	{
+		const FVector* classExtent = NavTileGrid.IsValid() ? ChunkClassExtents.Find(TPair<FSoftObjectPath, int32>(chunkClass.ToSoftObjectPath(), INDEX_NONE)) : nullptr;
+		if (!classExtent || NavTileGrid.GetPadding(classExtent->X * 2.0f) <= MaxNavTilePadding * NavTileGrid.TileSize)
+		{
+			candidates.Add(chunkClass);
+		}
+	}
+
+	if (candidates.Num() == 0)
+	{
+		candidates = allClasses;
+	}
+
+	if (candidates.Num() == 0)
+	{
+		return nullptr;
+	}
+
+	const TSoftClassPtr<AJGChunk>& pickedClass = candidates[ChunkRandomStream.RandRange(0, candidates.Num() - 1)];
+	if (UClass* loadedClass = pickedClass.Get())
+	{
+		return loadedClass;
+	}
+
+	// Load the picked class for a later chunk, and use whatever is already loaded for this one
+	RequestChunkClassLoad(pickedClass, false);
+
+	auto pickLoadedClass = [this](const TArray<TSoftClassPtr<AJGChunk>>& classes) -> UClass*
+	{
+		TArray<UClass*> loadedClasses;
+		for (const TSoftClassPtr<AJGChunk>& chunkClass : classes)
+		{
+			if (UClass* loadedClass = chunkClass.Get())
+			{
+				loadedClasses.Add(loadedClass);
+			}
+		}
+
+		return loadedClasses.Num() > 0 ? loadedClasses[ChunkRandomStream.RandRange(0, loadedClasses.Num() - 1)] : nullptr;
+	};
+
+	if (UClass* loadedClass = pickLoadedClass(candidates))
+	{
+		return loadedClass;
+	}
+
+	if (UClass* loadedClass = pickLoadedClass(allClasses))
+	{
+		return loadedClass;
+	}
+
+	// Nothing is loaded yet (first chunks with only streamed classes), the window cannot wait
+	RequestChunkClassLoad(pickedClass, true);
+	return pickedClass.Get();
+}
+
+void UJGLevelGenerator::RequestChunkClassLoad(const TSoftClassPtr<AJGChunk>& chunkClass, bool synchronous)
+{
+	if (chunkClass.IsNull())
+		return;
+
+	FJGChunkClassResidency& residency = StreamedClassResidency.FindOrAdd(chunkClass.ToSoftObjectPath());
+	if (residency.LoadHandle.IsValid() && !synchronous)
+		return;
+
+	if (residency.EvictionCount > 0 && !residency.LoadHandle.IsValid())
+	{
+		ChunkClassReloads++;
+	}
+
+	FStreamableManager& streamableManager = UAssetManager::GetStreamableManager();
+	if (synchronous)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("JGLevelGenerator: Loading chunk class %s synchronously, no other chunk class is loaded"), *chunkClass.ToString());
+		residency.LoadHandle = streamableManager.RequestSyncLoad(chunkClass.ToSoftObjectPath());
+		OnChunkClassLoaded(chunkClass.ToSoftObjectPath());
+	}
+	else
+	{
+		residency.LoadHandle = streamableManager.RequestAsyncLoad(chunkClass.ToSoftObjectPath(),
+			FStreamableDelegate::CreateUObject(this, &UJGLevelGenerator::OnChunkClassLoaded, chunkClass.ToSoftObjectPath()));
+	}
+}
+
+void UJGLevelGenerator::OnChunkClassLoaded(FSoftObjectPath chunkClassPath)
+{
+	CollisionPrewarmQueue.AddUnique(chunkClassPath);
+	SetComponentTickEnabled(true);
+}
+
+void UJGLevelGenerator::PrewarmChunkClassCollision(const FSoftObjectPath& chunkClassPath)
+{
+	UClass* chunkClass = Cast<UClass>(chunkClassPath.ResolveObject());
+	if (!chunkClass || PrewarmedChunkClasses.Contains(chunkClassPath))
+		return;
+
+	PrewarmedChunkClasses.Add(chunkClassPath);
+
+	TArray<UStaticMesh*> meshes;
+	AJGChunk::GetClassStaticMeshes(chunkClass, meshes);
+	for (UStaticMesh* mesh : meshes)
+	{
+		// Does nothing for meshes whose physics meshes already exist
+		if (UBodySetup* bodySetup = mesh->GetBodySetup())
+		{
+			bodySetup->CreatePhysicsMeshes();
+		}
+	}
+}
+
+void UJGLevelGenerator::QueueDeferredBuilding(AJGChunk* chunk)
+{
+	if (!IsValid(chunk))
+		return;
+
+	PendingBuildingChunks.Add(chunk);
+	SetComponentTickEnabled(true);
+}
+
+void UJGLevelGenerator::FinishChunkBuilding(AJGChunk* chunk)
+{
+	if (!IsValid(chunk))
+		return;
+
+	// Every queued chunk is finalized once, even if something created its building earlier
+	chunk->FinishDeferredBuilding();
+
+	FBox navBounds(ForceInit);
+	for (const FChunkData& chunkData : ActiveChunks)
+	{
+		if (chunkData.ChunkActor == chunk || chunkData.MirrorChunkActor == chunk)
+		{
+			navBounds = UseSidewalkNavBounds ? chunkData.NavBounds : FBox(ForceInit);
+			break;
+		}
+	}
+	ApplyNavigationRelevance(chunk, navBounds);
+	FinalizeChunk(chunk);
+}
+
+void UJGLevelGenerator::FlushDeferredBuildings(int32 maxDistance)
+{
+	for (int32 i = PendingBuildingChunks.Num() - 1; i >= 0; i--)
+	{
+		AJGChunk* chunk = PendingBuildingChunks[i].Get();
+		if (IsValid(chunk) && FMath::Abs(chunk->ChunkLogicalIndex - PlayerCurrentChunkIndex) > maxDistance)
+			continue;
+
+		PendingBuildingChunks.RemoveAtSwap(i);
+		if (IsValid(chunk))
+		{
+			UE_LOG(LogTemp, Verbose, TEXT("JGLevelGenerator: Creating the building of chunk %d now, the player is getting close"), chunk->ChunkLogicalIndex);
+			FinishChunkBuilding(chunk);
+		}
+	}
+}
+
+void UJGLevelGenerator::TickComponent(float deltaTime, ELevelTick tickType, FActorComponentTickFunction* thisTickFunction)
+{
+	Super::TickComponent(deltaTime, tickType, thisTickFunction);
+
+	// At least one item per frame, so that the queues drain even with a tiny budget
+	const double endTime = FPlatformTime::Seconds() + DeferredWorkBudgetMs / 1000.0;
+	do
+	{
+		if (CollisionPrewarmQueue.Num() > 0)
+		{
+			PrewarmChunkClassCollision(CollisionPrewarmQueue.Pop());
+			continue;
+		}
+
+		if (PendingBuildingChunks.Num() == 0)
+			break;
+
+		// Closest to the player first
+		int32 closestIndex = 0;
+		int32 closestDistance = MAX_int32;
+		for (int32 i = 0; i < PendingBuildingChunks.Num(); i++)
+		{
+			const AJGChunk* chunk = PendingBuildingChunks[i].Get();
+			const int32 distance = IsValid(chunk) ? FMath::Abs(chunk->ChunkLogicalIndex - PlayerCurrentChunkIndex) : -1;
+			if (distance < closestDistance)
+			{
+				closestIndex = i;
+				closestDistance = distance;
+			}
+		}
+
+		AJGChunk* chunk = PendingBuildingChunks[closestIndex].Get();
+		PendingBuildingChunks.RemoveAtSwap(closestIndex);
+		FinishChunkBuilding(chunk);
+	}
+	while (FPlatformTime::Seconds() < endTime);
+
+	if (CollisionPrewarmQueue.Num() == 0 && PendingBuildingChunks.Num() == 0)
+	{
+		SetComponentTickEnabled(false);
+	}
+}
+
+void UJGLevelGenerator::RetainChunkClass(AJGChunk* chunk)
+{
+	FJGChunkClassResidency* residency = StreamedClassResidency.Find(FSoftObjectPath(chunk->GetClass()));
+	if (!residency)
+		return;
+
+	// An evicted class can still be in memory until the next garbage collection, hold it again
+	if (!residency->LoadHandle.IsValid())
+	{
+		RequestChunkClassLoad(TSoftClassPtr<AJGChunk>(chunk->GetClass()), false);
+	}
+
+	residency->ActiveCount++;
+
+	// The mirror chunk uses the same assets
+	if (residency->MemoryCost == 0)
+	{
+		residency->MemoryCost = chunk->EstimateAssetMemory();
+		UE_LOG(LogTemp, Log, TEXT("JGLevelGenerator: Chunk class %s uses about %.1fMB"), *chunk->GetClass()->GetName(), residency->MemoryCost / (1024.0f * 1024.0f));
+	}
+}
+
+void UJGLevelGenerator::ReleaseChunkClass(UClass* chunkClass)
+{
+	FJGChunkClassResidency* residency = StreamedClassResidency.Find(FSoftObjectPath(chunkClass));
+	if (!residency)
+		return;
+
+	residency->ActiveCount = FMath::Max(0, residency->ActiveCount - 1);
+	if (residency->ActiveCount == 0)
+	{
+		residency->LastUsedTime = GetWorld()->GetTimeSeconds();
+	}
+}
+
+void UJGLevelGenerator::TrimChunkClassResidency()
+{
+	if (ChunkAssetBudgetMB <= 0)
+		return;
+
+	const int64 budgetBytes = int64(ChunkAssetBudgetMB) * 1024 * 1024;
+	int64 usedBytes = GetStreamedClassesMemory();
+
+	while (usedBytes > budgetBytes)
+	{
+		// Least recently used class out of the window, classes still loading are left alone
+		FSoftObjectPath evictedPath;
+		FJGChunkClassResidency* evictedResidency = nullptr;
+		for (TPair<FSoftObjectPath, FJGChunkClassResidency>& pair : StreamedClassResidency)
+		{
+			FJGChunkClassResidency& residency = pair.Value;
+			if (residency.ActiveCount > 0 || !residency.LoadHandle.IsValid() || !residency.LoadHandle->HasLoadCompleted())
+				continue;
+
+			if (!evictedResidency || residency.LastUsedTime < evictedResidency->LastUsedTime)
+			{
+				evictedPath = pair.Key;
+				evictedResidency = &residency;
+			}
+		}
+
+		if (!evictedResidency)
+			break;
+
+		// The assets are freed by the next garbage collection, once nothing else references them
+		evictedResidency->LoadHandle->ReleaseHandle();
+		evictedResidency->LoadHandle.Reset();
+		evictedResidency->EvictionCount++;
+		PrewarmedChunkClasses.Remove(evictedPath);
+		ChunkClassEvictions++;
+		usedBytes -= evictedResidency->MemoryCost;
+
+		UE_LOG(LogTemp, Log, TEXT("JGLevelGenerator: Released chunk class %s (%.1fMB), %.1f/%dMB used"),
+			*evictedPath.ToString(), evictedResidency->MemoryCost / (1024.0f * 1024.0f), usedBytes / (1024.0f * 1024.0f), ChunkAssetBudgetMB);
+	}
+}
+
+int64 UJGLevelGenerator::GetStreamedClassesMemory() const
+{
+	int64 usedBytes = 0;
+	for (const TPair<FSoftObjectPath, FJGChunkClassResidency>& pair : StreamedClassResidency)
+	{
+		if (pair.Value.LoadHandle.IsValid())
+		{
+			usedBytes += pair.Value.MemoryCost;
+		}
+	}
+
+	return usedBytes;
+}
+
+FJGChunkAssetStats UJGLevelGenerator::GetChunkAssetStats() const
+{
+	FJGChunkAssetStats stats;
+	stats.BudgetMB = ChunkAssetBudgetMB;
+	stats.UsedMB = GetStreamedClassesMemory() / (1024.0f * 1024.0f);
+	stats.Evictions = ChunkClassEvictions;
+	stats.Reloads = ChunkClassReloads;
+
+	for (const TPair<FSoftObjectPath, FJGChunkClassResidency>& pair : StreamedClassResidency)
+	{
+		if (!pair.Value.LoadHandle.IsValid())
+			continue;
+
+		if (pair.Value.ActiveCount > 0)
+			stats.InUseClasses++;
+		else
+			stats.CachedClasses++;
+	}
+
+	return stats;
+}
+
 FChunkData UJGLevelGenerator::GetExtremityChunkData(bool forward)
 {
 	if (ActiveChunks.Num() > 0)
@@ -136,6 +783,212 @@ FChunkData UJGLevelGenerator::GetExtremityChunkData(bool forward)
 		return FChunkData();
 }
 
+void UJGLevelGenerator::FinalizeChunk(AJGChunk* chunk)
+{
+	if (!IsValid(chunk))
+		return;
+
+	// Variants were applied at spawn, so the cull distances are computed from the swapped meshes
+	if (UseAutomaticCullDistances)
+	{
+		AppliedCullDistanceScale = CVarChunkCullDistanceScale.GetValueOnGameThread();
+		chunk->ApplyCullDistances(CullDistanceSettings, GetSidewalkCenterY(), AppliedCullDistanceScale);
+	}
+}
+
+void UJGLevelGenerator::ApplyNavigationRelevance(AJGChunk* chunk, const FBox& navBounds)
+{
+	if (!IsValid(chunk))
+		return;
+
+	// The components registered this frame, their nav octree registration can still be dropped
+	if (ShouldAttachBakedNavTiles(chunk))
+	{
+		chunk->DisableNavigationRelevance();
+	}
+	else if (navBounds.IsValid)
+	{
+		chunk->DisableNavigationRelevanceOutside(navBounds);
+	}
+}
+
+bool UJGLevelGenerator::ShouldAttachBakedNavTiles(const AJGChunk* chunk) const
+{
+	return IsValid(chunk) && ShouldUsePrebakedNavTiles() && chunk->HasBakedNavTiles(NavTileGrid.TileSize, MirrorYOffset);
+}
+
+bool UJGLevelGenerator::ShouldUsePrebakedNavTiles() const
+{
+	if (!UsePrebakedNavTiles)
+		return false;
+
+	// The coverage mode is settled in the manager's InitializeComponent, before any chunk spawns
+	const UJGNavMeshManager* navMeshManager = GetOwner()->FindComponentByClass<UJGNavMeshManager>();
+	return !IsValid(navMeshManager) || navMeshManager->GetCoverageMode() != EJGNavCoverageMode::Invokers;
+}
+
+void UJGLevelGenerator::RefreshCullDistancesIfNeeded()
+{
+	const float cullDistanceScale = CVarChunkCullDistanceScale.GetValueOnGameThread();
+	if (!UseAutomaticCullDistances || cullDistanceScale == AppliedCullDistanceScale)
+		return;
+
+	AppliedCullDistanceScale = cullDistanceScale;
+	const float sidewalkCenterY = GetSidewalkCenterY();
+	for (const FChunkData& chunkData : ActiveChunks)
+	{
+		if (IsValid(chunkData.ChunkActor))
+		{
+			chunkData.ChunkActor->ApplyCullDistances(CullDistanceSettings, sidewalkCenterY, cullDistanceScale);
+		}
+
+		if (IsValid(chunkData.MirrorChunkActor))
+		{
+			chunkData.MirrorChunkActor->ApplyCullDistances(CullDistanceSettings, sidewalkCenterY, cullDistanceScale);
+		}
+	}
+}
+
+void UJGLevelGenerator::UpdateSidewalkLane(int32 chunkIndex, AJGChunk* chunk, AJGChunk* mirrorChunk, float chunkLength)
+{
+	if (!IsValid(chunk))
+		return;
+
+	// Same band as the floor strip: the chunk floors [0, width] and the mirror floors [MirrorYOffset - width, MirrorYOffset]
+	const FVector chunkLocation = chunk->GetActorLocation();
+	const float minY = chunkLocation.Y + FMath::Min(0.0f, MirrorYOffset - FloorStripWidth) + LaneEdgeMargin;
+	const float maxY = chunkLocation.Y + FMath::Max(FloorStripWidth, MirrorYOffset) - LaneEdgeMargin;
+	const float groundZ = chunkLocation.Z;
+
+	// Footprints of what stands on the sidewalk, grown so that the lane keeps the agents' centres a radius away
+	TArray<FBox2D> obstacles;
+	auto gatherObstacles = [&](AJGChunk* chunkActor)
+	{
+		if (!IsValid(chunkActor))
+			return;
+
+		TArray<UPrimitiveComponent*> primitiveComponents;
+		chunkActor->GetComponents<UPrimitiveComponent>(primitiveComponents, true);
+		for (const UPrimitiveComponent* primitiveComponent : primitiveComponents)
+		{
+			if (!primitiveComponent->IsRegistered() || !primitiveComponent->IsCollisionEnabled()
+				|| primitiveComponent->GetCollisionResponseToChannel(ECC_Pawn) != ECR_Block)
+				continue;
+
+			const FBox bounds = primitiveComponent->Bounds.GetBox();
+			if (bounds.Max.Z <= groundZ + LaneMaxStepHeight || bounds.Min.Z >= groundZ + LaneAgentHeight)
+				continue;
+
+			obstacles.Add(FBox2D(FVector2D(bounds.Min) - FVector2D(LaneEdgeMargin), FVector2D(bounds.Max) + FVector2D(LaneEdgeMargin)));
+		}
+	};
+	gatherObstacles(chunk);
+	gatherObstacles(mirrorChunk);
+
+	// The margins on both sides of a gap are already taken out of the band the agents' centres walk on
+	const float minBandWidth = FMath::Max(0.0f, LaneMinPassableWidth - 2.0f * LaneEdgeMargin);
+
+	TArray<FJGLaneInterval> intervals;
+	FJGSidewalkLane::ComputeIntervals(chunkLocation.X, chunkLocation.X + chunkLength, minY, maxY, groundZ, obstacles, minBandWidth, intervals);
+
+	SidewalkLane.SetChunkIntervals(chunkIndex, intervals);
+}
+
+int32 UJGLevelGenerator::FindChunkIndexAt(float x) const
+{
+	// Active chunks are sorted on X, take the last one starting at or before x
+	const int32 nextIndex = Algo::UpperBoundBy(ActiveChunks, x, [](const FChunkData& chunkData)
+	{
+		return chunkData.IsValid() ? chunkData.ChunkActor->GetActorLocation().X : -UE_BIG_NUMBER;
+	});
+
+	const int32 chunkIndex = nextIndex - 1;
+	if (!ActiveChunks.IsValidIndex(chunkIndex) || !ActiveChunks[chunkIndex].IsValid())
+		return INDEX_NONE;
+
+	const FChunkData& chunkData = ActiveChunks[chunkIndex];
+	if (nextIndex == ActiveChunks.Num() && x > chunkData.ChunkActor->GetActorLocation().X + chunkData.ActorExtents.X * 2)
+		return INDEX_NONE;
+
+	return chunkData.ChunkActor->ChunkLogicalIndex;
+}
+
+FBox UJGLevelGenerator::GetSidewalkNavBounds(const FVector& chunkLocation, float chunkLength) const
+{
+	// Same band as the floor strip: the chunk floors [0, width] and the mirror floors [MirrorYOffset - width, MirrorYOffset]
+	const float minY = chunkLocation.Y + FMath::Min(0.0f, MirrorYOffset - FloorStripWidth);
+	const float maxY = chunkLocation.Y + FMath::Max(FloorStripWidth, MirrorYOffset);
+	return FBox(FVector(chunkLocation.X, minY, chunkLocation.Z - FloorStripThickness),
+		FVector(chunkLocation.X + chunkLength, maxY, chunkLocation.Z + SidewalkNavHeight));
+}
+
+float UJGLevelGenerator::GetSidewalkCenterY() const
+{
+	// Chunks are all spawned on the same Y, the mirror row is offset by MirrorYOffset
+	const FChunkData* firstChunk = ActiveChunks.Num() > 0 ? &ActiveChunks[0] : nullptr;
+	const float chunkRowY = firstChunk && firstChunk->IsValid() ? firstChunk->ChunkActor->GetActorLocation().Y : 0.0f;
+	return chunkRowY + MirrorYOffset * 0.5f;
+}
+
+void UJGLevelGenerator::CreateCorridorStrips()
+{
+	AActor* owner = GetOwner();
+	if (!IsValid(owner))
+		return;
+
+	if (IsValid(FloorStripMesh))
+	{
+		FloorStripComponent = NewObject<UStaticMeshComponent>(owner, TEXT("FloorStrip"));
+		FloorStripComponent->SetMobility(EComponentMobility::Movable);
+		FloorStripComponent->SetUsingAbsoluteLocation(true);
+		FloorStripComponent->SetUsingAbsoluteRotation(true);
+		FloorStripComponent->SetUsingAbsoluteScale(true);
+		FloorStripComponent->SetStaticMesh(FloorStripMesh);
+		if (IsValid(FloorStripMaterial))
+		{
+			FloorStripComponent->SetMaterial(0, FloorStripMaterial);
+		}
+		FloorStripComponent->SetCollisionProfileName(TEXT("BlockAll"));
+		// Resizing the strip would dirty every tile under the window, the chunks' hidden floors carry the navmesh instead
+		FloorStripComponent->SetCanEverAffectNavigation(false);
+		FloorStripComponent->RegisterComponent();
+	}
+	else
+	{
+		UE_LOG(LogTemp, Warning, TEXT("JGLevelGenerator: No FloorStripMesh specified, the corridor will have no floor"));
+	}
+}
+
+void UJGLevelGenerator::UpdateCorridorStrips()
+{
+	if (!UseCorridorStrips || ActiveChunks.Num() == 0)
+		return;
+
+	const FChunkData& firstChunk = ActiveChunks[0];
+	const FChunkData& lastChunk = ActiveChunks.Last();
+	if (!firstChunk.IsValid() || !lastChunk.IsValid())
+		return;
+
+	// Chunks are laid out from their location to their location + their width on X
+	const FVector rowOrigin = firstChunk.ChunkActor->GetActorLocation();
+	const float minX = rowOrigin.X;
+	const float maxX = lastChunk.ChunkActor->GetActorLocation().X + lastChunk.ActorExtents.X * 2.0f;
+
+	if (IsValid(FloorStripComponent))
+	{
+		// Cover the chunk floors [0, width] and the mirror floors [MirrorYOffset - width, MirrorYOffset]
+		const float minY = rowOrigin.Y + FMath::Min(0.0f, MirrorYOffset - FloorStripWidth);
+		const float maxY = rowOrigin.Y + FMath::Max(FloorStripWidth, MirrorYOffset);
+
+		const FVector meshSize = FloorStripMesh->GetBoundingBox().GetSize();
+		const FVector floorSize(maxX - minX, maxY - minY, FloorStripThickness);
+		const FVector floorCenter((minX + maxX) * 0.5f, (minY + maxY) * 0.5f, rowOrigin.Z - FloorStripThickness * 0.5f);
+
+		FloorStripComponent->SetWorldLocationAndRotation(floorCenter, FRotator::ZeroRotator);
+		FloorStripComponent->SetWorldScale3D(floorSize / meshSize.ComponentMax(FVector(KINDA_SMALL_NUMBER)));
+	}
+}
+
 FBox UJGLevelGenerator::GetChunkRangeBounds(int32 centerChunkIndex, int32 bufferSize) const
 {
 	if (ActiveChunks.Num() == 0)
@@ -163,7 +1016,7 @@ FBox UJGLevelGenerator::GetChunkRangeBounds(int32 centerChunkIndex, int32 buffer
 				FVector chunkLocation = chunkData.ChunkActor->GetActorLocation();
 				FVector chunkExtent = chunkData.ActorExtents;
 				
-				FBox chunkBounds = FBox(chunkLocation - chunkExtent, chunkLocation + chunkExtent);
+				FBox chunkBounds = UseSidewalkNavBounds ? chunkData.NavBounds : FBox(chunkLocation - chunkExtent, chunkLocation + chunkExtent);
 				
 				if (foundAnyChunk)
 				{
@@ -205,6 +1058,16 @@ FBox UJGLevelGenerator::GetChunkRangeBounds(int32 centerChunkIndex, int32 buffer
 				FVector(startLocation.X - chunkExtent.X, -chunkExtent.Y, -chunkExtent.Z),
 				FVector(endLocation.X + chunkExtent.X, chunkExtent.Y, chunkExtent.Z)
 			);
+
+			if (UseSidewalkNavBounds)
+			{
+				// Keep the estimated X range, the band does not depend on the chunk classes
+				const FBox sidewalkNavBounds = GetSidewalkNavBounds(refChunk->ChunkActor->GetActorLocation(), chunkWidth);
+				totalBounds.Min.Y = sidewalkNavBounds.Min.Y;
+				totalBounds.Max.Y = sidewalkNavBounds.Max.Y;
+				totalBounds.Min.Z = sidewalkNavBounds.Min.Z;
+				totalBounds.Max.Z = sidewalkNavBounds.Max.Z;
+			}
 		}
 	}
 
@@ -245,6 +1108,7 @@ void UJGLevelGenerator::SpawnFrontAndBackActors()
 
 		FrontActor = world->SpawnActorDeferred<AJGNPC>(FrontNPCClass, frontTransform);
 		FrontActor->MovementDirection = FVector::ForwardVector; // Set movement direction to forward
+		FrontActor->MaxAILODTier = EJGAILODTier::Reduced; // Its behavior tree brings it back when it falls far behind
 		FrontActor->FinishSpawning(frontTransform);
 		
 		if (IsValid(FrontActor))
@@ -270,6 +1134,7 @@ void UJGLevelGenerator::SpawnFrontAndBackActors()
 		FTransform backTransform(backRotation, backLocation);
 		BackActor = world->SpawnActorDeferred<AJGNPC>(BackNPCClass, backTransform, nullptr, nullptr, ESpawnActorCollisionHandlingMethod::AlwaysSpawn);
 		BackActor->MovementDirection = FVector::BackwardVector; // Set movement direction to backward
+		BackActor->MaxAILODTier = EJGAILODTier::Reduced; // Its behavior tree brings it back when it falls far behind
 		BackActor->FinishSpawning(backTransform);
 		
 		if (IsValid(BackActor))
@@ -3,13 +3,20 @@
 
 #include "JGNPC.h"
 #include "Components/SkeletalMeshComponent.h"
+#include "SkeletalMeshComponentBudgeted.h"
+#include "JGAnimationBudgetManager.h"
+#include "JGPlayerContextSubsystem.h"
 
 
-// Sets default values
-AJGNPC::AJGNPC()
+// Sets default values, the mesh is budgeted so that the animation budget manager can throttle it
+AJGNPC::AJGNPC(const FObjectInitializer& objectInitializer)
+	: Super(objectInitializer.SetDefaultSubobjectClass<USkeletalMeshComponentBudgeted>(ACharacter::MeshComponentName))
 {
 	// Set this character to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
 	PrimaryActorTick.bCanEverTick = true;
+
+	MaxAILODTier = EJGAILODTier::Far;
+	AILODTier = EJGAILODTier::Full;
 }
 
 void AJGNPC::BeginPlay()
@@ -17,17 +24,43 @@ void AJGNPC::BeginPlay()
 	Super::BeginPlay();
 
 	ApplyRandomMesh();
+
+	if (UJGAILODManager* aiLODManager = UJGAILODManager::Get(GetWorld()))
+	{
+		aiLODManager->RegisterNPC(this);
+	}
+
+	if (UJGAnimationBudgetManager* animationBudgetManager = UJGAnimationBudgetManager::Get(GetWorld()))
+	{
+		animationBudgetManager->RegisterMesh(GetMesh());
+	}
+}
+
+void AJGNPC::EndPlay(const EEndPlayReason::Type endPlayReason)
+{
+	if (UJGAILODManager* aiLODManager = UJGAILODManager::Get(GetWorld()))
+	{
+		aiLODManager->UnregisterNPC(this);
+	}
+
+	if (UJGAnimationBudgetManager* animationBudgetManager = UJGAnimationBudgetManager::Get(GetWorld()))
+	{
+		animationBudgetManager->UnregisterMesh(GetMesh());
+	}
+
+	Super::EndPlay(endPlayReason);
 }
 
 void AJGNPC::UpdateCastShadow() const
 {
-	APawn* player = GetWorld() && GetWorld()->GetFirstPlayerController()
-		                ? GetWorld()->GetFirstPlayerController()->GetPawn() : nullptr;
+	const FJGPlayerContext* player = UJGPlayerContextSubsystem::FindClosest(GetWorld(), GetActorLocation());
+	if (!player)
+	{
+		return;
+	}
 
 	FVector2D moveDir2D = FVector2D(MovementDirection.X, MovementDirection.Y);
-	FVector playerForward = player->GetActorForwardVector();
-	FVector2D playerForward2D(playerForward.X, playerForward.Y);
-	const float facingDot = FVector2D::DotProduct(playerForward2D.GetSafeNormal(), moveDir2D.GetSafeNormal());
+	const float facingDot = FVector2D::DotProduct(player->Forward2D, moveDir2D.GetSafeNormal());
 	GetMesh()->SetCastShadow(facingDot > -0.8f);
 }
 
@@ -0,0 +1,223 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Public/JGNPCPool.h"
+#include "Public/JGAILODManager.h"
+#include "AIController.h"
+#include "BrainComponent.h"
+#include "BehaviorTree/BlackboardComponent.h"
+#include "BehaviorTree/BlackboardData.h"
+#include "Components/CapsuleComponent.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Engine/World.h"
+#include "IAnimationBudgetAllocator.h"
+#include "SkeletalMeshComponentBudgeted.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "JGNPC.h"
+
+UJGNPCPool::UJGNPCPool()
+{
+	PrimaryComponentTick.bCanEverTick = false;
+	ParkingLocation = FVector(0.0f, 0.0f, -10000.0f);
+}
+
+void UJGNPCPool::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (Stats.Hits + Stats.Misses > 0)
+	{
+		UE_LOG(LogTemp, Log, TEXT("JGNPCPool: %d hits, %d misses (%.0f%% hit rate), %d prewarmed, %d active and %d free at the end"),
+			Stats.Hits, Stats.Misses, 100.0f * Stats.Hits / (Stats.Hits + Stats.Misses), Stats.PrewarmedCount, Stats.ActiveCount, Stats.FreeCount);
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void UJGNPCPool::SetControllerless(TSubclassOf<AJGNPC> npcClass)
+{
+	if (npcClass)
+	{
+		Buckets.FindOrAdd(npcClass).IsControllerless = true;
+	}
+}
+
+void UJGNPCPool::Prewarm(TSubclassOf<AJGNPC> npcClass, int32 count)
+{
+	if (!npcClass)
+	{
+		return;
+	}
+
+	FJGNPCPoolBucket& bucket = Buckets.FindOrAdd(npcClass);
+	while (bucket.FreeNPCs.Num() < count)
+	{
+		AJGNPC* npc = SpawnNPC(npcClass, FTransform(ParkingLocation));
+		if (!npc)
+		{
+			return;
+		}
+
+		SetPooled(npc, true);
+		bucket.FreeNPCs.Add(npc);
+		Stats.PrewarmedCount++;
+		Stats.FreeCount++;
+	}
+}
+
+AJGNPC* UJGNPCPool::Acquire(TSubclassOf<AJGNPC> npcClass, const FVector& groundLocation, const FRotator& rotation)
+{
+	if (!npcClass)
+	{
+		return nullptr;
+	}
+
+	// The capsule is centered on the actor
+	const AJGNPC* defaultNPC = npcClass->GetDefaultObject<AJGNPC>();
+	const FVector location = groundLocation + FVector(0.0f, 0.0f, defaultNPC->GetCapsuleComponent()->GetScaledCapsuleHalfHeight());
+
+	AJGNPC* npc = nullptr;
+	if (FJGNPCPoolBucket* bucket = Buckets.Find(npcClass))
+	{
+		// Pooled NPCs can still be destroyed by someone else
+		while (!npc && bucket->FreeNPCs.Num() > 0)
+		{
+			npc = bucket->FreeNPCs.Pop(EAllowShrinking::No);
+			Stats.FreeCount--;
+			npc = IsValid(npc) ? npc : nullptr;
+		}
+	}
+
+	if (npc)
+	{
+		Stats.Hits++;
+		npc->SetActorLocationAndRotation(location, rotation, false, nullptr, ETeleportType::ResetPhysics);
+		npc->ApplyRandomMesh();
+		SetPooled(npc, false);
+	}
+	else
+	{
+		Stats.Misses++;
+		npc = SpawnNPC(npcClass, FTransform(rotation, location));
+		if (!npc)
+		{
+			return nullptr;
+		}
+	}
+
+	if (AController* controller = npc->GetController())
+	{
+		controller->SetControlRotation(rotation);
+	}
+
+	ActiveNPCs.Add(npc);
+	Stats.ActiveCount++;
+	return npc;
+}
+
+void UJGNPCPool::Release(AJGNPC* npc)
+{
+	if (!IsValid(npc) || ActiveNPCs.RemoveSwap(npc, EAllowShrinking::No) == 0)
+	{
+		return;
+	}
+
+	Stats.ActiveCount--;
+
+	// Resumes a paused brain and movement, so that the pool stops them the usual way
+	if (UJGAILODManager* aiLODManager = UJGAILODManager::Get(GetWorld()))
+	{
+		aiLODManager->ResetTier(npc);
+	}
+
+	SetPooled(npc, true);
+	npc->SetActorLocation(ParkingLocation, false, nullptr, ETeleportType::ResetPhysics);
+
+	Buckets.FindOrAdd(npc->GetClass()).FreeNPCs.Add(npc);
+	Stats.FreeCount++;
+}
+
+AJGNPC* UJGNPCPool::SpawnNPC(UClass* npcClass, const FTransform& transform)
+{
+	AJGNPC* npc = GetWorld()->SpawnActorDeferred<AJGNPC>(npcClass, transform, nullptr, nullptr, ESpawnActorCollisionHandlingMethod::AlwaysSpawn);
+	if (!IsValid(npc))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("JGNPCPool: Could not spawn %s"), *GetNameSafe(npcClass));
+		return nullptr;
+	}
+
+	const FJGNPCPoolBucket* bucket = Buckets.Find(npcClass);
+	if (bucket && bucket->IsControllerless)
+	{
+		npc->AutoPossessAI = EAutoPossessAI::Disabled;
+	}
+	npc->FinishSpawning(transform);
+
+	return npc;
+}
+
+void UJGNPCPool::SetPooled(AJGNPC* npc, bool isPooled)
+{
+	npc->SetActorHiddenInGame(isPooled);
+	npc->SetActorEnableCollision(!isPooled);
+	npc->SetActorTickEnabled(!isPooled);
+
+	// The animation budget allocator drives the tick of the meshes it knows, pooled ones are taken off it
+	USkeletalMeshComponent* mesh = npc->GetMesh();
+	USkeletalMeshComponentBudgeted* budgetedMesh = Cast<USkeletalMeshComponentBudgeted>(mesh);
+	IAnimationBudgetAllocator* allocator = budgetedMesh ? IAnimationBudgetAllocator::Get(GetWorld()) : nullptr;
+	if (allocator && isPooled)
+	{
+		allocator->UnregisterComponent(budgetedMesh);
+	}
+	if (mesh)
+	{
+		mesh->SetComponentTickEnabled(!isPooled);
+	}
+	if (allocator && !isPooled)
+	{
+		allocator->RegisterComponent(budgetedMesh);
+	}
+
+	UCharacterMovementComponent* characterMovement = npc->GetCharacterMovement();
+	if (isPooled)
+	{
+		characterMovement->StopMovementImmediately();
+		characterMovement->DisableMovement();
+
+		// Users may have tuned the movement, the next one starts from the class defaults
+		const AJGNPC* defaultNPC = npc->GetClass()->GetDefaultObject<AJGNPC>();
+		characterMovement->MaxWalkSpeed = defaultNPC->GetCharacterMovement()->MaxWalkSpeed;
+		characterMovement->bOrientRotationToMovement = defaultNPC->GetCharacterMovement()->bOrientRotationToMovement;
+		characterMovement->bRunPhysicsWithNoController = defaultNPC->GetCharacterMovement()->bRunPhysicsWithNoController;
+	}
+	else
+	{
+		characterMovement->SetDefaultMovementMode();
+	}
+	characterMovement->SetComponentTickEnabled(!isPooled);
+
+	AAIController* aiController = Cast<AAIController>(npc->GetController());
+	UBrainComponent* brain = aiController ? aiController->GetBrainComponent() : nullptr;
+	const FJGNPCPoolBucket* bucket = Buckets.Find(npc->GetClass());
+	if (!brain || (bucket && bucket->IsControllerless))
+	{
+		return;
+	}
+
+	if (isPooled)
+	{
+		brain->StopLogic(TEXT("Pooled"));
+		return;
+	}
+
+	// Start from a clean blackboard, as a fresh NPC would
+	if (UBlackboardComponent* blackboard = aiController->GetBlackboardComponent())
+	{
+		if (const UBlackboardData* blackboardAsset = blackboard->GetBlackboardAsset())
+		{
+			for (int32 keyIndex = 0; keyIndex < blackboardAsset->GetNumKeys(); keyIndex++)
+			{
+				blackboard->ClearValue(FBlackboard::FKey(keyIndex));
+			}
+		}
+	}
+	brain->RestartLogic();
+}
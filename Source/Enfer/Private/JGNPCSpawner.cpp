@@ -0,0 +1,173 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Public/JGNPCSpawner.h"
+#include "Public/JGLevelGenerator.h"
+#include "Public/JGNPCPool.h"
+#include "JGNPC.h"
+
+UJGNPCSpawner::UJGNPCSpawner()
+{
+	PrimaryComponentTick.bCanEverTick = false;
+	LevelGenerator = nullptr;
+	NPCPool = nullptr;
+	SpawnedNPCCount = 0;
+
+	NPCClass = nullptr;
+	DensityScale = 1.0f;
+	MaxSpawnedNPCs = 40;
+	PrewarmCount = 16;
+}
+
+void UJGNPCSpawner::BeginPlay()
+{
+	Super::BeginPlay();
+
+	if (!NPCClass)
+	{
+		return;
+	}
+
+	NPCPool = GetOwner()->FindComponentByClass<UJGNPCPool>();
+	if (!IsValid(NPCPool))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("JGNPCSpawner: Could not find NPC pool component!"));
+		return;
+	}
+
+	LevelGenerator = GetOwner()->FindComponentByClass<UJGLevelGenerator>();
+	if (!IsValid(LevelGenerator))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("JGNPCSpawner: Could not find level generator component!"));
+		return;
+	}
+
+	NPCPool->Prewarm(NPCClass, FMath::Min(PrewarmCount, MaxSpawnedNPCs));
+
+	LevelGenerator->OnChunkWindowChanged().AddUObject(this, &UJGNPCSpawner::OnChunkWindowChanged);
+
+	// Chunks spawned before we bound
+	for (const FChunkData& chunkData : LevelGenerator->GetActiveChunks())
+	{
+		if (chunkData.IsValid())
+		{
+			SpawnChunkNPCs(chunkData.ChunkActor->ChunkLogicalIndex, chunkData.ChunkActor, chunkData.MirrorChunkActor);
+		}
+	}
+}
+
+void UJGNPCSpawner::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (IsValid(LevelGenerator))
+	{
+		LevelGenerator->OnChunkWindowChanged().RemoveAll(this);
+	}
+
+	TArray<int32> chunkIndices;
+	ChunkNPCs.GetKeys(chunkIndices);
+	for (int32 chunkIndex : chunkIndices)
+	{
+		ReleaseChunkNPCs(chunkIndex);
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void UJGNPCSpawner::OnChunkWindowChanged(const FJGChunkWindowChange& windowChange)
+{
+	// NPCs walk out of their spawn chunk, the ones now in a chunk that stays are kept
+	if (windowChange.RemovedChunks.Num() > 0)
+	{
+		RebucketNPCs();
+		ReleaseChunkNPCs(INDEX_NONE);
+	}
+
+	// Released first, so that the added chunks reuse them
+	for (const FJGChunkWindowEntry& removedEntry : windowChange.RemovedChunks)
+	{
+		ReleaseChunkNPCs(removedEntry.LogicalIndex);
+	}
+
+	for (const FJGChunkWindowEntry& addedEntry : windowChange.AddedChunks)
+	{
+		SpawnChunkNPCs(addedEntry.LogicalIndex, addedEntry.ChunkActor.Get(), addedEntry.MirrorChunkActor.Get());
+	}
+}
+
+void UJGNPCSpawner::SpawnChunkNPCs(int32 chunkIndex, const AJGChunk* chunk, const AJGChunk* mirrorChunk)
+{
+	if (!IsValid(chunk))
+	{
+		return;
+	}
+
+	float density = chunk->NPCSpawnDensity;
+	if (IsValid(mirrorChunk))
+	{
+		density += mirrorChunk->NPCSpawnDensity;
+	}
+	density *= DensityScale;
+
+	// Fractional densities place the extra NPC in that fraction of the chunks
+	const int32 wantedCount = FMath::FloorToInt(density) + (FMath::FRand() < FMath::Frac(density) ? 1 : 0);
+	const int32 npcCount = FMath::Min(wantedCount, MaxSpawnedNPCs - SpawnedNPCCount);
+
+	const FJGSidewalkLane& lane = LevelGenerator->GetSidewalkLane();
+	for (int32 npcIndex = 0; npcIndex < npcCount; npcIndex++)
+	{
+		FVector groundLocation;
+		if (!lane.FindRandomPointInChunk(chunkIndex, groundLocation))
+		{
+			return;
+		}
+
+		const float direction = FMath::RandBool() ? 1.0f : -1.0f;
+		AJGNPC* npc = NPCPool->Acquire(NPCClass, groundLocation, FRotator(0.0f, direction > 0.0f ? 0.0f : 180.0f, 0.0f));
+		if (!npc)
+		{
+			return;
+		}
+
+		npc->MovementDirection = FVector(direction, 0.0f, 0.0f);
+		ChunkNPCs.FindOrAdd(chunkIndex).Add(npc);
+		SpawnedNPCCount++;
+	}
+}
+
+void UJGNPCSpawner::RebucketNPCs()
+{
+	TMap<int32, TArray<TWeakObjectPtr<AJGNPC>>> rebucketedNPCs;
+	for (const TPair<int32, TArray<TWeakObjectPtr<AJGNPC>>>& pair : ChunkNPCs)
+	{
+		for (const TWeakObjectPtr<AJGNPC>& npc : pair.Value)
+		{
+			if (npc.IsValid())
+			{
+				rebucketedNPCs.FindOrAdd(LevelGenerator->FindChunkIndexAt(npc->GetActorLocation().X)).Add(npc);
+			}
+			else
+			{
+				SpawnedNPCCount--;
+			}
+		}
+	}
+
+	ChunkNPCs = MoveTemp(rebucketedNPCs);
+}
+
+void UJGNPCSpawner::ReleaseChunkNPCs(int32 chunkIndex)
+{
+	TArray<TWeakObjectPtr<AJGNPC>> npcs;
+	if (!ChunkNPCs.RemoveAndCopyValue(chunkIndex, npcs))
+	{
+		return;
+	}
+
+	for (const TWeakObjectPtr<AJGNPC>& npc : npcs)
+	{
+		if (npc.IsValid())
+		{
+			NPCPool->Release(npc.Get());
+		}
+	}
+	SpawnedNPCCount -= npcs.Num();
+}
@@ -0,0 +1,364 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Public/JGNavBenchmark.h"
+#include "Public/JGLevelGenerator.h"
+#include "Public/JGNavMeshManager.h"
+#include "Public/JGStreamingGovernor.h"
+#include "Engine/World.h"
+#include "GameFramework/Pawn.h"
+#include "GameFramework/PawnMovementComponent.h"
+#include "HAL/FileManager.h"
+#include "Kismet/GameplayStatics.h"
+#include "Kismet/KismetSystemLibrary.h"
+#include "Misc/App.h"
+#include "Misc/CommandLine.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Parse.h"
+#include "Misc/Paths.h"
+#include "NavigationSystem.h"
+#include "RenderCore.h"
+
+UJGNavBenchmark::UJGNavBenchmark()
+{
+	PrimaryComponentTick.bCanEverTick = true;
+	bWantsInitializeComponent = true;
+	LevelGenerator = nullptr;
+	NavMeshManager = nullptr;
+	StreamingGovernor = nullptr;
+
+	SettleTime = 2.0f;
+	NavReadyTimeout = 30.0f;
+	BackwardStepChance = 0.1f;
+	JumpStepChance = 0.1f;
+
+	IsActive = false;
+	Seed = 1;
+	TransitionCount = 50;
+	BufferIndex = INDEX_NONE;
+	TransitionIndex = 0;
+	SettleRemaining = 0.0f;
+	IsWaitingForNav = false;
+	FromChunkIndex = 0;
+	ToChunkIndex = 0;
+	TransitionStartTime = 0.0;
+	NavSubmitTime = 0.0;
+	StartRequestedTiles = 0;
+	ProcessCpuSeconds = 0.0;
+	GameThreadSeconds = 0.0;
+	RenderThreadSeconds = 0.0;
+}
+
+void UJGNavBenchmark::InitializeComponent()
+{
+	Super::InitializeComponent();
+
+	const TCHAR* commandLine = FCommandLine::Get();
+	IsActive = FParse::Param(commandLine, TEXT("JGNavBenchmark"));
+	if (!IsActive)
+	{
+		return;
+	}
+
+	FParse::Value(commandLine, TEXT("JGNavBenchmarkSeed="), Seed);
+	FParse::Value(commandLine, TEXT("JGNavBenchmarkTransitions="), TransitionCount);
+	TransitionCount = FMath::Max(1, TransitionCount);
+
+	FString buffersString;
+	if (FParse::Value(commandLine, TEXT("JGNavBenchmarkBuffers="), buffersString, false))
+	{
+		TArray<FString> bufferStrings;
+		buffersString.ParseIntoArray(bufferStrings, TEXT(","));
+		for (const FString& bufferString : bufferStrings)
+		{
+			const int32 bufferSize = FCString::Atoi(*bufferString);
+			if (bufferSize > 0)
+			{
+				BufferSizes.Add(bufferSize);
+			}
+		}
+	}
+
+	if (!FParse::Value(commandLine, TEXT("JGNavBenchmarkOut="), OutputPath))
+	{
+		OutputPath = FPaths::ProjectSavedDir() / TEXT("Benchmarks") / TEXT("JGNavBenchmark.csv");
+	}
+
+	// The generator seeds its chunk picks in its own BeginPlay, this runs before it
+	LevelGenerator = GetOwner()->FindComponentByClass<UJGLevelGenerator>();
+	if (IsValid(LevelGenerator))
+	{
+		LevelGenerator->RandomSeed = Seed;
+	}
+}
+
+void UJGNavBenchmark::BeginPlay()
+{
+	Super::BeginPlay();
+
+	if (!IsActive)
+	{
+		SetComponentTickEnabled(false);
+		return;
+	}
+
+	LevelGenerator = GetOwner()->FindComponentByClass<UJGLevelGenerator>();
+	NavMeshManager = GetOwner()->FindComponentByClass<UJGNavMeshManager>();
+	StreamingGovernor = GetOwner()->FindComponentByClass<UJGStreamingGovernor>();
+	if (!IsValid(LevelGenerator) || !IsValid(NavMeshManager))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("JGNavBenchmark: Could not find the level generator or the nav mesh manager!"));
+		IsActive = false;
+		SetComponentTickEnabled(false);
+		return;
+	}
+
+	if (BufferSizes.Num() == 0)
+	{
+		BufferSizes.Add(NavMeshManager->ChunkBufferSize);
+	}
+
+	// The window size is part of what is measured, the governor must not change it from frame time
+	if (IsValid(StreamingGovernor))
+	{
+		StreamingGovernor->SetComponentTickEnabled(false);
+	}
+
+	SettleRemaining = SettleTime;
+
+	UE_LOG(LogTemp, Log, TEXT("JGNavBenchmark: Seed %d, %d transitions per buffer size, %d buffer sizes, writing to %s"),
+		Seed, TransitionCount, BufferSizes.Num(), *OutputPath);
+}
+
+void UJGNavBenchmark::TickComponent(float deltaTime, ELevelTick tickType, FActorComponentTickFunction* thisTickFunction)
+{
+	Super::TickComponent(deltaTime, tickType, thisTickFunction);
+
+	if (!IsActive)
+	{
+		return;
+	}
+
+	if (IsWaitingForNav)
+	{
+		// Process CPU time over the frame, minus the game and render threads, leaves the nav build workers and the rest of the task graph
+		const double frameSeconds = FApp::GetDeltaTime();
+		// Relative to one core: CPUTimePct is divided by the core count, which would bring the worker time down to about nothing
+		ProcessCpuSeconds += FPlatformTime::GetCPUTime().CPUTimePctRelative / 100.0 * frameSeconds;
+		GameThreadSeconds += FPlatformTime::ToSeconds(GGameThreadTime);
+		RenderThreadSeconds += FPlatformTime::ToSeconds(GRenderThreadTime);
+
+		const double now = FPlatformTime::Seconds();
+		if (NavSubmitTime <= 0.0 && !NavMeshManager->IsNavUpdatePending())
+		{
+			NavSubmitTime = now;
+		}
+
+		if (IsNavReady())
+		{
+			FinishTransition(false);
+		}
+		else if (now - TransitionStartTime > NavReadyTimeout)
+		{
+			FinishTransition(true);
+		}
+		return;
+	}
+
+	if (SettleRemaining > 0.0f)
+	{
+		SettleRemaining -= deltaTime;
+		return;
+	}
+
+	if (!IsNavReady() || LevelGenerator->GetActiveChunks().Num() == 0)
+	{
+		return;
+	}
+
+	if (BufferIndex == INDEX_NONE || TransitionIndex >= TransitionCount)
+	{
+		WriteRows();
+
+		BufferIndex++;
+		if (BufferIndex >= BufferSizes.Num())
+		{
+			FinishBenchmark();
+			return;
+		}
+
+		StartBufferSize();
+		return;
+	}
+
+	StartTransition();
+}
+
+void UJGNavBenchmark::StartBufferSize()
+{
+	const int32 bufferSize = BufferSizes[BufferIndex];
+	NavMeshManager->ChunkBufferSize = bufferSize;
+	if (LevelGenerator->GetEffectiveChunksOnEitherSide() < bufferSize)
+	{
+		LevelGenerator->SetEffectiveChunksOnEitherSide(bufferSize);
+	}
+
+	// Every buffer size starts from the same window and streams the same sequence of steps and chunk picks
+	LevelGenerator->SetRandomSeed(Seed);
+	LevelGenerator->RespawnWindow();
+	StepStream.Initialize(Seed);
+	TransitionIndex = 0;
+
+	const int32 currentChunkIndex = LevelGenerator->GetPlayerCurrentChunkIndex();
+	MovePlayerToChunk(currentChunkIndex);
+	NavMeshManager->UpdateNavMeshForChunkRange(currentChunkIndex, NavMeshManager->GetEffectiveBufferSize());
+	SettleRemaining = SettleTime;
+
+	UE_LOG(LogTemp, Log, TEXT("JGNavBenchmark: Buffer size %d (%d effective) from chunk %d"),
+		bufferSize, NavMeshManager->GetEffectiveBufferSize(), currentChunkIndex);
+}
+
+void UJGNavBenchmark::StartTransition()
+{
+	int32 step = 1;
+	const float stepRoll = StepStream.FRand();
+	if (stepRoll < BackwardStepChance)
+	{
+		step = -1;
+	}
+	else if (stepRoll < BackwardStepChance + JumpStepChance)
+	{
+		step = StepStream.RandRange(2, 3);
+	}
+
+	FromChunkIndex = LevelGenerator->GetPlayerCurrentChunkIndex();
+	ToChunkIndex = FromChunkIndex + step;
+
+	StartRequestedTiles = NavMeshManager->GetTotalRebuiltTileCount();
+	NavMeshManager->GetNavMeshTileSalts(StartTileSalts);
+	ProcessCpuSeconds = 0.0;
+	GameThreadSeconds = 0.0;
+	RenderThreadSeconds = 0.0;
+	NavSubmitTime = 0.0;
+	IsWaitingForNav = true;
+	TransitionStartTime = FPlatformTime::Seconds();
+
+	// Chunk spawning happens in here and counts towards the time to nav-ready
+	LevelGenerator->OnPlayerEnteredChunk(ToChunkIndex, FromChunkIndex);
+	MovePlayerToChunk(ToChunkIndex);
+}
+
+void UJGNavBenchmark::FinishTransition(bool timedOut)
+{
+	IsWaitingForNav = false;
+
+	const double now = FPlatformTime::Seconds();
+	const double navReadyMs = (now - TransitionStartTime) * 1000.0;
+	const double submitDelayMs = NavSubmitTime > 0.0 ? (NavSubmitTime - TransitionStartTime) * 1000.0 : navReadyMs;
+	const int32 requestedTiles = NavMeshManager->GetTotalRebuiltTileCount() - StartRequestedTiles;
+
+	// Tiles the navmesh actually (re)built: new since the transition started, or replaced under the same index
+	TMap<int32, uint32> tileSalts;
+	NavMeshManager->GetNavMeshTileSalts(tileSalts);
+	int32 builtTiles = 0;
+	for (const TPair<int32, uint32>& tileSalt : tileSalts)
+	{
+		const uint32* startSalt = StartTileSalts.Find(tileSalt.Key);
+		builtTiles += !startSalt || *startSalt != tileSalt.Value ? 1 : 0;
+	}
+	const double workerCpuMs = FMath::Max(0.0, ProcessCpuSeconds - GameThreadSeconds - RenderThreadSeconds) * 1000.0;
+
+	int32 navTiles = 0;
+	int64 navMemory = 0;
+	NavMeshManager->GetNavMeshTileStats(navTiles, navMemory);
+
+	PendingRows.Add(FString::Printf(TEXT("%s,%d,%d,%d,%d,%d,%.2f,%.2f,%d,%d,%.2f,%.2f,%d,%.1f,%d"),
+		NavMeshManager->GetCoverageMode() == EJGNavCoverageMode::Invokers ? TEXT("Invokers") : TEXT("BoundsVolume"),
+		NavMeshManager->ChunkBufferSize, Seed, TransitionIndex, FromChunkIndex, ToChunkIndex,
+		navReadyMs, submitDelayMs, requestedTiles, builtTiles, workerCpuMs, GameThreadSeconds * 1000.0,
+		navTiles, navMemory / 1024.0, timedOut ? 1 : 0));
+
+	if (timedOut)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("JGNavBenchmark: Navmesh not ready %.0fs after the transition %d -> %d"),
+			NavReadyTimeout, FromChunkIndex, ToChunkIndex);
+	}
+
+	TransitionIndex++;
+}
+
+void UJGNavBenchmark::FinishBenchmark()
+{
+	IsActive = false;
+	SetComponentTickEnabled(false);
+
+	if (IsValid(StreamingGovernor))
+	{
+		StreamingGovernor->SetComponentTickEnabled(true);
+	}
+
+	UE_LOG(LogTemp, Log, TEXT("JGNavBenchmark: Done, results in %s"), *OutputPath);
+
+	UKismetSystemLibrary::QuitGame(GetWorld(), UGameplayStatics::GetPlayerController(GetWorld(), 0), EQuitPreference::Quit, false);
+}
+
+bool UJGNavBenchmark::IsNavReady() const
+{
+	const UNavigationSystemV1* navigationSystem = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld());
+	return !NavMeshManager->IsNavUpdatePending() && (!IsValid(navigationSystem) || !navigationSystem->IsNavigationBuildInProgress());
+}
+
+void UJGNavBenchmark::MovePlayerToChunk(int32 chunkIndex)
+{
+	APawn* pawn = UGameplayStatics::GetPlayerPawn(GetWorld(), 0);
+	if (!IsValid(pawn))
+	{
+		return;
+	}
+
+	// Transitions are driven from here, the pawn must not fall or walk into chunk triggers of its own.
+	// It still follows the transitions so that its nav invoker covers the same chunks as in play.
+	pawn->SetActorEnableCollision(false);
+	if (UPawnMovementComponent* movementComponent = pawn->GetMovementComponent())
+	{
+		movementComponent->Deactivate();
+	}
+
+	for (const FChunkData& chunkData : LevelGenerator->GetActiveChunks())
+	{
+		if (chunkData.IsValid() && chunkData.ChunkActor->ChunkLogicalIndex == chunkIndex)
+		{
+			pawn->SetActorLocation(chunkData.ChunkActor->GetActorLocation() + FVector(chunkData.ActorExtents.X, 0.0f, 100.0f));
+			return;
+		}
+	}
+}
+
+void UJGNavBenchmark::WriteRows()
+{
+	if (PendingRows.Num() == 0)
+	{
+		return;
+	}
+
+	IFileManager& fileManager = IFileManager::Get();
+	fileManager.MakeDirectory(*FPaths::GetPath(OutputPath), true);
+
+	FString text;
+	if (!fileManager.FileExists(*OutputPath))
+	{
+		text += TEXT("Mode,BufferSize,Seed,Transition,FromChunk,ToChunk,NavReadyMs,SubmitDelayMs,RequestedTiles,BuiltTiles,WorkerCpuMs,GameThreadMs,NavTiles,NavMemoryKB,TimedOut");
+		text += LINE_TERMINATOR;
+	}
+
+	for (const FString& row : PendingRows)
+	{
+		text += row;
+		text += LINE_TERMINATOR;
+	}
+	PendingRows.Reset();
+
+	if (!FFileHelper::SaveStringToFile(text, *OutputPath, FFileHelper::EEncodingOptions::ForceAnsi, &fileManager, FILEWRITE_Append))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("JGNavBenchmark: Could not write to %s"), *OutputPath);
+	}
+}
@@ -5,18 +5,62 @@
 #include "Engine/World.h"
 #include "NavigationSystem.h"
 #include "NavMesh/RecastNavMesh.h"
+#include "NavMesh/RecastNavMeshDataChunk.h"
+#include "NavMesh/RecastNavMeshGenerator.h"
 #include "NavMesh/NavMeshBoundsVolume.h"
 #include "Components/ActorComponent.h"
 #include "Components/BrushComponent.h"
+#include "GameFramework/Pawn.h"
+#include "HAL/IConsoleManager.h"
 #include "Kismet/GameplayStatics.h"
+#include "NavigationInvokerComponent.h"
+#include "ProfilingDebugging/CsvProfiler.h"
+#include "JGNPC.h"
+#include "JGNavProjectionCache.h"
+#if WITH_RECAST
+#include "Detour/DetourNavMesh.h"
+#endif
+
+static TAutoConsoleVariable<int32> CVarNavCoverageMode(
+	TEXT("jg.Nav.CoverageMode"),
+	-1,
+	TEXT("Overrides the coverage mode of the nav mesh manager, read when play starts.\n")
+	TEXT("-1 uses the CoverageMode property, 0 slides the bounds volume, 1 builds nav around invokers only."),
+	ECVF_Default);
+
+CSV_DEFINE_CATEGORY(JGNav, true);
 
 UJGNavMeshManager::UJGNavMeshManager()
 {
-	PrimaryComponentTick.bCanEverTick = false;
+	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.bStartWithTickEnabled = false;
+	bWantsInitializeComponent = true;
 	CurrentCenterChunkIndex = 0;
 	NavigationSystem = nullptr;
 	NavMeshBoundsVolume = nullptr;
 	CurrentNavMeshBounds = FBox(ForceInit);
+	LastTransitionTileCount = 0;
+	TotalRebuiltTileCount = 0;
+	ActiveCoverageMode = EJGNavCoverageMode::BoundsVolume;
+	SampledTime = 0.0f;
+	TimeSinceStatsSample = 0.0f;
+	HasPendingNavUpdate = false;
+	PendingCenterChunkIndex = 0;
+	PendingNavUpdateAge = 0.0f;
+	PendingWindowChangeCount = 0;
+	SubmittedNavUpdateCount = 0;
+	SkippedNavUpdateCount = 0;
+	BudgetBufferReduction = 0;
+	HasWarnedOverBudget = false;
+}
+
+void UJGNavMeshManager::InitializeComponent()
+{
+	Super::InitializeComponent();
+
+	const int32 coverageModeOverride = CVarNavCoverageMode.GetValueOnGameThread();
+	ActiveCoverageMode = coverageModeOverride >= 0 ? static_cast<EJGNavCoverageMode>(FMath::Min(coverageModeOverride, 1)) : CoverageMode;
+	CoverageStats.Mode = ActiveCoverageMode;
 }
 
 void UJGNavMeshManager::BeginPlay()
@@ -37,8 +81,21 @@ void UJGNavMeshManager::BeginPlay()
 	// Find the nav mesh bounds volume
 	FindNavMeshBoundsVolume();
 
+	NavTileGrid = FJGNavTileGrid::FromWorld(GetWorld());
+
+	if (ActiveCoverageMode == EJGNavCoverageMode::Invokers)
+	{
+		if (!NavigationSystem->IsActiveTilesGenerationEnabled())
+		{
+			UE_LOG(LogTemp, Warning, TEXT("JGNavMeshManager: Invoker coverage needs Generate Navigation Only Around Navigation Invokers, nav will be built over the whole window"));
+		}
+		UpdateInvokers();
+	}
+
 	// Initialize nav mesh for starting chunks
-	UpdateNavMeshForChunkRange(CurrentCenterChunkIndex, ChunkBufferSize);
+	UpdateNavMeshForChunkRange(CurrentCenterChunkIndex, GetCoverageBufferSize());
+
+	UpdateTickInterval();
 }
 
 void UJGNavMeshManager::EndPlay(const EEndPlayReason::Type EndPlayReason)
@@ -46,12 +103,93 @@ void UJGNavMeshManager::EndPlay(const EEndPlayReason::Type EndPlayReason)
 	// Unbind from level generator if bound
 	if (IsValid(LevelGenerator))
 	{
-		LevelGenerator->OnPlayerEnteredChunkDelegate.RemoveDynamic(this, &UJGNavMeshManager::OnPlayerEnteredChunk);
+		LevelGenerator->OnChunkWindowChanged().RemoveAll(this);
+	}
+
+	for (const TPair<int32, URecastNavMeshDataChunk*>& attachedTiles : AttachedNavTiles)
+	{
+		DetachChunkNavTiles(attachedTiles.Value);
+	}
+	AttachedNavTiles.Reset();
+
+	HasPendingNavUpdate = false;
+	PendingAddedChunks.Reset();
+	PendingRemovedChunks.Reset();
+
+	for (UNavigationInvokerComponent* invoker : AddedInvokers)
+	{
+		if (IsValid(invoker))
+		{
+			invoker->Deactivate();
+			invoker->DestroyComponent();
+		}
+	}
+	AddedInvokers.Reset();
+
+	if (SampledTime > 0.0f)
+	{
+		UE_LOG(LogTemp, Log, TEXT("JGNavMeshManager: %s coverage built %d tiles in %.1fs (%.2f tiles/s), %d tiles and %.0fKB at the end, %.0fKB peak"),
+			ActiveCoverageMode == EJGNavCoverageMode::Invokers ? TEXT("Invoker") : TEXT("Bounds volume"),
+			CoverageStats.TotalTilesBuilt, SampledTime, CoverageStats.AverageTilesBuiltPerSecond,
+			CoverageStats.TileCount, CoverageStats.MemoryKB, CoverageStats.PeakMemoryKB);
+	}
+
+	// A long session should end with about the memory it had once the window filled
+	if (NavMemoryHistory.Num() > 1)
+	{
+		const FJGNavMemorySample& firstSample = NavMemoryHistory[0];
+		const FJGNavMemorySample& lastSample = NavMemoryHistory.Last();
+		UE_LOG(LogTemp, Log, TEXT("JGNavMeshManager: Nav memory %.0fKB (%d tiles) at %.0fs, %.0fKB (%d tiles) at %.0fs, %d tiles evicted"),
+			firstSample.MemoryKB, firstSample.TileCount, firstSample.Time, lastSample.MemoryKB, lastSample.TileCount, lastSample.Time,
+			CoverageStats.TotalTilesEvicted);
 	}
 
 	Super::EndPlay(EndPlayReason);
 }
 
+void UJGNavMeshManager::TickComponent(float deltaTime, ELevelTick tickType, FActorComponentTickFunction* thisTickFunction)
+{
+	Super::TickComponent(deltaTime, tickType, thisTickFunction);
+
+	if (HasPendingNavUpdate)
+	{
+		PendingNavUpdateAge += deltaTime;
+		if (ShouldFlushPendingNavUpdate())
+		{
+			FlushPendingNavUpdate();
+		}
+	}
+
+	TimeSinceStatsSample += deltaTime;
+	const float sampleInterval = GetSampleInterval();
+	if (sampleInterval > 0.0f && TimeSinceStatsSample >= sampleInterval)
+	{
+		// The player may be possessed or respawned after play starts
+		if (ActiveCoverageMode == EJGNavCoverageMode::Invokers)
+		{
+			UpdateInvokers();
+		}
+
+		EvictTilesOutsideCoverage();
+		SampleCoverageStats(TimeSinceStatsSample);
+		ApplyNavMemoryBudget();
+		TimeSinceStatsSample = 0.0f;
+	}
+
+	UpdateTickInterval();
+}
+
+void UJGNavMeshManager::UpdateTickInterval()
+{
+	const float sampleInterval = GetSampleInterval();
+	const bool shouldTick = HasPendingNavUpdate || sampleInterval > 0.0f;
+	SetComponentTickInterval(HasPendingNavUpdate ? 0.0f : sampleInterval);
+	if (IsComponentTickEnabled() != shouldTick)
+	{
+		SetComponentTickEnabled(shouldTick);
+	}
+}
+
 void UJGNavMeshManager::FindAndBindToLevelGenerator()
 {
 	// Look for level generator in the same actor first
@@ -60,7 +198,17 @@ void UJGNavMeshManager::FindAndBindToLevelGenerator()
 	if (IsValid(levelGenerator))
 	{
 		LevelGenerator = levelGenerator;
-		LevelGenerator->OnPlayerEnteredChunkDelegate.AddDynamic(this, &UJGNavMeshManager::OnPlayerEnteredChunk);
+		LevelGenerator->OnChunkWindowChanged().AddUObject(this, &UJGNavMeshManager::OnChunkWindowChanged);
+
+		// Chunks spawned before we bound
+		for (const FChunkData& chunkData : LevelGenerator->GetActiveChunks())
+		{
+			if (chunkData.IsValid())
+			{
+				ChunkBounds.Add(chunkData.ChunkActor->ChunkLogicalIndex, chunkData.NavBounds);
+			}
+		}
+
 		UE_LOG(LogTemp, Log, TEXT("JGNavMeshManager: Successfully found and bound to level generator"));
 	}
 	else
@@ -91,20 +239,165 @@ void UJGNavMeshManager::FindNavMeshBoundsVolume()
 	}
 }
 
-void UJGNavMeshManager::OnPlayerEnteredChunk(int32 newChunkIndex, int32 previousChunkIndex)
+void UJGNavMeshManager::OnChunkWindowChanged(const FJGChunkWindowChange& windowChange)
 {
+	// All of them first, tiles shared by two removed chunks are evicted with either
+	for (const FJGChunkWindowEntry& removedEntry : windowChange.RemovedChunks)
+	{
+		ChunkBounds.Remove(removedEntry.LogicalIndex);
+	}
+
+	for (const FJGChunkWindowEntry& removedEntry : windowChange.RemovedChunks)
+	{
+		// Attached tiles belong to the chunk about to be destroyed, they are detached right away instead of rebuilt
+		URecastNavMeshDataChunk* navTiles = nullptr;
+		if (AttachedNavTiles.RemoveAndCopyValue(removedEntry.LogicalIndex, navTiles))
+		{
+			DetachChunkNavTiles(navTiles);
+			continue;
+		}
+
+		// Generated tiles are removed right away too, only the ones shared with a resident chunk wait for a rebuild
+		const bool wasPendingAdd = PendingAddedChunks.Remove(removedEntry.LogicalIndex) > 0;
+		const int32 sharedTileCount = EvictChunkNavTiles(removedEntry.NavBounds);
+		if (sharedTileCount > 0 && (!wasPendingAdd || PendingRemovedChunks.Contains(removedEntry.LogicalIndex)))
+		{
+			PendingRemovedChunks.Add(removedEntry.LogicalIndex, removedEntry.NavBounds);
+		}
+	}
+
+	for (const FJGChunkWindowEntry& addedEntry : windowChange.AddedChunks)
+	{
+		ChunkBounds.Add(addedEntry.LogicalIndex, addedEntry.NavBounds);
+		PendingAddedChunks.Add(addedEntry.LogicalIndex, addedEntry);
+	}
+
 	if (!IsValid(NavigationSystem) || !IsValid(LevelGenerator))
 	{
 		return;
 	}
 
-	UE_LOG(LogTemp, Log, TEXT("JGNavMeshManager: Player entered chunk %d (from %d)"), newChunkIndex, previousChunkIndex);
+	UE_LOG(LogTemp, Log, TEXT("JGNavMeshManager: Player entered chunk %d (from %d), %d chunks added, %d removed"),
+		windowChange.CenterChunkIndex, windowChange.PreviousCenterChunkIndex, windowChange.AddedChunks.Num(), windowChange.RemovedChunks.Num());
+
+	// Rapid back and forth or multi-chunk jumps end up in a single update for the last center
+	PendingCenterChunkIndex = windowChange.CenterChunkIndex;
+	PendingWindowChangeCount++;
+	if (!HasPendingNavUpdate)
+	{
+		HasPendingNavUpdate = true;
+		PendingNavUpdateAge = 0.0f;
+	}
+
+	if (NavUpdateCoalesceTime <= 0.0f)
+	{
+		FlushPendingNavUpdate();
+	}
+
+	UpdateTickInterval();
+}
+
+bool UJGNavMeshManager::ShouldFlushPendingNavUpdate() const
+{
+	if (PendingNavUpdateAge < NavUpdateCoalesceTime)
+	{
+		return false;
+	}
+
+	// Hold on while the previous update is building, its tiles might be made obsolete by the next change anyway
+	return PendingNavUpdateAge >= MaxNavUpdateDelay || !IsValid(NavigationSystem) || !NavigationSystem->IsNavigationBuildInProgress();
+}
+
+void UJGNavMeshManager::FlushPendingNavUpdate()
+{
+	if (!HasPendingNavUpdate)
+	{
+		return;
+	}
+
+	HasPendingNavUpdate = false;
+	const int32 windowChangeCount = PendingWindowChangeCount;
+	PendingWindowChangeCount = 0;
+
+	TMap<int32, FJGChunkWindowEntry> addedChunks = MoveTemp(PendingAddedChunks);
+	TMap<int32, FBox> removedChunks = MoveTemp(PendingRemovedChunks);
+	PendingAddedChunks.Reset();
+	PendingRemovedChunks.Reset();
+
+	if (!IsValid(NavigationSystem) || !IsValid(LevelGenerator))
+	{
+		return;
+	}
 
 	// Update center chunk index to the new player chunk
-	CurrentCenterChunkIndex = newChunkIndex;
+	CurrentCenterChunkIndex = PendingCenterChunkIndex;
+
+	TSet<FIntPoint> rebuiltTiles;
+
+	// Slide the volume first, the chunk areas are then clipped to the new bounds
+	bool boundsChanged = false;
+	FBox newBounds = CalculateNavMeshBounds(CurrentCenterChunkIndex, GetCoverageBufferSize());
+	if (newBounds.IsValid)
+	{
+		boundsChanged = UpdateNavMeshBounds(NavTileGrid.SnapToTiles(newBounds), rebuiltTiles);
+	}
+
+	// Chunks that changed inside the volume, tiles of the chunks that did not are kept.
+	// Chunks with baked tiles are left out of generation, their tiles are attached and detached instead.
+	for (const TPair<int32, FJGChunkWindowEntry>& addedChunk : addedChunks)
+	{
+		const AJGChunk* chunk = addedChunk.Value.ChunkActor.Get();
+		if (!LevelGenerator->ShouldAttachBakedNavTiles(chunk))
+		{
+			DirtyChunkArea(addedChunk.Value.NavBounds, rebuiltTiles);
+		}
+	}
+
+	for (const TPair<int32, FBox>& removedChunk : removedChunks)
+	{
+		DirtyChunkArea(removedChunk.Value, rebuiltTiles);
+	}
 
-	// Update nav mesh for the new chunk range
-	UpdateNavMeshForChunkRange(CurrentCenterChunkIndex, ChunkBufferSize);
+	UpdateBakedNavTiles();
+
+	if (ActiveCoverageMode == EJGNavCoverageMode::Invokers)
+	{
+		UpdateInvokers();
+	}
+
+	if (!boundsChanged && rebuiltTiles.Num() == 0)
+	{
+		SkippedNavUpdateCount++;
+		UE_LOG(LogTemp, Log, TEXT("JGNavMeshManager: Skipped nav update for chunk %d, coverage unchanged after %d window changes"),
+			CurrentCenterChunkIndex, windowChangeCount);
+		return;
+	}
+
+	SubmittedNavUpdateCount++;
+	UE_LOG(LogTemp, Log, TEXT("JGNavMeshManager: Merged %d window changes into one nav update for chunk %d"), windowChangeCount, CurrentCenterChunkIndex);
+	ReportRebuiltTiles(rebuiltTiles, CurrentCenterChunkIndex);
+}
+
+int32 UJGNavMeshManager::GetEffectiveBufferSize() const
+{
+	if (!IsValid(LevelGenerator))
+	{
+		return ChunkBufferSize;
+	}
+
+	// The streaming window can shrink below the nav buffer, never cover chunks that are not there
+	return FMath::Max(1, FMath::Min(ChunkBufferSize, LevelGenerator->GetEffectiveChunksOnEitherSide()) - BudgetBufferReduction);
+}
+
+int32 UJGNavMeshManager::GetCoverageBufferSize() const
+{
+	// The invokers decide which tiles get built, the volume only has to contain every chunk they can walk on
+	if (ActiveCoverageMode == EJGNavCoverageMode::Invokers && IsValid(LevelGenerator))
+	{
+		return FMath::Max(1, LevelGenerator->GetEffectiveChunksOnEitherSide() - BudgetBufferReduction);
+	}
+
+	return GetEffectiveBufferSize();
 }
 
 void UJGNavMeshManager::UpdateNavMeshForChunkRange(int32 centerChunkIndex, int32 bufferSize)
@@ -120,7 +413,10 @@ void UJGNavMeshManager::UpdateNavMeshForChunkRange(int32 centerChunkIndex, int32
 	
 	if (newBounds.IsValid)
 	{
-		UpdateNavMeshBounds(newBounds);
+		TSet<FIntPoint> rebuiltTiles;
+		UpdateNavMeshBounds(NavTileGrid.SnapToTiles(newBounds), rebuiltTiles);
+		UpdateBakedNavTiles();
+		ReportRebuiltTiles(rebuiltTiles, centerChunkIndex);
 		UE_LOG(LogTemp, Log, TEXT("JGNavMeshManager: Updated nav mesh for chunk range [%d] with buffer %d"), 
 			centerChunkIndex, bufferSize);
 	}
@@ -137,15 +433,74 @@ FBox UJGNavMeshManager::CalculateNavMeshBounds(int32 centerChunkIndex, int32 buf
 		return FBox(ForceInit);
 	}
 
-	// Use the level generator's improved bounds calculation
+	// Bounds tracked from the window changes, without going back to the generator's chunks
+	FBox rangeBounds(ForceInit);
+	for (int32 chunkIndex = centerChunkIndex - bufferSize; chunkIndex <= centerChunkIndex + bufferSize; chunkIndex++)
+	{
+		if (const FBox* chunkBounds = ChunkBounds.Find(chunkIndex))
+		{
+			rangeBounds += *chunkBounds;
+		}
+	}
+
+	if (rangeBounds.IsValid)
+	{
+		return rangeBounds;
+	}
+
+	// Fall back on the level generator's estimation when the range is not resident
 	return LevelGenerator->GetChunkRangeBounds(centerChunkIndex, bufferSize);
 }
 
-void UJGNavMeshManager::UpdateNavMeshBounds(const FBox& newBounds)
+bool UJGNavMeshManager::UpdateNavMeshBounds(const FBox& newBounds, TSet<FIntPoint>& rebuiltTiles)
 {
 	if (!IsValid(NavigationSystem))
 	{
-		return;
+		return false;
+	}
+
+	// The volume is snapped to the tile grid, so it only moves when the range gains or loses a tile
+	if (newBounds.Equals(CurrentNavMeshBounds, 1.0f))
+	{
+		return false;
+	}
+
+	// The tiles entering the volume are the ones the move needs. Whether the navmesh keeps the others is up to the
+	// engine's handling of the old and new volume bounds, so this count is what was requested, not what gets built.
+	if (NavTileGrid.IsValid())
+	{
+		const FIntRect previousRange = CurrentNavMeshBounds.IsValid ? NavTileGrid.GetTileRange(CurrentNavMeshBounds) : FIntRect(0, 0, -1, -1);
+		const FIntRect newRange = NavTileGrid.GetTileRange(newBounds);
+		for (int32 tileX = newRange.Min.X; tileX <= newRange.Max.X; tileX++)
+		{
+			for (int32 tileY = newRange.Min.Y; tileY <= newRange.Max.Y; tileY++)
+			{
+				const bool wasInside = CurrentNavMeshBounds.IsValid
+					&& tileX >= previousRange.Min.X && tileX <= previousRange.Max.X
+					&& tileY >= previousRange.Min.Y && tileY <= previousRange.Max.Y;
+				if (!wasInside)
+				{
+					rebuiltTiles.Add(FIntPoint(tileX, tileY));
+				}
+			}
+		}
+
+		// Builds still queued or running for the tiles leaving the volume would only be thrown away
+		TArray<FIntPoint> leavingTiles;
+		if (CurrentNavMeshBounds.IsValid)
+		{
+			for (int32 tileX = previousRange.Min.X; tileX <= previousRange.Max.X; tileX++)
+			{
+				for (int32 tileY = previousRange.Min.Y; tileY <= previousRange.Max.Y; tileY++)
+				{
+					if (tileX < newRange.Min.X || tileX > newRange.Max.X || tileY < newRange.Min.Y || tileY > newRange.Max.Y)
+					{
+						leavingTiles.Add(FIntPoint(tileX, tileY));
+					}
+				}
+			}
+		}
+		CancelTileBuilds(leavingTiles);
 	}
 
 	CurrentNavMeshBounds = newBounds;
@@ -174,20 +529,550 @@ void UJGNavMeshManager::UpdateNavMeshBounds(const FBox& newBounds)
 			UE_LOG(LogTemp, Log, TEXT("JGNavMeshManager: Updated NavMeshBoundsVolume - Center: %s, Scale: %s"), 
 				*center.ToString(), *newScale.ToString());
 		}
-
-		// Request nav mesh rebuild for the specified bounds
-		NavigationSystem->AddDirtyArea(newBounds, ENavigationDirtyFlag::All);
-		NavigationSystem->OnNavigationBoundsUpdated(NavMeshBoundsVolume);
-		
-		UE_LOG(LogTemp, Log, TEXT("JGNavMeshManager: Requested nav mesh rebuild for bounds: %s"), 
-			*newBounds.ToString());
 	}
 	else
 	{
 		UE_LOG(LogTemp, Warning, TEXT("JGNavMeshManager: No NavMeshBoundsVolume available for resizing"));
 		
-		// Fallback: just request dirty area rebuild
+		// Fallback: without a volume to slide, rebuild the whole range
 		NavigationSystem->AddDirtyArea(newBounds, ENavigationDirtyFlag::All);
-		NavigationSystem->OnNavigationBoundsUpdated(NavMeshBoundsVolume);
+		AddTiles(newBounds, rebuiltTiles);
 	}
-}
\ No newline at end of file
+
+	return true;
+}
+
+void UJGNavMeshManager::CancelTileBuilds(const TArray<FIntPoint>& tiles)
+{
+#if WITH_RECAST
+	ARecastNavMesh* navMesh = IsValid(NavigationSystem) ? Cast<ARecastNavMesh>(NavigationSystem->GetDefaultNavDataInstance()) : nullptr;
+	if (tiles.Num() == 0 || !IsValid(navMesh))
+	{
+		return;
+	}
+
+	// The tile grid counts along the world axes, Recast along its own
+	TArray<FIntPoint> recastTiles;
+	recastTiles.Reserve(tiles.Num());
+	for (const FIntPoint& tile : tiles)
+	{
+		FIntPoint recastTile;
+		if (NavTileGrid.GetRecastTile(navMesh, tile, recastTile))
+		{
+			recastTiles.AddUnique(recastTile);
+		}
+	}
+
+	// The tiles are outside the volume anyway
+	RemoveNavTiles(recastTiles);
+#endif
+}
+
+void UJGNavMeshManager::RemoveNavTiles(const TArray<FIntPoint>& recastTiles)
+{
+#if WITH_RECAST
+	ARecastNavMesh* navMesh = IsValid(NavigationSystem) ? Cast<ARecastNavMesh>(NavigationSystem->GetDefaultNavDataInstance()) : nullptr;
+	if (recastTiles.Num() == 0 || !IsValid(navMesh))
+	{
+		return;
+	}
+
+	// Projections onto the removed tiles would point at polygons that are gone, read their bounds while the tiles still exist
+	if (UJGNavProjectionCache* projectionCache = GetWorld()->GetSubsystem<UJGNavProjectionCache>())
+	{
+		TArray<int32> tileIndices;
+		for (const FIntPoint& recastTile : recastTiles)
+		{
+			tileIndices.Reset();
+			navMesh->GetNavMeshTilesAt(recastTile.X, recastTile.Y, tileIndices);
+			for (const int32 tileIndex : tileIndices)
+			{
+				FBox tileBounds(ForceInit);
+				if (navMesh->GetNavMeshTileBounds(tileIndex, tileBounds) && tileBounds.IsValid)
+				{
+					tileBounds.Min.Z = -UE_BIG_NUMBER;
+					tileBounds.Max.Z = UE_BIG_NUMBER;
+					projectionCache->InvalidateArea(tileBounds);
+				}
+			}
+		}
+	}
+
+	// Removes the built tiles and the pending dirty ones, and marks the running builds to be discarded
+	if (FRecastNavMeshGenerator* generator = static_cast<FRecastNavMeshGenerator*>(navMesh->GetGenerator()))
+	{
+		generator->RemoveTiles(recastTiles);
+	}
+#endif
+}
+
+int32 UJGNavMeshManager::EvictChunkNavTiles(const FBox& navBounds)
+{
+	int32 sharedTileCount = 0;
+#if WITH_RECAST
+	ARecastNavMesh* navMesh = IsValid(NavigationSystem) ? Cast<ARecastNavMesh>(NavigationSystem->GetDefaultNavDataInstance()) : nullptr;
+	if (!navBounds.IsValid || !IsValid(navMesh))
+	{
+		return 0;
+	}
+
+	auto overlapsXY = [](const FBox& a, const FBox& b)
+	{
+		return a.Min.X < b.Max.X && a.Max.X > b.Min.X && a.Min.Y < b.Max.Y && a.Max.Y > b.Min.Y;
+	};
+
+	// Tiles strictly inside the chunk's columns, the neighbouring columns only touch its edges
+	TArray<int32> tileIndices;
+	navMesh->GetNavMeshTilesIn({ navBounds.ExpandBy(FVector(-1.0f, -1.0f, 0.0f)) }, tileIndices);
+
+	TArray<FIntPoint> evictedTiles;
+	int32 evictedLayerCount = 0;
+	for (const int32 tileIndex : tileIndices)
+	{
+		const FBox tileBounds = navMesh->GetNavMeshTileBounds(tileIndex);
+		bool isShared = false;
+		for (const TPair<int32, FBox>& chunkBounds : ChunkBounds)
+		{
+			if (overlapsXY(tileBounds, chunkBounds.Value))
+			{
+				isShared = true;
+				break;
+			}
+		}
+
+		int32 tileX = 0;
+		int32 tileY = 0;
+		int32 tileLayer = 0;
+		if (isShared)
+		{
+			sharedTileCount++;
+		}
+		else if (navMesh->GetNavMeshTileXY(tileIndex, tileX, tileY, tileLayer))
+		{
+			evictedTiles.AddUnique(FIntPoint(tileX, tileY));
+			evictedLayerCount++;
+		}
+	}
+
+	RemoveNavTiles(evictedTiles);
+	CoverageStats.TotalTilesEvicted += evictedLayerCount;
+#endif
+	return sharedTileCount;
+}
+
+void UJGNavMeshManager::EvictTilesOutsideCoverage()
+{
+#if WITH_RECAST
+	ARecastNavMesh* navMesh = IsValid(NavigationSystem) ? Cast<ARecastNavMesh>(NavigationSystem->GetDefaultNavDataInstance()) : nullptr;
+	const dtNavMesh* detourMesh = IsValid(navMesh) ? navMesh->GetRecastMesh() : nullptr;
+	if (!detourMesh || !CurrentNavMeshBounds.IsValid)
+	{
+		return;
+	}
+
+	// Tiles left behind by the volume or by a chunk that was never evicted, the navmesh would keep them for the session
+	const FBox coverage = CurrentNavMeshBounds.ExpandBy(FVector(-1.0f, -1.0f, 0.0f));
+	TArray<FIntPoint> orphanTiles;
+	int32 orphanLayerCount = 0;
+	for (int32 tileIndex = 0; tileIndex < detourMesh->getMaxTiles(); tileIndex++)
+	{
+		const dtMeshTile* tile = detourMesh->getTile(tileIndex);
+		if (!tile || !tile->header)
+		{
+			continue;
+		}
+
+		const FBox tileBounds = navMesh->GetNavMeshTileBounds(tileIndex);
+		if (tileBounds.Min.X >= coverage.Max.X || tileBounds.Max.X <= coverage.Min.X || tileBounds.Min.Y >= coverage.Max.Y || tileBounds.Max.Y <= coverage.Min.Y)
+		{
+			orphanTiles.AddUnique(FIntPoint(tile->header->x, tile->header->y));
+			orphanLayerCount++;
+		}
+	}
+
+	if (orphanTiles.Num() > 0)
+	{
+		RemoveNavTiles(orphanTiles);
+		CoverageStats.TotalTilesEvicted += orphanLayerCount;
+		UE_LOG(LogTemp, Log, TEXT("JGNavMeshManager: Evicted %d nav tiles outside the coverage"), orphanLayerCount);
+	}
+#endif
+}
+
+void UJGNavMeshManager::DirtyChunkArea(const FBox& chunkBounds, TSet<FIntPoint>& rebuiltTiles)
+{
+	if (!IsValid(NavigationSystem) || !chunkBounds.IsValid || !CurrentNavMeshBounds.IsValid || !chunkBounds.Intersect(CurrentNavMeshBounds))
+	{
+		return;
+	}
+
+	const FBox dirtyArea = chunkBounds.Overlap(CurrentNavMeshBounds);
+	NavigationSystem->AddDirtyArea(dirtyArea, ENavigationDirtyFlag::All);
+	AddTiles(dirtyArea, rebuiltTiles);
+}
+
+void UJGNavMeshManager::AddTiles(const FBox& bounds, TSet<FIntPoint>& tiles) const
+{
+	if (!NavTileGrid.IsValid() || !bounds.IsValid)
+	{
+		return;
+	}
+
+	const FIntRect range = NavTileGrid.GetTileRange(bounds);
+	for (int32 tileX = range.Min.X; tileX <= range.Max.X; tileX++)
+	{
+		for (int32 tileY = range.Min.Y; tileY <= range.Max.Y; tileY++)
+		{
+			tiles.Add(FIntPoint(tileX, tileY));
+		}
+	}
+}
+
+void UJGNavMeshManager::UpdateBakedNavTiles()
+{
+	if (!IsValid(LevelGenerator))
+	{
+		return;
+	}
+
+	UJGNavProjectionCache* projectionCache = GetWorld()->GetSubsystem<UJGNavProjectionCache>();
+	const int32 bufferSize = GetEffectiveBufferSize();
+	auto isInNavRange = [this, bufferSize](int32 chunkIndex)
+	{
+		return FMath::Abs(chunkIndex - CurrentCenterChunkIndex) <= bufferSize;
+	};
+
+	// Chunks about to be destroyed are still in the window during the broadcast, so detach on the nav range alone
+	for (auto it = AttachedNavTiles.CreateIterator(); it; ++it)
+	{
+		if (!isInNavRange(it.Key()))
+		{
+			DetachChunkNavTiles(it.Value());
+			const FBox* chunkBounds = ChunkBounds.Find(it.Key());
+			if (projectionCache && chunkBounds)
+			{
+				projectionCache->InvalidateArea(*chunkBounds);
+			}
+			it.RemoveCurrent();
+		}
+	}
+
+	if (!LevelGenerator->ShouldUsePrebakedNavTiles())
+	{
+		return;
+	}
+
+	for (const FChunkData& chunkData : LevelGenerator->GetActiveChunks())
+	{
+		if (!chunkData.IsValid())
+		{
+			continue;
+		}
+
+		const int32 chunkIndex = chunkData.ChunkActor->ChunkLogicalIndex;
+		if (isInNavRange(chunkIndex) && !AttachedNavTiles.Contains(chunkIndex) && LevelGenerator->ShouldAttachBakedNavTiles(chunkData.ChunkActor))
+		{
+			AttachChunkNavTiles(chunkData.ChunkActor, chunkIndex);
+		}
+	}
+}
+
+bool UJGNavMeshManager::AttachChunkNavTiles(AJGChunk* chunk, int32 chunkIndex)
+{
+#if WITH_RECAST
+	ARecastNavMesh* navMesh = IsValid(NavigationSystem) ? Cast<ARecastNavMesh>(NavigationSystem->GetDefaultNavDataInstance()) : nullptr;
+	if (!IsValid(navMesh) || !navMesh->GetRecastNavMeshImpl())
+	{
+		return false;
+	}
+
+	// The offset is taken in Recast's tile coordinates, which do not follow the world axes
+	FIntPoint chunkTile;
+	if (!NavTileGrid.GetRecastTile(navMesh, NavTileGrid.GetTileCoord(chunk->GetActorLocation() + FVector(NavTileGrid.TileSize * 0.5f, 0.0f, 0.0f)), chunkTile))
+	{
+		return false;
+	}
+
+	// The baked tiles are shared by every chunk of the class, move a copy
+	URecastNavMeshDataChunk* navTiles = DuplicateObject<URecastNavMeshDataChunk>(chunk->BakedNavTiles, this);
+	navTiles->MoveTiles(*navMesh->GetRecastNavMeshImpl(), chunkTile - chunk->BakedNavTileOrigin, 0.0f, FVector2D::ZeroVector);
+
+	// Drop what dynamic generation built or queued there, a build already running can still replace an attached tile.
+	// Tiles strictly inside the chunk's columns, the neighbours' attached tiles only touch its edges.
+	if (FRecastNavMeshGenerator* generator = static_cast<FRecastNavMeshGenerator*>(navMesh->GetGenerator()))
+	{
+		TArray<FIntPoint> recastTiles;
+		if (const FBox* chunkBounds = ChunkBounds.Find(chunkIndex))
+		{
+			NavTileGrid.GetRecastTiles(navMesh, NavTileGrid.GetTileRange(chunkBounds->ExpandBy(FVector(-1.0f, -1.0f, 0.0f))), recastTiles);
+		}
+		generator->RemoveTiles(recastTiles);
+	}
+
+	navTiles->AttachTiles(*navMesh);
+	AttachedNavTiles.Add(chunkIndex, navTiles);
+
+	// Attached tiles are usable right away
+	UJGNavProjectionCache* projectionCache = GetWorld()->GetSubsystem<UJGNavProjectionCache>();
+	const FBox* chunkBounds = ChunkBounds.Find(chunkIndex);
+	if (projectionCache && chunkBounds)
+	{
+		projectionCache->InvalidateArea(*chunkBounds);
+	}
+	return true;
+#else
+	return false;
+#endif
+}
+
+void UJGNavMeshManager::DetachChunkNavTiles(URecastNavMeshDataChunk* navTiles)
+{
+#if WITH_RECAST
+	ARecastNavMesh* navMesh = IsValid(NavigationSystem) ? Cast<ARecastNavMesh>(NavigationSystem->GetDefaultNavDataInstance()) : nullptr;
+	if (IsValid(navMesh) && IsValid(navTiles))
+	{
+		navTiles->DetachTiles(*navMesh);
+	}
+#endif
+}
+
+void UJGNavMeshManager::ReportRebuiltTiles(const TSet<FIntPoint>& rebuiltTiles, int32 centerChunkIndex)
+{
+	LastTransitionTileCount = rebuiltTiles.Num();
+	TotalRebuiltTileCount += LastTransitionTileCount;
+
+	// Projections on these tiles are stale until the navmesh finished building them
+	UJGNavProjectionCache* projectionCache = GetWorld()->GetSubsystem<UJGNavProjectionCache>();
+	if (projectionCache && NavTileGrid.IsValid())
+	{
+		for (const FIntPoint& tile : rebuiltTiles)
+		{
+			const FVector tileMin(NavTileGrid.Origin.X + tile.X * NavTileGrid.TileSize, NavTileGrid.Origin.Y + tile.Y * NavTileGrid.TileSize, -UE_BIG_NUMBER);
+			projectionCache->MarkAreaRebuilding(FBox(tileMin, tileMin + FVector(NavTileGrid.TileSize, NavTileGrid.TileSize, 2.0 * UE_BIG_NUMBER)));
+		}
+	}
+
+	UE_LOG(LogTemp, Log, TEXT("JGNavMeshManager: Chunk %d requested %d tile rebuilds (%d since start, %d tiles in the volume)"),
+		centerChunkIndex, LastTransitionTileCount, TotalRebuiltTileCount, NavTileGrid.CountTiles(CurrentNavMeshBounds));
+}
+
+void UJGNavMeshManager::UpdateInvokers()
+{
+	UWorld* world = GetWorld();
+	if (!IsValid(world))
+	{
+		return;
+	}
+
+	TArray<AActor*, TInlineAllocator<3>> invokerActors;
+	invokerActors.Add(UGameplayStatics::GetPlayerPawn(world, 0));
+	if (IsValid(LevelGenerator))
+	{
+		invokerActors.Add(LevelGenerator->GetFrontActor());
+		invokerActors.Add(LevelGenerator->GetBackActor());
+	}
+
+	AddedInvokers.RemoveAll([](const UNavigationInvokerComponent* invoker) { return !IsValid(invoker); });
+
+	for (AActor* actor : invokerActors)
+	{
+		// Actors set up as invokers in their blueprint keep their own radii
+		if (!IsValid(actor) || actor->FindComponentByClass<UNavigationInvokerComponent>())
+		{
+			continue;
+		}
+
+		UNavigationInvokerComponent* invoker = NewObject<UNavigationInvokerComponent>(actor, TEXT("JGNavInvoker"));
+		invoker->SetGenerationRadii(InvokerGenerationRadius, FMath::Max(InvokerGenerationRadius, InvokerRemovalRadius));
+		invoker->RegisterComponent();
+		AddedInvokers.Add(invoker);
+
+		UE_LOG(LogTemp, Log, TEXT("JGNavMeshManager: Registered %s as navigation invoker"), *actor->GetName());
+	}
+}
+
+void UJGNavMeshManager::GetNavMeshTileStats(int32& outTileCount, int64& outMemory) const
+{
+	outTileCount = 0;
+	outMemory = 0;
+
+#if WITH_RECAST
+	const ARecastNavMesh* navMesh = IsValid(NavigationSystem) ? Cast<ARecastNavMesh>(NavigationSystem->GetDefaultNavDataInstance()) : nullptr;
+	const dtNavMesh* detourMesh = IsValid(navMesh) ? navMesh->GetRecastMesh() : nullptr;
+	if (!detourMesh)
+	{
+		return;
+	}
+
+	for (int32 tileIndex = 0; tileIndex < detourMesh->getMaxTiles(); tileIndex++)
+	{
+		const dtMeshTile* tile = detourMesh->getTile(tileIndex);
+		if (tile && tile->header)
+		{
+			outTileCount++;
+			outMemory += tile->dataSize;
+		}
+	}
+#endif
+}
+
+void UJGNavMeshManager::GetNavMeshTileSalts(TMap<int32, uint32>& outTileSalts) const
+{
+	outTileSalts.Reset();
+
+#if WITH_RECAST
+	const ARecastNavMesh* navMesh = IsValid(NavigationSystem) ? Cast<ARecastNavMesh>(NavigationSystem->GetDefaultNavDataInstance()) : nullptr;
+	const dtNavMesh* detourMesh = IsValid(navMesh) ? navMesh->GetRecastMesh() : nullptr;
+	if (!detourMesh)
+	{
+		return;
+	}
+
+	for (int32 tileIndex = 0; tileIndex < detourMesh->getMaxTiles(); tileIndex++)
+	{
+		const dtMeshTile* tile = detourMesh->getTile(tileIndex);
+		if (tile && tile->header)
+		{
+			outTileSalts.Add(tileIndex, tile->salt);
+		}
+	}
+#endif
+}
+
+void UJGNavMeshManager::SampleCoverageStats(float elapsedTime)
+{
+#if WITH_RECAST
+	ARecastNavMesh* navMesh = IsValid(NavigationSystem) ? Cast<ARecastNavMesh>(NavigationSystem->GetDefaultNavDataInstance()) : nullptr;
+	const dtNavMesh* detourMesh = IsValid(navMesh) ? navMesh->GetRecastMesh() : nullptr;
+	if (!detourMesh || elapsedTime <= 0.0f)
+	{
+		return;
+	}
+
+	int32 tileCount = 0;
+	int32 builtTiles = 0;
+	int64 memory = 0;
+	TMap<int32, uint32> tileSalts;
+	tileSalts.Reserve(SampledTileSalts.Num());
+
+	// Removing a tile bumps the salt of its slot, so a slot with a new salt holds a tile built since the last sample
+	for (int32 tileIndex = 0; tileIndex < detourMesh->getMaxTiles(); tileIndex++)
+	{
+		const dtMeshTile* tile = detourMesh->getTile(tileIndex);
+		if (!tile || !tile->header)
+		{
+			continue;
+		}
+
+		tileCount++;
+		memory += tile->dataSize;
+		tileSalts.Add(tileIndex, tile->salt);
+
+		const uint32* sampledSalt = SampledTileSalts.Find(tileIndex);
+		if (!sampledSalt || *sampledSalt != tile->salt)
+		{
+			builtTiles++;
+		}
+	}
+	SampledTileSalts = MoveTemp(tileSalts);
+
+	SampledTime += elapsedTime;
+	CoverageStats.TileCount = tileCount;
+	CoverageStats.MemoryKB = memory / 1024.0f;
+	CoverageStats.PeakMemoryKB = FMath::Max(CoverageStats.PeakMemoryKB, CoverageStats.MemoryKB);
+	CoverageStats.TilesBuiltPerSecond = builtTiles / elapsedTime;
+	CoverageStats.TotalTilesBuilt += builtTiles;
+	CoverageStats.AverageTilesBuiltPerSecond = CoverageStats.TotalTilesBuilt / SampledTime;
+
+	// Compare the modes with -csvcapture runs, one per jg.Nav.CoverageMode value
+	CSV_CUSTOM_STAT(JGNav, Tiles, tileCount, ECsvCustomStatOp::Set);
+	CSV_CUSTOM_STAT(JGNav, MemoryKB, CoverageStats.MemoryKB, ECsvCustomStatOp::Set);
+	CSV_CUSTOM_STAT(JGNav, TilesBuiltPerSecond, CoverageStats.TilesBuiltPerSecond, ECsvCustomStatOp::Set);
+	CSV_CUSTOM_STAT(JGNav, TilesEvicted, CoverageStats.TotalTilesEvicted, ECsvCustomStatOp::Set);
+
+	if (NavMemoryHistoryLength > 0)
+	{
+		if (NavMemoryHistory.Num() >= NavMemoryHistoryLength)
+		{
+			NavMemoryHistory.RemoveAt(0, NavMemoryHistory.Num() - NavMemoryHistoryLength + 1);
+		}
+
+		FJGNavMemorySample& sample = NavMemoryHistory.AddDefaulted_GetRef();
+		sample.Time = SampledTime;
+		sample.TileCount = tileCount;
+		sample.MemoryKB = CoverageStats.MemoryKB;
+	}
+#endif
+}
+
+float UJGNavMeshManager::GetSampleInterval() const
+{
+	if (StatsSampleInterval > 0.0f)
+	{
+		return StatsSampleInterval;
+	}
+
+	return NavMemoryBudgetKB > 0 ? 1.0f : 0.0f;
+}
+
+void UJGNavMeshManager::ApplyNavMemoryBudget()
+{
+	// Wait for the previous change to be submitted, its tiles are not gone yet
+	if (HasPendingNavUpdate)
+	{
+		return;
+	}
+
+	if (NavMemoryBudgetKB <= 0)
+	{
+		if (BudgetBufferReduction > 0)
+		{
+			BudgetBufferReduction = 0;
+			RequestCoverageUpdate();
+		}
+		CoverageStats.BudgetBufferReduction = 0;
+		return;
+	}
+
+	const float memoryKB = CoverageStats.MemoryKB;
+	if (memoryKB > NavMemoryBudgetKB)
+	{
+		if (GetCoverageBufferSize() > 1)
+		{
+			BudgetBufferReduction++;
+			UE_LOG(LogTemp, Log, TEXT("JGNavMeshManager: Nav memory %.0fKB over the %dKB budget, nav buffer down to %d chunks"),
+				memoryKB, NavMemoryBudgetKB, GetCoverageBufferSize());
+			RequestCoverageUpdate();
+		}
+		else if (!HasWarnedOverBudget)
+		{
+			HasWarnedOverBudget = true;
+			UE_LOG(LogTemp, Warning, TEXT("JGNavMeshManager: Nav memory %.0fKB still over the %dKB budget with a single chunk of nav buffer"),
+				memoryKB, NavMemoryBudgetKB);
+		}
+	}
+	else if (BudgetBufferReduction > 0 && memoryKB < NavMemoryBudgetKB * NavMemoryRecoverFraction)
+	{
+		BudgetBufferReduction--;
+		HasWarnedOverBudget = false;
+		UE_LOG(LogTemp, Log, TEXT("JGNavMeshManager: Nav memory %.0fKB back under the budget, nav buffer up to %d chunks"),
+			memoryKB, GetCoverageBufferSize());
+		RequestCoverageUpdate();
+	}
+
+	CoverageStats.BudgetBufferReduction = BudgetBufferReduction;
+}
+
+void UJGNavMeshManager::RequestCoverageUpdate()
+{
+	if (!HasPendingNavUpdate)
+	{
+		HasPendingNavUpdate = true;
+		PendingCenterChunkIndex = CurrentCenterChunkIndex;
+		PendingNavUpdateAge = 0.0f;
+	}
+
+	// No window change to wait for
+	PendingNavUpdateAge = FMath::Max(PendingNavUpdateAge, NavUpdateCoalesceTime);
+	UpdateTickInterval();
+}
@@ -0,0 +1,316 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Public/JGNavProjectionCache.h"
+#include "Engine/World.h"
+#include "GameFramework/GameModeBase.h"
+#include "HAL/IConsoleManager.h"
+#include "NavigationSystem.h"
+#include "JGLevelGenerator.h"
+
+static TAutoConsoleVariable<float> CVarNavProjectionCacheCellSize(
+	TEXT("jg.Nav.ProjectionCacheCellSize"),
+	25.0f,
+	TEXT("Size of the cells the JG nav projection cache quantizes query points to, 0 disables the cache."),
+	ECVF_Default);
+
+static FAutoConsoleCommandWithWorld CmdNavProjectionCacheStats(
+	TEXT("jg.Nav.ProjectionCacheStats"),
+	TEXT("Log the hit rate of the JG nav projection cache"),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* world)
+	{
+		if (const UJGNavProjectionCache* cache = world ? world->GetSubsystem<UJGNavProjectionCache>() : nullptr)
+		{
+			cache->LogStats();
+		}
+	}));
+
+bool FJGNavProjectionEntries::MakeKey(const FVector& point, const FVector& queryExtent, float cellSize, FJGNavProjectionKey& outKey)
+{
+	if (cellSize <= 0.0f)
+	{
+		return false;
+	}
+
+	outKey.Cell = FIntVector(
+		FMath::FloorToInt(point.X / cellSize),
+		FMath::FloorToInt(point.Y / cellSize),
+		FMath::FloorToInt(point.Z / cellSize));
+	outKey.Extent = FMath::RoundToInt(queryExtent.GetMax());
+	return true;
+}
+
+const FJGNavProjectionResult* FJGNavProjectionEntries::Find(int32 chunkIndex, const FJGNavProjectionKey& key) const
+{
+	const TMap<FJGNavProjectionKey, FJGNavProjectionResult>* entries = ChunkEntries.Find(chunkIndex);
+	return entries ? entries->Find(key) : nullptr;
+}
+
+void FJGNavProjectionEntries::Store(int32 chunkIndex, const FJGNavProjectionKey& key, bool success, const FVector& location)
+{
+	FJGNavProjectionResult& result = ChunkEntries.FindOrAdd(chunkIndex).Add(key);
+	result.Success = success;
+	result.Location = success ? location : FVector::ZeroVector;
+}
+
+bool FJGNavProjectionEntries::InvalidateChunk(int32 chunkIndex)
+{
+	return ChunkEntries.Remove(chunkIndex) > 0;
+}
+
+bool FJGNavProjectionEntries::MarkRebuilding(int32 chunkIndex)
+{
+	RebuildingChunks.Add(chunkIndex);
+	return InvalidateChunk(chunkIndex);
+}
+
+bool FJGNavProjectionEntries::RemoveChunk(int32 chunkIndex)
+{
+	RebuildingChunks.Remove(chunkIndex);
+	return InvalidateChunk(chunkIndex);
+}
+
+int32 FJGNavProjectionEntries::OnGenerationFinished()
+{
+	// Results cached while tiles were missing would stay failed for good, the successful ones are kept
+	for (TPair<int32, TMap<FJGNavProjectionKey, FJGNavProjectionResult>>& chunkEntries : ChunkEntries)
+	{
+		for (auto it = chunkEntries.Value.CreateIterator(); it; ++it)
+		{
+			if (!it.Value().Success)
+			{
+				it.RemoveCurrent();
+			}
+		}
+	}
+
+	int32 invalidatedChunks = 0;
+	for (int32 chunkIndex : RebuildingChunks)
+	{
+		invalidatedChunks += InvalidateChunk(chunkIndex) ? 1 : 0;
+	}
+	RebuildingChunks.Reset();
+	return invalidatedChunks;
+}
+
+int32 FJGNavProjectionEntries::Num() const
+{
+	int32 num = 0;
+	for (const TPair<int32, TMap<FJGNavProjectionKey, FJGNavProjectionResult>>& chunkEntries : ChunkEntries)
+	{
+		num += chunkEntries.Value.Num();
+	}
+	return num;
+}
+
+void FJGNavProjectionEntries::Reset()
+{
+	ChunkEntries.Reset();
+	RebuildingChunks.Reset();
+}
+
+bool UJGNavProjectionCache::DoesSupportWorldType(const EWorldType::Type worldType) const
+{
+	return worldType == EWorldType::Game || worldType == EWorldType::PIE;
+}
+
+void UJGNavProjectionCache::OnWorldBeginPlay(UWorld& world)
+{
+	Super::OnWorldBeginPlay(world);
+
+	const AGameModeBase* gameMode = world.GetAuthGameMode();
+	UJGLevelGenerator* levelGenerator = gameMode ? gameMode->FindComponentByClass<UJGLevelGenerator>() : nullptr;
+	if (IsValid(levelGenerator))
+	{
+		LevelGenerator = levelGenerator;
+		levelGenerator->OnChunkWindowChanged().AddUObject(this, &UJGNavProjectionCache::OnChunkWindowChanged);
+	}
+
+	if (UNavigationSystemV1* navSystem = FNavigationSystem::GetCurrent<UNavigationSystemV1>(&world))
+	{
+		navSystem->OnNavigationGenerationFinishedDelegate.AddDynamic(this, &UJGNavProjectionCache::OnNavigationGenerationFinished);
+	}
+}
+
+void UJGNavProjectionCache::Deinitialize()
+{
+	if (UJGLevelGenerator* levelGenerator = LevelGenerator.Get())
+	{
+		levelGenerator->OnChunkWindowChanged().RemoveAll(this);
+	}
+
+	if (Stats.Hits + Stats.Misses > 0)
+	{
+		LogStats();
+	}
+
+	Projections.Reset();
+
+	Super::Deinitialize();
+}
+
+bool UJGNavProjectionCache::ProjectPoint(const UWorld* world, const FVector& point, const FVector& queryExtent, FVector& outLocation)
+{
+	if (UJGNavProjectionCache* cache = world ? world->GetSubsystem<UJGNavProjectionCache>() : nullptr)
+	{
+		return cache->ProjectPoint(point, queryExtent, outLocation);
+	}
+
+	UNavigationSystemV1* navSystem = FNavigationSystem::GetCurrent<UNavigationSystemV1>(world);
+	FNavLocation navLocation;
+	if (IsValid(navSystem) && navSystem->ProjectPointToNavigation(point, navLocation, queryExtent))
+	{
+		outLocation = navLocation.Location;
+		return true;
+	}
+
+	return false;
+}
+
+bool UJGNavProjectionCache::ProjectPoint(const FVector& point, const FVector& queryExtent, FVector& outLocation)
+{
+	UNavigationSystemV1* navSystem = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld());
+	if (!IsValid(navSystem))
+	{
+		return false;
+	}
+
+	// outLocation may be the point itself
+	const FVector queryPoint = point;
+	auto project = [navSystem, &queryPoint, &queryExtent, &outLocation]()
+	{
+		FNavLocation navLocation;
+		if (navSystem->ProjectPointToNavigation(queryPoint, navLocation, queryExtent))
+		{
+			outLocation = navLocation.Location;
+			return true;
+		}
+		return false;
+	};
+
+	bool cachedSuccess = false;
+	if (FindProjection(queryPoint, queryExtent, cachedSuccess, outLocation))
+	{
+		return cachedSuccess;
+	}
+
+	const bool success = project();
+	StoreProjection(queryPoint, queryExtent, success, outLocation);
+	return success;
+}
+
+bool UJGNavProjectionCache::FindProjection(const FVector& point, const FVector& queryExtent, bool& outSuccess, FVector& outLocation)
+{
+	int32 chunkIndex = INDEX_NONE;
+	FJGNavProjectionKey key;
+	if (!GetProjectionKey(point, queryExtent, chunkIndex, key))
+	{
+		Stats.Bypasses++;
+		return false;
+	}
+
+	const FJGNavProjectionResult* cachedResult = Projections.Find(chunkIndex, key);
+	if (!cachedResult)
+	{
+		Stats.Misses++;
+		return false;
+	}
+
+	Stats.Hits++;
+	outSuccess = cachedResult->Success;
+	if (cachedResult->Success)
+	{
+		outLocation = cachedResult->Location;
+	}
+	return true;
+}
+
+void UJGNavProjectionCache::StoreProjection(const FVector& point, const FVector& queryExtent, bool success, const FVector& location)
+{
+	int32 chunkIndex = INDEX_NONE;
+	FJGNavProjectionKey key;
+	if (GetProjectionKey(point, queryExtent, chunkIndex, key))
+	{
+		Projections.Store(chunkIndex, key, success, location);
+	}
+}
+
+bool UJGNavProjectionCache::GetProjectionKey(const FVector& point, const FVector& queryExtent, int32& outChunkIndex, FJGNavProjectionKey& outKey) const
+{
+	const UJGLevelGenerator* levelGenerator = LevelGenerator.Get();
+	outChunkIndex = IsValid(levelGenerator) ? levelGenerator->FindChunkIndexAt(point.X) : INDEX_NONE;
+	if (outChunkIndex == INDEX_NONE || Projections.IsRebuilding(outChunkIndex))
+	{
+		return false;
+	}
+
+	return FJGNavProjectionEntries::MakeKey(point, queryExtent, CVarNavProjectionCacheCellSize.GetValueOnGameThread(), outKey);
+}
+
+void UJGNavProjectionCache::MarkAreaRebuilding(const FBox& area)
+{
+	TArray<int32> chunkIndices;
+	GetChunksInArea(area, chunkIndices);
+	for (int32 chunkIndex : chunkIndices)
+	{
+		Stats.InvalidatedChunks += Projections.MarkRebuilding(chunkIndex) ? 1 : 0;
+	}
+}
+
+void UJGNavProjectionCache::InvalidateArea(const FBox& area)
+{
+	TArray<int32> chunkIndices;
+	GetChunksInArea(area, chunkIndices);
+	for (int32 chunkIndex : chunkIndices)
+	{
+		InvalidateChunk(chunkIndex);
+	}
+}
+
+FJGNavProjectionCacheStats UJGNavProjectionCache::GetStats() const
+{
+	FJGNavProjectionCacheStats stats = Stats;
+	stats.Entries = Projections.Num();
+	return stats;
+}
+
+void UJGNavProjectionCache::LogStats() const
+{
+	const FJGNavProjectionCacheStats stats = GetStats();
+	UE_LOG(LogTemp, Log, TEXT("JGNavProjectionCache: %.1f%% hit rate (%d hits, %d misses, %d uncached), %d entries, %d chunk invalidations"),
+		stats.GetHitRate() * 100.0f, stats.Hits, stats.Misses, stats.Bypasses, stats.Entries, stats.InvalidatedChunks);
+}
+
+void UJGNavProjectionCache::OnChunkWindowChanged(const FJGChunkWindowChange& windowChange)
+{
+	for (const FJGChunkWindowEntry& removedEntry : windowChange.RemovedChunks)
+	{
+		Stats.InvalidatedChunks += Projections.RemoveChunk(removedEntry.LogicalIndex) ? 1 : 0;
+	}
+}
+
+void UJGNavProjectionCache::OnNavigationGenerationFinished(ANavigationData* navData)
+{
+	Stats.InvalidatedChunks += Projections.OnGenerationFinished();
+}
+
+void UJGNavProjectionCache::InvalidateChunk(int32 chunkIndex)
+{
+	Stats.InvalidatedChunks += Projections.InvalidateChunk(chunkIndex) ? 1 : 0;
+}
+
+void UJGNavProjectionCache::GetChunksInArea(const FBox& area, TArray<int32>& outChunkIndices) const
+{
+	const UJGLevelGenerator* levelGenerator = LevelGenerator.Get();
+	if (!IsValid(levelGenerator) || !area.IsValid)
+	{
+		return;
+	}
+
+	for (const FChunkData& chunkData : levelGenerator->GetActiveChunks())
+	{
+		if (chunkData.IsValid() && chunkData.Bounds.Min.X <= area.Max.X && chunkData.Bounds.Max.X >= area.Min.X)
+		{
+			outChunkIndices.Add(chunkData.ChunkActor->ChunkLogicalIndex);
+		}
+	}
+}
@@ -0,0 +1,211 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Public/JGNavQueryService.h"
+#include "Async/ParallelFor.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "NavigationData.h"
+#include "NavigationSystem.h"
+#include "JGNavProjectionCache.h"
+
+static TAutoConsoleVariable<int32> CVarNavQueryBudget(
+	TEXT("jg.Nav.QueryBudget"),
+	32,
+	TEXT("Navmesh queries the JG nav query service runs per frame. Requests are never split, at least one runs every frame."),
+	ECVF_Default);
+
+bool UJGNavQueryService::DoesSupportWorldType(const EWorldType::Type worldType) const
+{
+	return worldType == EWorldType::Game || worldType == EWorldType::PIE;
+}
+
+void UJGNavQueryService::Deinitialize()
+{
+	if (UNavigationSystemV1* navSystem = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld()))
+	{
+		for (const TPair<uint32, FPathRequest>& runningPath : RunningPaths)
+		{
+			navSystem->AbortAsyncFindPathRequest(runningPath.Key);
+		}
+	}
+
+	RunningPaths.Reset();
+	PendingPaths.Reset();
+	PendingProjections.Reset();
+
+	Super::Deinitialize();
+}
+
+TStatId UJGNavQueryService::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UJGNavQueryService, STATGROUP_Tickables);
+}
+
+uint32 UJGNavQueryService::RequestProjections(TConstArrayView<FVector> points, const FVector& queryExtent, FJGNavProjectionsDelegate onCompleted)
+{
+	FProjectionRequest& request = PendingProjections.AddDefaulted_GetRef();
+	request.Id = NextRequestId++;
+	request.Points = points;
+	request.QueryExtent = queryExtent;
+	request.OnCompleted = MoveTemp(onCompleted);
+	return request.Id;
+}
+
+uint32 UJGNavQueryService::RequestPath(const FVector& start, const FVector& end, const FNavAgentProperties& agentProperties, FJGNavPathDelegate onCompleted)
+{
+	FPathRequest& request = PendingPaths.AddDefaulted_GetRef();
+	request.Id = NextRequestId++;
+	request.Start = start;
+	request.End = end;
+	request.AgentProperties = agentProperties;
+	request.OnCompleted = MoveTemp(onCompleted);
+	return request.Id;
+}
+
+void UJGNavQueryService::CancelRequest(uint32 requestId)
+{
+	if (requestId == 0)
+	{
+		return;
+	}
+
+	if (IsDelivering)
+	{
+		CancelledDuringDelivery.Add(requestId);
+	}
+
+	PendingProjections.RemoveAll([requestId](const FProjectionRequest& request) { return request.Id == requestId; });
+	PendingPaths.RemoveAll([requestId](const FPathRequest& request) { return request.Id == requestId; });
+
+	for (auto it = RunningPaths.CreateIterator(); it; ++it)
+	{
+		if (it.Value().Id == requestId)
+		{
+			if (UNavigationSystemV1* navSystem = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld()))
+			{
+				navSystem->AbortAsyncFindPathRequest(it.Key());
+			}
+			it.RemoveCurrent();
+			break;
+		}
+	}
+}
+
+void UJGNavQueryService::Tick(float deltaTime)
+{
+	int32 queryBudget = FMath::Max(1, CVarNavQueryBudget.GetValueOnGameThread());
+	const int32 initialBudget = queryBudget;
+
+	StartPaths(queryBudget);
+	RunProjections(queryBudget);
+
+	QueriesLastFrame = initialBudget - queryBudget;
+}
+
+void UJGNavQueryService::StartPaths(int32& queryBudget)
+{
+	UNavigationSystemV1* navSystem = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld());
+	const ANavigationData* navData = IsValid(navSystem) ? navSystem->GetDefaultNavDataInstance() : nullptr;
+	if (!IsValid(navData))
+	{
+		return;
+	}
+
+	int32 startedPaths = 0;
+	while (startedPaths < PendingPaths.Num() && queryBudget > 0)
+	{
+		FPathRequest& request = PendingPaths[startedPaths++];
+		const FPathFindingQuery query(this, *navData, request.Start, request.End);
+		const uint32 queryId = navSystem->FindPathAsync(request.AgentProperties, query,
+			FNavPathQueryDelegate::CreateUObject(this, &UJGNavQueryService::OnPathFound));
+		RunningPaths.Add(queryId, MoveTemp(request));
+		queryBudget--;
+	}
+	PendingPaths.RemoveAt(0, startedPaths);
+}
+
+void UJGNavQueryService::OnPathFound(uint32 queryId, ENavigationQueryResult::Type result, FNavPathSharedPtr path)
+{
+	FPathRequest request;
+	if (RunningPaths.RemoveAndCopyValue(queryId, request))
+	{
+		request.OnCompleted.ExecuteIfBound(result == ENavigationQueryResult::Success && path.IsValid(), path);
+	}
+}
+
+void UJGNavQueryService::RunProjections(int32& queryBudget)
+{
+	if (PendingProjections.Num() == 0)
+	{
+		return;
+	}
+
+	UNavigationSystemV1* navSystem = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld());
+	const ANavigationData* navData = IsValid(navSystem) ? navSystem->GetDefaultNavDataInstance() : nullptr;
+	if (!IsValid(navData))
+	{
+		return;
+	}
+
+	UJGNavProjectionCache* projectionCache = GetWorld()->GetSubsystem<UJGNavProjectionCache>();
+
+	// Whole requests are taken while there is budget, the cached points are answered on the way
+	struct FProjectionJob
+	{
+		int32 RequestIndex;
+		int32 PointIndex;
+	};
+	TArray<FProjectionJob> jobs;
+	TArray<TArray<FJGNavProjectionResult>> results;
+	int32 batchSize = 0;
+	while (batchSize < PendingProjections.Num() && (batchSize == 0 || queryBudget > 0))
+	{
+		const FProjectionRequest& request = PendingProjections[batchSize];
+		TArray<FJGNavProjectionResult>& requestResults = results.AddDefaulted_GetRef();
+		requestResults.SetNum(request.Points.Num());
+		for (int32 pointIndex = 0; pointIndex < request.Points.Num(); pointIndex++)
+		{
+			FJGNavProjectionResult& pointResult = requestResults[pointIndex];
+			if (!projectionCache || !projectionCache->FindProjection(request.Points[pointIndex], request.QueryExtent, pointResult.Success, pointResult.Location))
+			{
+				jobs.Add({ batchSize, pointIndex });
+				queryBudget--;
+			}
+		}
+		batchSize++;
+	}
+
+	TArray<FProjectionRequest> batch(PendingProjections.GetData(), batchSize);
+	PendingProjections.RemoveAt(0, batchSize);
+
+	ParallelFor(TEXT("JGNavProjections"), jobs.Num(), 4, [&jobs, &batch, &results, navData](int32 jobIndex)
+	{
+		const FProjectionJob& job = jobs[jobIndex];
+		const FProjectionRequest& request = batch[job.RequestIndex];
+		FNavLocation navLocation;
+		FJGNavProjectionResult& pointResult = results[job.RequestIndex][job.PointIndex];
+		pointResult.Success = navData->ProjectPoint(request.Points[job.PointIndex], navLocation, request.QueryExtent);
+		pointResult.Location = navLocation.Location;
+	});
+
+	if (projectionCache)
+	{
+		for (const FProjectionJob& job : jobs)
+		{
+			const FJGNavProjectionResult& pointResult = results[job.RequestIndex][job.PointIndex];
+			projectionCache->StoreProjection(batch[job.RequestIndex].Points[job.PointIndex], batch[job.RequestIndex].QueryExtent, pointResult.Success, pointResult.Location);
+		}
+	}
+
+	// Callbacks finish latent tasks, which can cancel or submit requests
+	IsDelivering = true;
+	for (int32 requestIndex = 0; requestIndex < batch.Num(); requestIndex++)
+	{
+		if (!CancelledDuringDelivery.Contains(batch[requestIndex].Id))
+		{
+			batch[requestIndex].OnCompleted.ExecuteIfBound(results[requestIndex]);
+		}
+	}
+	IsDelivering = false;
+	CancelledDuringDelivery.Reset();
+}
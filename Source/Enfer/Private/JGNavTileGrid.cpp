@@ -0,0 +1,53 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Public/JGNavTileGrid.h"
+#include "Engine/World.h"
+#include "NavigationSystem.h"
+#include "NavMesh/RecastNavMesh.h"
+
+FJGNavTileGrid FJGNavTileGrid::FromWorld(const UWorld* world)
+{
+	FJGNavTileGrid grid;
+
+	const UNavigationSystemV1* navSystem = FNavigationSystem::GetCurrent<UNavigationSystemV1>(world);
+	if (!IsValid(navSystem))
+	{
+		return grid;
+	}
+
+	const ARecastNavMesh* navMesh = Cast<ARecastNavMesh>(navSystem->GetDefaultNavDataInstance());
+	if (!IsValid(navMesh))
+	{
+		return grid;
+	}
+
+	grid.TileSize = navMesh->TileSizeUU;
+	grid.Origin = FVector2D(navMesh->NavMeshOriginOffset.X, navMesh->NavMeshOriginOffset.Y);
+	return grid;
+}
+
+bool FJGNavTileGrid::GetRecastTile(const ARecastNavMesh* navMesh, const FIntPoint& tile, FIntPoint& outRecastTile) const
+{
+	if (!IsValid() || !::IsValid(navMesh))
+	{
+		return false;
+	}
+
+	// The tile center is away from the boundaries, where rounding could land on the neighbour
+	return navMesh->GetNavMeshTileXY(GetTileCenter(tile), outRecastTile.X, outRecastTile.Y);
+}
+
+void FJGNavTileGrid::GetRecastTiles(const ARecastNavMesh* navMesh, const FIntRect& range, TArray<FIntPoint>& outRecastTiles) const
+{
+	for (int32 tileX = range.Min.X; tileX <= range.Max.X; tileX++)
+	{
+		for (int32 tileY = range.Min.Y; tileY <= range.Max.Y; tileY++)
+		{
+			FIntPoint recastTile;
+			if (GetRecastTile(navMesh, FIntPoint(tileX, tileY), recastTile))
+			{
+				outRecastTiles.AddUnique(recastTile);
+			}
+		}
+	}
+}
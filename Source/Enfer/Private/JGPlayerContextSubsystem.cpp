@@ -0,0 +1,184 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Public/JGPlayerContextSubsystem.h"
+#include "Engine/World.h"
+#include "GameFramework/Pawn.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/IConsoleManager.h"
+
+static TAutoConsoleVariable<float> CVarPlayerContextHistorySeconds(
+	TEXT("jg.PlayerContext.HistorySeconds"),
+	1.0f,
+	TEXT("Seconds of pawn locations kept per player by the player context subsystem, 0 keeps no history."),
+	ECVF_Default);
+
+bool UJGPlayerContextSubsystem::DoesSupportWorldType(const EWorldType::Type worldType) const
+{
+	return worldType == EWorldType::Game || worldType == EWorldType::PIE;
+}
+
+TStatId UJGPlayerContextSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UJGPlayerContextSubsystem, STATGROUP_Tickables);
+}
+
+void UJGPlayerContextSubsystem::Tick(float deltaTime)
+{
+	// Frames nobody read the context in still go into the history
+	CaptureIfStale();
+}
+
+void UJGPlayerContextSubsystem::CaptureIfStale()
+{
+	UWorld* world = GetWorld();
+	if (CapturedFrame == GFrameCounter || !IsValid(world))
+	{
+		return;
+	}
+
+	CapturedFrame = GFrameCounter;
+	CapturedTime = world->GetTimeSeconds();
+
+	const float historySeconds = CVarPlayerContextHistorySeconds.GetValueOnGameThread();
+
+	int32 playerCount = 0;
+	for (FConstPlayerControllerIterator it = world->GetPlayerControllerIterator(); it; ++it)
+	{
+		const int32 playerIndex = playerCount++;
+		if (!Players.IsValidIndex(playerIndex))
+		{
+			Players.AddDefaulted();
+			LocationHistories.AddDefaulted();
+		}
+
+		FJGPlayerContext& context = Players[playerIndex];
+		APlayerController* playerController = it->Get();
+		APawn* pawn = IsValid(playerController) ? playerController->GetPawn() : nullptr;
+
+		context.PlayerIndex = playerIndex;
+		context.Pawn = pawn;
+		context.HasPawn = IsValid(pawn);
+		if (!context.HasPawn)
+		{
+			LocationHistories[playerIndex].Reset();
+			continue;
+		}
+
+		context.Location = pawn->GetActorLocation();
+		context.Velocity = pawn->GetVelocity();
+		context.Forward = pawn->GetActorForwardVector();
+		context.Location2D = FVector2D(context.Location.X, context.Location.Y);
+		context.Velocity2D = FVector2D(context.Velocity.X, context.Velocity.Y);
+		context.Forward2D = FVector2D(context.Forward.X, context.Forward.Y).GetSafeNormal();
+		context.Speed2D = context.Velocity2D.Size();
+
+		TArray<FLocationSample>& history = LocationHistories[playerIndex];
+		if (historySeconds <= 0.0f)
+		{
+			history.Reset();
+			continue;
+		}
+
+		FLocationSample& sample = history.AddDefaulted_GetRef();
+		sample.Time = CapturedTime;
+		sample.Location = context.Location;
+
+		// Keep one sample older than the window, so that the whole window can be interpolated
+		int32 expiredCount = 0;
+		while (expiredCount + 1 < history.Num() && history[expiredCount + 1].Time <= CapturedTime - historySeconds)
+		{
+			expiredCount++;
+		}
+		history.RemoveAt(0, expiredCount, EAllowShrinking::No);
+	}
+
+	Players.SetNum(playerCount);
+	LocationHistories.SetNum(playerCount);
+}
+
+const FJGPlayerContext* UJGPlayerContextSubsystem::FindClosest(const UWorld* world, const FVector& location)
+{
+	UJGPlayerContextSubsystem* subsystem = world ? world->GetSubsystem<UJGPlayerContextSubsystem>() : nullptr;
+	if (!subsystem)
+	{
+		return nullptr;
+	}
+
+	const FJGPlayerContext* closestContext = nullptr;
+	float closestDistanceSquared = TNumericLimits<float>::Max();
+	for (const FJGPlayerContext& context : subsystem->GetPlayers())
+	{
+		const float distanceSquared = FVector::DistSquared(context.Location, location);
+		if (context.HasPawn && distanceSquared < closestDistanceSquared)
+		{
+			closestContext = &context;
+			closestDistanceSquared = distanceSquared;
+		}
+	}
+
+	return closestContext;
+}
+
+const FJGPlayerContext* UJGPlayerContextSubsystem::Find(const UWorld* world, int32 playerIndex)
+{
+	UJGPlayerContextSubsystem* subsystem = world ? world->GetSubsystem<UJGPlayerContextSubsystem>() : nullptr;
+	if (!subsystem)
+	{
+		return nullptr;
+	}
+
+	const TArray<FJGPlayerContext>& players = subsystem->GetPlayers();
+	return players.IsValidIndex(playerIndex) && players[playerIndex].HasPawn ? &players[playerIndex] : nullptr;
+}
+
+const TArray<FJGPlayerContext>& UJGPlayerContextSubsystem::GetPlayers()
+{
+	CaptureIfStale();
+	return Players;
+}
+
+FJGPlayerContext UJGPlayerContextSubsystem::GetPlayerContext(int32 playerIndex)
+{
+	CaptureIfStale();
+	return Players.IsValidIndex(playerIndex) ? Players[playerIndex] : FJGPlayerContext();
+}
+
+bool UJGPlayerContextSubsystem::GetPastLocation(int32 playerIndex, float secondsAgo, FVector& outLocation)
+{
+	CaptureIfStale();
+	if (!LocationHistories.IsValidIndex(playerIndex) || LocationHistories[playerIndex].Num() == 0)
+	{
+		return false;
+	}
+
+	const TArray<FLocationSample>& history = LocationHistories[playerIndex];
+	const double time = CapturedTime - FMath::Max(0.0f, secondsAgo);
+	if (history[0].Time > time)
+	{
+		return false;
+	}
+
+	// Newest first, the history is short and recent queries are the common ones
+	for (int32 sampleIndex = history.Num() - 1; sampleIndex >= 0; sampleIndex--)
+	{
+		const FLocationSample& sample = history[sampleIndex];
+		if (sample.Time > time)
+		{
+			continue;
+		}
+
+		if (sampleIndex == history.Num() - 1)
+		{
+			outLocation = sample.Location;
+			return true;
+		}
+
+		const FLocationSample& nextSample = history[sampleIndex + 1];
+		const double span = nextSample.Time - sample.Time;
+		const float alpha = span > 0.0 ? static_cast<float>((time - sample.Time) / span) : 0.0f;
+		outLocation = FMath::Lerp(sample.Location, nextSample.Location, alpha);
+		return true;
+	}
+
+	return false;
+}
@@ -2,6 +2,8 @@
 #include "AIController.h"
 #include "BehaviorTree/Blackboard/BlackboardKeyType_Float.h"
 #include "GameFramework/Pawn.h"
+#include "JGPlayerContextSubsystem.h"
+#include "JGAILODManager.h"
 
 UJGService_UpdatePlayerContext::UJGService_UpdatePlayerContext()
 {
@@ -21,10 +23,13 @@ void UJGService_UpdatePlayerContext::UpdatePlayerContext(UBehaviorTreeComponent&
 
 	AAIController* ai = ownerComp.GetAIOwner();
 	APawn* npc = ai ? ai->GetPawn() : nullptr;
-	APawn* player = ownerComp.GetWorld() && ownerComp.GetWorld()->GetFirstPlayerController()
-		                ? ownerComp.GetWorld()->GetFirstPlayerController()->GetPawn() : nullptr;
+	if (!IsValid(npc))
+	{
+		return;
+	}
 
-	if (!IsValid(npc) || !IsValid(player))
+	const FJGPlayerContext* player = UJGPlayerContextSubsystem::FindClosest(ownerComp.GetWorld(), npc->GetActorLocation());
+	if (!player)
 	{
 		return;
 	}
@@ -39,20 +44,16 @@ void UJGService_UpdatePlayerContext::UpdatePlayerContext(UBehaviorTreeComponent&
 
 	const FVector2D moveDir2D(moveDir.X, moveDir.Y);
 	const FVector2D npc2D(npc->GetActorLocation().X, npc->GetActorLocation().Y);
-	const FVector2D player2D(player->GetActorLocation().X, player->GetActorLocation().Y);
 
 	// Project delta onto direction to get longitudinal separation (signed)
-	const FVector2D delta2D = player2D - npc2D;
+	const FVector2D delta2D = player->Location2D - npc2D;
 	const float signedLongitudinal = FVector2D::DotProduct(delta2D, moveDir2D);
 
 	bb->SetValueAsFloat(PlayerLongitudinalOffsetKey.SelectedKeyName, signedLongitudinal);
 
 	// Player facing dot with DirectionKey (2D)
-	FVector playerForward = player->GetActorForwardVector();
-	FVector2D playerForward2D(playerForward.X, playerForward.Y);
 	FVector2D normMoveDir2D = moveDir2D.GetSafeNormal();
-	FVector2D normForward2D = playerForward2D.GetSafeNormal();
-	const float facingDot = FVector2D::DotProduct(normForward2D, normMoveDir2D);
+	const float facingDot = FVector2D::DotProduct(player->Forward2D, normMoveDir2D);
 	bb->SetValueAsFloat(PlayerFacingDotKey.SelectedKeyName, facingDot);
 }
 
@@ -63,6 +64,12 @@ void UJGService_UpdatePlayerContext::TickNode(UBehaviorTreeComponent& ownerComp,
 	UpdatePlayerContext(ownerComp);
 }
 
+void UJGService_UpdatePlayerContext::ScheduleNextTick(UBehaviorTreeComponent& ownerComp, uint8* nodeMemory)
+{
+	const float interval = Interval * UJGAILODManager::GetServiceIntervalScale(ownerComp);
+	SetNextTickTime(nodeMemory, FMath::FRandRange(FMath::Max(0.0f, interval - RandomDeviation), interval + RandomDeviation));
+}
+
 void UJGService_UpdatePlayerContext::OnSearchStart(FBehaviorTreeSearchData& searchData)
 {
 	Super::OnSearchStart(searchData);
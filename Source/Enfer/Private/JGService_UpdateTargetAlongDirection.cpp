@@ -1,6 +1,9 @@
 ﻿#include "JGService_UpdateTargetAlongDirection.h"
 #include "AIController.h"
 #include "NavigationSystem.h"
+#include "JGSidewalkLane.h"
+#include "JGNavProjectionCache.h"
+#include "JGAILODManager.h"
 #include "GameFramework/Character.h"
 #include "GameFramework/CharacterMovementComponent.h"
 
@@ -43,16 +46,11 @@ void UJGService_UpdateTargetAlongDirection::TickNode(UBehaviorTreeComponent& own
 	const FVector desired = npcLoc + moveDir * StepDistance;
 
 	UWorld* world = npc->GetWorld();
-	UNavigationSystemV1* nav = world ? FNavigationSystem::GetCurrent<UNavigationSystemV1>(world) : nullptr;
-
+	// The sidewalk lane answers without a navmesh query, the navmesh is only used before the lane has chunks
 	FVector out = desired;
-	if (IsValid(nav))
+	if (!FJGSidewalkLane::ProjectPoint(world, desired, out, MaxSearchRadius))
 	{
-		FNavLocation navLoc;
-		if (nav->ProjectPointToNavigation(desired, navLoc, FVector(MaxSearchRadius)))
-		{
-			out = navLoc.Location;
-		}
+		UJGNavProjectionCache::ProjectPoint(world, desired, FVector(MaxSearchRadius), out);
 	}
 
 	bb->SetValueAsVector(TargetLocationKey.SelectedKeyName, out);
@@ -67,4 +65,10 @@ void UJGService_UpdateTargetAlongDirection::TickNode(UBehaviorTreeComponent& own
 			}
 		}
 	}
-}
\ No newline at end of file
+}
+
+void UJGService_UpdateTargetAlongDirection::ScheduleNextTick(UBehaviorTreeComponent& ownerComp, uint8* nodeMemory)
+{
+	const float interval = Interval * UJGAILODManager::GetServiceIntervalScale(ownerComp);
+	SetNextTickTime(nodeMemory, FMath::FRandRange(FMath::Max(0.0f, interval - RandomDeviation), interval + RandomDeviation));
+}
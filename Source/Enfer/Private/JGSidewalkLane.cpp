@@ -0,0 +1,218 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Public/JGSidewalkLane.h"
+#include "Algo/BinarySearch.h"
+#include "Engine/World.h"
+#include "GameFramework/GameModeBase.h"
+#include "JGLevelGenerator.h"
+
+void FJGSidewalkLane::SetChunkIntervals(int32 chunkIndex, TConstArrayView<FJGLaneInterval> chunkIntervals)
+{
+	RemoveChunk(chunkIndex);
+
+	for (const FJGLaneInterval& interval : chunkIntervals)
+	{
+		if (interval.MaxX <= interval.MinX)
+		{
+			continue;
+		}
+
+		FJGLaneInterval& added = Intervals.Insert_GetRef(interval, Algo::LowerBoundBy(Intervals, interval.MinX, &FJGLaneInterval::MinX));
+		added.ChunkIndex = chunkIndex;
+	}
+}
+
+void FJGSidewalkLane::RemoveChunk(int32 chunkIndex)
+{
+	Intervals.RemoveAll([chunkIndex](const FJGLaneInterval& interval) { return interval.ChunkIndex == chunkIndex; });
+}
+
+bool FJGSidewalkLane::FindNearestWalkablePoint(const FVector& location, FVector& outLocation, float maxDistanceX) const
+{
+	if (Intervals.Num() == 0)
+	{
+		return false;
+	}
+
+	// First interval ending after the location, the closest one is either it or the one before
+	const int32 nextIndex = Algo::LowerBoundBy(Intervals, location.X, &FJGLaneInterval::MaxX);
+
+	const FJGLaneInterval* nearest = nullptr;
+	float nearestDistance = UE_BIG_NUMBER;
+	for (int32 index = nextIndex - 1; index <= nextIndex; index++)
+	{
+		if (!Intervals.IsValidIndex(index))
+		{
+			continue;
+		}
+
+		const FJGLaneInterval& interval = Intervals[index];
+		const float distance = FMath::Max3(interval.MinX - location.X, location.X - interval.MaxX, 0.0f);
+		if (distance < nearestDistance)
+		{
+			nearest = &interval;
+			nearestDistance = distance;
+		}
+	}
+
+	if (!nearest || nearestDistance > maxDistanceX)
+	{
+		return false;
+	}
+
+	outLocation = FVector(
+		FMath::Clamp(location.X, nearest->MinX, nearest->MaxX),
+		FMath::Clamp(location.Y, nearest->MinY, nearest->MaxY),
+		nearest->GroundZ);
+	return true;
+}
+
+bool FJGSidewalkLane::FindRandomPointInChunk(int32 chunkIndex, FVector& outLocation) const
+{
+	float totalLength = 0.0f;
+	for (const FJGLaneInterval& interval : Intervals)
+	{
+		if (interval.ChunkIndex == chunkIndex)
+		{
+			totalLength += interval.MaxX - interval.MinX;
+		}
+	}
+
+	if (totalLength <= 0.0f)
+	{
+		return false;
+	}
+
+	// Rounding can run past the last interval, which then takes the point
+	float offset = FMath::FRandRange(0.0f, totalLength);
+	const FJGLaneInterval* picked = nullptr;
+	for (const FJGLaneInterval& interval : Intervals)
+	{
+		if (interval.ChunkIndex != chunkIndex)
+		{
+			continue;
+		}
+
+		picked = &interval;
+		const float length = interval.MaxX - interval.MinX;
+		if (offset <= length)
+		{
+			break;
+		}
+		offset -= length;
+	}
+
+	outLocation = FVector(
+		FMath::Min(picked->MinX + offset, picked->MaxX),
+		FMath::FRandRange(picked->MinY, picked->MaxY),
+		picked->GroundZ);
+	return true;
+}
+
+void FJGSidewalkLane::ComputeIntervals(float minX, float maxX, float minY, float maxY, float groundZ, TConstArrayView<FBox2D> obstacles,
+	float minBandWidth, TArray<FJGLaneInterval>& outIntervals)
+{
+	// Obstacles reaching into the lane, and the X at which the free part of the band can change
+	TArray<FBox2D, TInlineAllocator<16>> blockers;
+	TArray<float, TInlineAllocator<32>> cuts = { minX, maxX };
+	for (const FBox2D& obstacle : obstacles)
+	{
+		if (!obstacle.bIsValid || obstacle.Max.X <= minX || obstacle.Min.X >= maxX || obstacle.Max.Y <= minY || obstacle.Min.Y >= maxY)
+			continue;
+
+		blockers.Add(obstacle);
+		cuts.Add(FMath::Max(obstacle.Min.X, minX));
+		cuts.Add(FMath::Min(obstacle.Max.X, maxX));
+	}
+	cuts.Sort();
+
+	bool hasPreviousBand = false;
+	FVector2D previousBand = FVector2D::ZeroVector;
+	for (int32 cutIndex = 0; cutIndex + 1 < cuts.Num(); cutIndex++)
+	{
+		const float startX = cuts[cutIndex];
+		const float endX = cuts[cutIndex + 1];
+		if (endX - startX <= KINDA_SMALL_NUMBER)
+			continue;
+
+		// Lateral ranges blocked over the stretch
+		TArray<FVector2D, TInlineAllocator<8>> blockedRanges;
+		for (const FBox2D& blocker : blockers)
+		{
+			if (blocker.Min.X < endX && blocker.Max.X > startX)
+			{
+				blockedRanges.Add(FVector2D(blocker.Min.Y, blocker.Max.Y));
+			}
+		}
+		blockedRanges.Sort([](const FVector2D& a, const FVector2D& b) { return a.X < b.X; });
+
+		// Walking on from the previous stretch beats a wider part the agents could only reach by cutting through an obstacle
+		bool hasBand = false;
+		bool bandContinues = false;
+		FVector2D band = FVector2D::ZeroVector;
+		auto considerBand = [&](float bandMinY, float bandMaxY)
+		{
+			if (bandMaxY < bandMinY || bandMaxY - bandMinY < minBandWidth)
+				return;
+
+			const bool continues = hasPreviousBand && bandMinY <= previousBand.Y && bandMaxY >= previousBand.X;
+			const bool isWider = bandMaxY - bandMinY > band.Y - band.X;
+			if (!hasBand || (continues && !bandContinues) || (continues == bandContinues && isWider))
+			{
+				hasBand = true;
+				bandContinues = continues;
+				band = FVector2D(bandMinY, bandMaxY);
+			}
+		};
+
+		float freeMinY = minY;
+		for (const FVector2D& blockedRange : blockedRanges)
+		{
+			considerBand(freeMinY, FMath::Min(blockedRange.X, maxY));
+			freeMinY = FMath::Max(freeMinY, blockedRange.Y);
+		}
+		considerBand(freeMinY, maxY);
+
+		if (!hasBand)
+		{
+			hasPreviousBand = false;
+			continue;
+		}
+
+		// Stretches on the same band make one interval
+		if (hasPreviousBand && band.Equals(previousBand))
+		{
+			outIntervals.Last().MaxX = endX;
+		}
+		else
+		{
+			FJGLaneInterval& interval = outIntervals.AddDefaulted_GetRef();
+			interval.MinX = startX;
+			interval.MaxX = endX;
+			interval.MinY = band.X;
+			interval.MaxY = band.Y;
+			interval.GroundZ = groundZ;
+		}
+
+		hasPreviousBand = true;
+		previousBand = band;
+	}
+}
+
+const FJGSidewalkLane* FJGSidewalkLane::Get(const UWorld* world)
+{
+	const AGameModeBase* gameMode = world ? world->GetAuthGameMode() : nullptr;
+	const UJGLevelGenerator* levelGenerator = gameMode ? gameMode->FindComponentByClass<UJGLevelGenerator>() : nullptr;
+	if (!IsValid(levelGenerator) || levelGenerator->GetSidewalkLane().IsEmpty())
+	{
+		return nullptr;
+	}
+
+	return &levelGenerator->GetSidewalkLane();
+}
+
+bool FJGSidewalkLane::ProjectPoint(const UWorld* world, const FVector& location, FVector& outLocation, float maxDistanceX)
+{
+	const FJGSidewalkLane* lane = Get(world);
+	return lane && lane->FindNearestWalkablePoint(location, outLocation, maxDistanceX);
+}
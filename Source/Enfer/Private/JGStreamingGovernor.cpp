@@ -0,0 +1,119 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Public/JGStreamingGovernor.h"
+#include "Public/JGLevelGenerator.h"
+#include "HAL/PlatformMemory.h"
+#include "RenderCore.h"
+#include "UObject/UObjectGlobals.h"
+
+UJGStreamingGovernor::UJGStreamingGovernor()
+{
+	PrimaryComponentTick.bCanEverTick = true;
+	LevelGenerator = nullptr;
+
+	MinChunksOnEitherSide = 1;
+	MaxChunksOnEitherSide = 8;
+	CapAtAuthoredWindow = false;
+	GrowGameThreadMs = 10.0f;
+	ShrinkGameThreadMs = 15.0f;
+	GrowMaxAsyncPackages = 0;
+	ShrinkAsyncPackages = 16;
+	MemoryBudgetMB = 0;
+	GrowMemoryFraction = 0.85f;
+	GameThreadSmoothing = 0.05f;
+	GrowSustainTime = 3.0f;
+	ShrinkSustainTime = 0.5f;
+	ChangeCooldown = 2.0f;
+
+	SmoothedGameThreadMs = 0.0f;
+	GrowPressureTime = 0.0f;
+	ShrinkPressureTime = 0.0f;
+	CooldownRemaining = 0.0f;
+}
+
+void UJGStreamingGovernor::BeginPlay()
+{
+	Super::BeginPlay();
+
+	LevelGenerator = GetOwner()->FindComponentByClass<UJGLevelGenerator>();
+	if (!IsValid(LevelGenerator))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("JGStreamingGovernor: Could not find level generator component!"));
+		SetComponentTickEnabled(false);
+		return;
+	}
+
+	// Let the initial window settle before judging the frame time
+	CooldownRemaining = ChangeCooldown;
+}
+
+void UJGStreamingGovernor::TickComponent(float deltaTime, ELevelTick tickType, FActorComponentTickFunction* thisTickFunction)
+{
+	Super::TickComponent(deltaTime, tickType, thisTickFunction);
+
+	if (!IsValid(LevelGenerator) || LevelGenerator->GetActiveChunks().Num() == 0)
+	{
+		return;
+	}
+
+	const int32 currentChunks = LevelGenerator->GetEffectiveChunksOnEitherSide();
+	const int32 minChunks = FMath::Max(1, MinChunksOnEitherSide);
+	const int32 maxChunks = FMath::Max(minChunks, GetMaxChunksOnEitherSide());
+	if (currentChunks < minChunks || currentChunks > maxChunks)
+	{
+		ChangeWindow(FMath::Clamp(currentChunks, minChunks, maxChunks));
+		return;
+	}
+
+	// GGameThreadTime is the previous frame's game thread time, without waiting on the render thread or GPU
+	const float gameThreadMs = FPlatformTime::ToMilliseconds(GGameThreadTime);
+	SmoothedGameThreadMs = SmoothedGameThreadMs > 0.0f ? FMath::Lerp(SmoothedGameThreadMs, gameThreadMs, GameThreadSmoothing) : gameThreadMs;
+
+	const int32 asyncPackages = GetNumAsyncPackages();
+	const float usedMemoryMB = FPlatformMemory::GetStats().UsedPhysical / (1024.0f * 1024.0f);
+
+	const bool overMemory = MemoryBudgetMB > 0 && usedMemoryMB > MemoryBudgetMB;
+	const bool underMemory = MemoryBudgetMB <= 0 || usedMemoryMB < MemoryBudgetMB * GrowMemoryFraction;
+
+	const bool wantsShrink = SmoothedGameThreadMs > ShrinkGameThreadMs || asyncPackages > ShrinkAsyncPackages || overMemory;
+	const bool wantsGrow = !wantsShrink && SmoothedGameThreadMs < GrowGameThreadMs && asyncPackages <= GrowMaxAsyncPackages && underMemory;
+
+	// Between the two bands nothing accumulates, which is what keeps the window from flip-flopping
+	ShrinkPressureTime = wantsShrink ? ShrinkPressureTime + deltaTime : 0.0f;
+	GrowPressureTime = wantsGrow ? GrowPressureTime + deltaTime : 0.0f;
+
+	if (CooldownRemaining > 0.0f)
+	{
+		CooldownRemaining -= deltaTime;
+		return;
+	}
+
+	if (ShrinkPressureTime >= ShrinkSustainTime && currentChunks > minChunks)
+	{
+		UE_LOG(LogTemp, Log, TEXT("JGStreamingGovernor: Shrinking window (game thread %.2fms, %d async packages, %.0fMB used)"),
+			SmoothedGameThreadMs, asyncPackages, usedMemoryMB);
+		ChangeWindow(currentChunks - 1);
+	}
+	else if (GrowPressureTime >= GrowSustainTime && currentChunks < maxChunks)
+	{
+		UE_LOG(LogTemp, Log, TEXT("JGStreamingGovernor: Growing window (game thread %.2fms, %d async packages, %.0fMB used)"),
+			SmoothedGameThreadMs, asyncPackages, usedMemoryMB);
+		ChangeWindow(currentChunks + 1);
+	}
+}
+
+void UJGStreamingGovernor::ChangeWindow(int32 numChunks)
+{
+	LevelGenerator->SetEffectiveChunksOnEitherSide(numChunks);
+
+	GrowPressureTime = 0.0f;
+	ShrinkPressureTime = 0.0f;
+	CooldownRemaining = ChangeCooldown;
+}
+
+int32 UJGStreamingGovernor::GetMaxChunksOnEitherSide() const
+{
+	// The authored window is never clamped down
+	const int32 authoredChunks = LevelGenerator->NumChunksOnEitherSide;
+	return CapAtAuthoredWindow ? authoredChunks : FMath::Max(authoredChunks, MaxChunksOnEitherSide);
+}
@@ -5,6 +5,10 @@
 #include "BehaviorTree/BlackboardComponent.h"
 #include "AIController.h"
 #include "NavigationSystem.h"
+#include "JGSidewalkLane.h"
+#include "JGNavProjectionCache.h"
+#include "JGNavQueryService.h"
+#include "JGPlayerContextSubsystem.h"
 #include "Engine/World.h"
 #include "DrawDebugHelpers.h"
 #include "GameFramework/Character.h"
@@ -19,6 +23,7 @@ UJGTaskNode_FindCutOffLocation::UJGTaskNode_FindCutOffLocation()
 	AheadDistance = 300.0f; // cm
 	MaxSpeedBonus = 300.0f; // cm/s (added to normal)
 	CachedNormalWalkSpeed = 0.0f;
+	UseAsyncQueries = false;
 	
 	// Make sure we can abort
 	bNotifyTick = false;
@@ -77,15 +82,15 @@ EBTNodeResult::Type UJGTaskNode_FindCutOffLocation::ExecuteTask(UBehaviorTreeCom
 	FVector normalizedDirection = direction.GetSafeNormal();
 
 	// Player context
-	APawn* playerPawn = GetWorld() && GetWorld()->GetFirstPlayerController() ? GetWorld()->GetFirstPlayerController()->GetPawn() : nullptr;
-	if (!IsValid(playerPawn))
+	const FJGPlayerContext* player = UJGPlayerContextSubsystem::FindClosest(world, currentLocation);
+	if (!player)
 	{
 		UE_LOG(LogTemp, Warning, TEXT("JGTaskNode_FindCutoffLocation: Player pawn not found"));
 		return EBTNodeResult::Failed;
 	}
 
-	FVector playerLocation = playerPawn->GetActorLocation();
-	FVector playerVelocity = playerPawn->GetVelocity();
+	FVector playerLocation = player->Location;
+	FVector playerVelocity = player->Velocity;
 
 	// Movement component and cache/reset normal speed
 	ACharacter* npcCharacter = Cast<ACharacter>(controlledPawn);
@@ -101,28 +106,50 @@ EBTNodeResult::Type UJGTaskNode_FindCutOffLocation::ExecuteTask(UBehaviorTreeCom
 	}
 
 	// Compute cutoff target ahead of player along the desired direction
-	FVector targetLocation;
-	bool foundValidPoint = FindCutoffLocation(navSystem, currentLocation, normalizedDirection,
+	TArray<FVector, TInlineAllocator<18>> candidates;
+	GetCutoffCandidates(currentLocation, normalizedDirection,
 		playerLocation,
 		playerVelocity,
 		AheadDistance,
 		MaxSearchRadius,
-		targetLocation);
+		candidates);
 
-	if (foundValidPoint)
+	FVector targetLocation;
+	bool foundValidPoint = FindLaneCutoffLocation(world, candidates, MaxSearchRadius, targetLocation);
+
+	// Without the lane, the candidates can be projected in one batch by the nav query service
+	UJGNavQueryService* queryService = UseAsyncQueries ? world->GetSubsystem<UJGNavQueryService>() : nullptr;
+	if (!foundValidPoint && queryService)
 	{
-		// Apply a temporary speed boost to ensure we can reach the cutoff
-		float boostedSpeed = CachedNormalWalkSpeed + MaxSpeedBonus;
-		if (moveComp && moveComp->MaxWalkSpeed < boostedSpeed)
-		{
-			moveComp->MaxWalkSpeed = boostedSpeed;
-		}
+		TWeakObjectPtr<UCharacterMovementComponent> weakMoveComp = moveComp;
+		FJGNavQueryTaskMemory* memory = CastInstanceNodeMemory<FJGNavQueryTaskMemory>(nodeMemory);
+		memory->RequestId = queryService->RequestProjections(candidates, FVector(MaxSearchRadius),
+			FJGNavProjectionsDelegate::CreateWeakLambda(&ownerComp, [this, &ownerComp, weakMoveComp](TConstArrayView<FJGNavProjectionResult> results)
+			{
+				// Same priority as the synchronous search, the first candidate that projects wins
+				const int32 resultIndex = results.IndexOfByPredicate([](const FJGNavProjectionResult& result) { return result.Success; });
+				if (resultIndex != INDEX_NONE)
+				{
+					ApplyCutoffLocation(ownerComp, weakMoveComp.Get(), results[resultIndex].Location);
+					FinishLatentTask(ownerComp, EBTNodeResult::Succeeded);
+				}
+				else
+				{
+					UE_LOG(LogTemp, Warning, TEXT("JGTaskNode_FindCutoffLocation: Could not find cutoff point"));
+					FinishLatentTask(ownerComp, EBTNodeResult::Failed);
+				}
+			}));
+		return EBTNodeResult::InProgress;
+	}
 
-		// Store the target location in the blackboard
-		blackboardComp->SetValueAsVector(TargetLocationKey.SelectedKeyName, targetLocation);
-		UE_LOG(LogTemp, Log, TEXT("JGTaskNode_FindCutoffLocation: Cutoff target: %s (ahead=%.1f)"), *targetLocation.ToString(), AheadDistance);
-		DrawDebugSphere(world, targetLocation, 20.0f, 12, FColor::Green, false, 5.0f);
-		
+	if (!foundValidPoint)
+	{
+		foundValidPoint = FindCutoffLocation(world, candidates, MaxSearchRadius, targetLocation);
+	}
+
+	if (foundValidPoint)
+	{
+		ApplyCutoffLocation(ownerComp, moveComp, targetLocation);
 		return EBTNodeResult::Succeeded;
 	}
 	else
@@ -132,6 +159,41 @@ EBTNodeResult::Type UJGTaskNode_FindCutOffLocation::ExecuteTask(UBehaviorTreeCom
 	}
 }
 
+EBTNodeResult::Type UJGTaskNode_FindCutOffLocation::AbortTask(UBehaviorTreeComponent& ownerComp, uint8* nodeMemory)
+{
+	FJGNavQueryTaskMemory* memory = CastInstanceNodeMemory<FJGNavQueryTaskMemory>(nodeMemory);
+	if (UJGNavQueryService* queryService = ownerComp.GetWorld() ? ownerComp.GetWorld()->GetSubsystem<UJGNavQueryService>() : nullptr)
+	{
+		queryService->CancelRequest(memory->RequestId);
+	}
+	memory->RequestId = 0;
+
+	return EBTNodeResult::Aborted;
+}
+
+uint16 UJGTaskNode_FindCutOffLocation::GetInstanceMemorySize() const
+{
+	return sizeof(FJGNavQueryTaskMemory);
+}
+
+void UJGTaskNode_FindCutOffLocation::ApplyCutoffLocation(UBehaviorTreeComponent& ownerComp, UCharacterMovementComponent* moveComp, const FVector& targetLocation) const
+{
+	// Apply a temporary speed boost to ensure we can reach the cutoff
+	float boostedSpeed = CachedNormalWalkSpeed + MaxSpeedBonus;
+	if (moveComp && moveComp->MaxWalkSpeed < boostedSpeed)
+	{
+		moveComp->MaxWalkSpeed = boostedSpeed;
+	}
+
+	// Store the target location in the blackboard
+	if (UBlackboardComponent* blackboardComp = ownerComp.GetBlackboardComponent())
+	{
+		blackboardComp->SetValueAsVector(TargetLocationKey.SelectedKeyName, targetLocation);
+	}
+	UE_LOG(LogTemp, Log, TEXT("JGTaskNode_FindCutoffLocation: Cutoff target: %s (ahead=%.1f)"), *targetLocation.ToString(), AheadDistance);
+	DrawDebugSphere(ownerComp.GetWorld(), targetLocation, 20.0f, 12, FColor::Green, false, 5.0f);
+}
+
 FString UJGTaskNode_FindCutOffLocation::GetStaticDescription() const
 {
 	return FString::Printf(TEXT("Find Cutoff Location\nDirection Key: %s\nTarget Location Key: %s\nMax Search Radius: %.1f\nAhead Distance: %.1f\nMax Speed Bonus: %.1f"),
@@ -142,20 +204,14 @@ FString UJGTaskNode_FindCutOffLocation::GetStaticDescription() const
 		MaxSpeedBonus);
 }
 
-bool UJGTaskNode_FindCutOffLocation::FindCutoffLocation(UNavigationSystemV1* navSystem,
-	const FVector& npcLocation,
+void UJGTaskNode_FindCutOffLocation::GetCutoffCandidates(const FVector& npcLocation,
 	const FVector& direction,
 	const FVector& playerLocation,
 	const FVector& playerVelocity,
 	float aheadDistance,
 	float maxSearchRadius,
-	FVector& outLocation) const
+	TArray<FVector, TInlineAllocator<18>>& outCandidates) const
 {
-	if (!IsValid(navSystem))
-	{
-		return false;
-	}
-
 	// Align strictly with the sidewalk direction and operate in 2D
 	FVector moveDir = direction.GetSafeNormal();
 	if (moveDir.IsNearlyZero())
@@ -174,73 +230,55 @@ bool UJGTaskNode_FindCutOffLocation::FindCutoffLocation(UNavigationSystemV1* nav
 
 	// Ideal point: ahead of the player along the lane (no lateral offset)
 	FVector2D ideal2D = playerLoc2D + moveDir2D * desiredLead;
-	FVector ideal3D(ideal2D.X, ideal2D.Y, playerLocation.Z);
-
-	UWorld* world = navSystem->GetWorld();
-
-	FNavLocation navLocation;
-	if (navSystem->ProjectPointToNavigation(ideal3D, navLocation, FVector(maxSearchRadius)))
-	{
-		outLocation = navLocation.Location;
-		if (IsValid(world))
-		{
-			DrawDebugLine(world, playerLocation, ideal3D, FColor::Cyan, false, 2.0f, 0, 1.5f);
-			DrawDebugSphere(world, outLocation, 22.0f, 12, FColor::Green, false, 2.0f);
-		}
-		return true;
-	}
+	outCandidates.Add(FVector(ideal2D.X, ideal2D.Y, playerLocation.Z));
 
-	// Longitudinal search only (keeps to the same lane)
+	// Longitudinal search only (keeps to the same lane), backward then further ahead from ideal
 	const int32 numSteps = 8;
 	const float step = FMath::Max(25.0f, maxSearchRadius / (float)numSteps);
 	for (int32 i = 1; i <= numSteps; ++i)
 	{
 		const float delta = step * (float)i;
 
-		// Step backward from ideal
 		FVector2D testBack2D = ideal2D - moveDir2D * delta;
-		FVector testBack3D(testBack2D.X, testBack2D.Y, playerLocation.Z);
-		if (navSystem->ProjectPointToNavigation(testBack3D, navLocation, FVector(maxSearchRadius)))
-		{
-			outLocation = navLocation.Location;
-			if (IsValid(world))
-			{
-				DrawDebugSphere(world, outLocation, 20.0f, 12, FColor::Green, false, 2.0f);
-			}
-			return true;
-		}
+		outCandidates.Add(FVector(testBack2D.X, testBack2D.Y, playerLocation.Z));
 
-		// Step further ahead from ideal
 		FVector2D testAhead2D = ideal2D + moveDir2D * delta;
-		FVector testAhead3D(testAhead2D.X, testAhead2D.Y, playerLocation.Z);
-		if (navSystem->ProjectPointToNavigation(testAhead3D, navLocation, FVector(maxSearchRadius)))
-		{
-			outLocation = navLocation.Location;
-			if (IsValid(world))
-			{
-				DrawDebugSphere(world, outLocation, 20.0f, 12, FColor::Green, false, 2.0f);
-			}
-			return true;
-		}
+		outCandidates.Add(FVector(testAhead2D.X, testAhead2D.Y, playerLocation.Z));
 	}
 
 	// Fallback: ahead of the NPC along the lane
 	FVector2D npcAhead2D = FVector2D(npcLocation.X, npcLocation.Y) + moveDir2D * aheadDistance;
-	FVector npcAhead3D(npcAhead2D.X, npcAhead2D.Y, npcLocation.Z);
-	if (navSystem->ProjectPointToNavigation(npcAhead3D, navLocation, FVector(maxSearchRadius)))
+	outCandidates.Add(FVector(npcAhead2D.X, npcAhead2D.Y, npcLocation.Z));
+}
+
+bool UJGTaskNode_FindCutOffLocation::FindLaneCutoffLocation(UWorld* world, TConstArrayView<FVector> candidates, float maxSearchRadius, FVector& outLocation) const
+{
+	// The sidewalk lane gives the nearest walkable point along the lane directly, covering the same distance as the
+	// longitudinal search
+	const FVector& ideal3D = candidates[0];
+	if (FJGSidewalkLane::ProjectPoint(world, ideal3D, outLocation, maxSearchRadius * 2.0f)
+		|| FJGSidewalkLane::ProjectPoint(world, candidates.Last(), outLocation, maxSearchRadius))
 	{
-		outLocation = navLocation.Location;
-		if (IsValid(world))
-		{
-			DrawDebugSphere(world, outLocation, 22.0f, 12, FColor::Yellow, false, 2.0f);
-		}
+		DrawDebugSphere(world, outLocation, 22.0f, 12, FColor::Green, false, 2.0f);
 		return true;
 	}
 
-	if (IsValid(world))
+	return false;
+}
+
+bool UJGTaskNode_FindCutOffLocation::FindCutoffLocation(UWorld* world, TConstArrayView<FVector> candidates, float maxSearchRadius, FVector& outLocation) const
+{
+	// Projections go through the shared cache, the search keeps hitting the same cells
+	for (int32 candidateIndex = 0; candidateIndex < candidates.Num(); candidateIndex++)
 	{
-		DrawDebugSphere(world, ideal3D, 12.0f, 10, FColor::Red, false, 2.0f);
+		if (UJGNavProjectionCache::ProjectPoint(world, candidates[candidateIndex], FVector(maxSearchRadius), outLocation))
+		{
+			const bool isNpcFallback = candidateIndex == candidates.Num() - 1;
+			DrawDebugSphere(world, outLocation, 22.0f, 12, isNpcFallback ? FColor::Yellow : FColor::Green, false, 2.0f);
+			return true;
+		}
 	}
 
+	DrawDebugSphere(world, candidates[0], 12.0f, 10, FColor::Red, false, 2.0f);
 	return false;
-}
\ No newline at end of file
+}
@@ -1,6 +1,9 @@
 #include "JGTaskNode_SetTargetAlongDirection.h"
 #include "AIController.h"
 #include "NavigationSystem.h"
+#include "JGSidewalkLane.h"
+#include "JGNavProjectionCache.h"
+#include "JGNavQueryService.h"
 #include "GameFramework/Character.h"
 #include "GameFramework/CharacterMovementComponent.h"
 
@@ -10,6 +13,7 @@ UJGTaskNode_SetTargetAlongDirection::UJGTaskNode_SetTargetAlongDirection()
 	StepDistance = 600.0f;
 	MaxSearchRadius = 300.0f;
 	NormalWalkSpeed = 200.0f;
+	UseAsyncQueries = false;
 
 	bNotifyTick = false;
 }
@@ -40,19 +44,61 @@ EBTNodeResult::Type UJGTaskNode_SetTargetAlongDirection::ExecuteTask(UBehaviorTr
 	const FVector desired = npcLoc + moveDir * StepDistance;
 
 	UWorld* world = npc->GetWorld();
-	UNavigationSystemV1* nav = world ? FNavigationSystem::GetCurrent<UNavigationSystemV1>(world) : nullptr;
 
+	// The sidewalk lane answers without a navmesh query, the navmesh is only used before the lane has chunks
 	FVector out = desired;
-	if (IsValid(nav))
+	if (!FJGSidewalkLane::ProjectPoint(world, desired, out, MaxSearchRadius))
 	{
-		FNavLocation navLoc;
-		if (nav->ProjectPointToNavigation(desired, navLoc, FVector(MaxSearchRadius)))
+		UJGNavQueryService* queryService = UseAsyncQueries && world ? world->GetSubsystem<UJGNavQueryService>() : nullptr;
+		if (queryService)
 		{
-			out = navLoc.Location;
+			TWeakObjectPtr<APawn> weakNpc = npc;
+			FJGNavQueryTaskMemory* memory = CastInstanceNodeMemory<FJGNavQueryTaskMemory>(nodeMemory);
+			memory->RequestId = queryService->RequestProjections(MakeArrayView(&desired, 1), FVector(MaxSearchRadius),
+				FJGNavProjectionsDelegate::CreateWeakLambda(&ownerComp, [this, &ownerComp, weakNpc, desired](TConstArrayView<FJGNavProjectionResult> results)
+				{
+					APawn* npc = weakNpc.Get();
+					if (IsValid(npc))
+					{
+						ApplyTarget(ownerComp, npc, results[0].Success ? results[0].Location : desired);
+					}
+					FinishLatentTask(ownerComp, IsValid(npc) ? EBTNodeResult::Succeeded : EBTNodeResult::Failed);
+				}));
+			return EBTNodeResult::InProgress;
 		}
+
+		UJGNavProjectionCache::ProjectPoint(world, desired, FVector(MaxSearchRadius), out);
+	}
+
+	ApplyTarget(ownerComp, npc, out);
+
+	return EBTNodeResult::Succeeded;
+}
+
+EBTNodeResult::Type UJGTaskNode_SetTargetAlongDirection::AbortTask(UBehaviorTreeComponent& ownerComp, uint8* nodeMemory)
+{
+	FJGNavQueryTaskMemory* memory = CastInstanceNodeMemory<FJGNavQueryTaskMemory>(nodeMemory);
+	if (UJGNavQueryService* queryService = ownerComp.GetWorld() ? ownerComp.GetWorld()->GetSubsystem<UJGNavQueryService>() : nullptr)
+	{
+		queryService->CancelRequest(memory->RequestId);
 	}
+	memory->RequestId = 0;
+
+	return EBTNodeResult::Aborted;
+}
 
-	bb->SetValueAsVector(TargetLocationKey.SelectedKeyName, out);
+uint16 UJGTaskNode_SetTargetAlongDirection::GetInstanceMemorySize() const
+{
+	return sizeof(FJGNavQueryTaskMemory);
+}
+
+void UJGTaskNode_SetTargetAlongDirection::ApplyTarget(UBehaviorTreeComponent& ownerComp, APawn* npc, const FVector& out) const
+{
+	UBlackboardComponent* bb = ownerComp.GetBlackboardComponent();
+	if (IsValid(bb))
+	{
+		bb->SetValueAsVector(TargetLocationKey.SelectedKeyName, out);
+	}
 
 	if (ACharacter* character = Cast<ACharacter>(npc))
 	{
@@ -65,19 +111,18 @@ EBTNodeResult::Type UJGTaskNode_SetTargetAlongDirection::ExecuteTask(UBehaviorTr
 		}
 	}
 
-	DrawDebugSphere(world, out, 20.0f, 12, FColor::Green, false, 5.0f);
-
-	return EBTNodeResult::Succeeded;
+	DrawDebugSphere(npc->GetWorld(), out, 20.0f, 12, FColor::Green, false, 5.0f);
 }
 
 FString UJGTaskNode_SetTargetAlongDirection::GetStaticDescription() const
 {
-	return FString::Printf(TEXT("Set Target Along Direction\nDirection Key: %s\nTarget Location Key: %s\nStep Distance: %.1f\nMax Search Radius: %.1f\nNormal Walk Speed: %.1f"),
+	return FString::Printf(TEXT("Set Target Along Direction\nDirection Key: %s\nTarget Location Key: %s\nStep Distance: %.1f\nMax Search Radius: %.1f\nNormal Walk Speed: %.1f%s"),
 		*DirectionKey.SelectedKeyName.ToString(),
 		*TargetLocationKey.SelectedKeyName.ToString(),
 		StepDistance,
 		MaxSearchRadius,
-		NormalWalkSpeed);
+		NormalWalkSpeed,
+		UseAsyncQueries ? TEXT("\nAsync Queries") : TEXT(""));
 }
 
 
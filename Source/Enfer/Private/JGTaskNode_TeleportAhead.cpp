@@ -1,7 +1,10 @@
 #include "JGTaskNode_TeleportAhead.h"
 #include "AIController.h"
 #include "NavigationSystem.h"
-#include "Kismet/GameplayStatics.h"
+#include "JGSidewalkLane.h"
+#include "JGNavProjectionCache.h"
+#include "JGNavQueryService.h"
+#include "JGPlayerContextSubsystem.h"
 
 UJGTaskNode_TeleportAhead::UJGTaskNode_TeleportAhead()
 {
@@ -9,6 +12,7 @@ UJGTaskNode_TeleportAhead::UJGTaskNode_TeleportAhead()
 	AheadDistance = 100.0f;
 	ProjectToNavMesh = true;
 	MaxSearchRadius = 300.0f;
+	UseAsyncQueries = false;
 
 	bNotifyTick = false;
 }
@@ -22,8 +26,8 @@ EBTNodeResult::Type UJGTaskNode_TeleportAhead::ExecuteTask(UBehaviorTreeComponen
 		return EBTNodeResult::Failed;
 	}
 
-	APawn* player = UGameplayStatics::GetPlayerPawn(npc, 0);
-	if (!IsValid(player))
+	const FJGPlayerContext* player = UJGPlayerContextSubsystem::FindClosest(npc->GetWorld(), npc->GetActorLocation());
+	if (!player)
 	{
 		return EBTNodeResult::Failed;
 	}
@@ -45,39 +49,67 @@ EBTNodeResult::Type UJGTaskNode_TeleportAhead::ExecuteTask(UBehaviorTreeComponen
 	moveDir2D.Normalize();
 
 	// Compute target ahead of player at fixed distance, clamp Y to player's Y
-	FVector playerLoc = player->GetActorLocation();
-	FVector2D player2D(playerLoc.X, playerLoc.Y);
+	FVector2D player2D = player->Location2D;
 	FVector2D target2D = player2D + moveDir2D * AheadDistance;
 	target2D.Y = player2D.Y;
 
 	FVector target3D(target2D.X, target2D.Y, 0.0f);
 
-	// Optionally project to navmesh
-	if (ProjectToNavMesh)
+	// Optionally project to navmesh, through the sidewalk lane when it has chunks
+	if (ProjectToNavMesh && !FJGSidewalkLane::ProjectPoint(npc->GetWorld(), target3D, target3D, MaxSearchRadius))
 	{
 		UWorld* world = npc->GetWorld();
-		if (IsValid(world))
+		UJGNavQueryService* queryService = UseAsyncQueries && world ? world->GetSubsystem<UJGNavQueryService>() : nullptr;
+		if (queryService)
 		{
-			UNavigationSystemV1* nav = FNavigationSystem::GetCurrent<UNavigationSystemV1>(world);
-			if (IsValid(nav))
-			{
-				FNavLocation navLoc;
-				if (nav->ProjectPointToNavigation(target3D, navLoc, FVector(MaxSearchRadius)))
+			TWeakObjectPtr<APawn> weakNpc = npc;
+			FJGNavQueryTaskMemory* memory = CastInstanceNodeMemory<FJGNavQueryTaskMemory>(nodeMemory);
+			memory->RequestId = queryService->RequestProjections(MakeArrayView(&target3D, 1), FVector(MaxSearchRadius),
+				FJGNavProjectionsDelegate::CreateWeakLambda(&ownerComp, [this, &ownerComp, weakNpc, target3D](TConstArrayView<FJGNavProjectionResult> results)
 				{
-					target3D = navLoc.Location;
-				}
-			}
+					APawn* npc = weakNpc.Get();
+					if (IsValid(npc))
+					{
+						TeleportNpc(npc, results[0].Success ? results[0].Location : target3D);
+					}
+					FinishLatentTask(ownerComp, IsValid(npc) ? EBTNodeResult::Succeeded : EBTNodeResult::Failed);
+				}));
+			return EBTNodeResult::InProgress;
 		}
+
+		UJGNavProjectionCache::ProjectPoint(world, target3D, FVector(MaxSearchRadius), target3D);
+	}
+
+	TeleportNpc(npc, target3D);
+
+	return EBTNodeResult::Succeeded;
+}
+
+EBTNodeResult::Type UJGTaskNode_TeleportAhead::AbortTask(UBehaviorTreeComponent& ownerComp, uint8* nodeMemory)
+{
+	FJGNavQueryTaskMemory* memory = CastInstanceNodeMemory<FJGNavQueryTaskMemory>(nodeMemory);
+	if (UJGNavQueryService* queryService = ownerComp.GetWorld() ? ownerComp.GetWorld()->GetSubsystem<UJGNavQueryService>() : nullptr)
+	{
+		queryService->CancelRequest(memory->RequestId);
 	}
+	memory->RequestId = 0;
 
+	return EBTNodeResult::Aborted;
+}
+
+uint16 UJGTaskNode_TeleportAhead::GetInstanceMemorySize() const
+{
+	return sizeof(FJGNavQueryTaskMemory);
+}
+
+void UJGTaskNode_TeleportAhead::TeleportNpc(APawn* npc, FVector target3D) const
+{
 	target3D += FVector(0.0f, 0.0f, npc->GetDefaultHalfHeight());
 
 	DrawDebugSphere(npc->GetWorld(), target3D, 20.0f, 12, FColor::Green, false, 2.0f);
 	
 	// Teleport NPC
 	npc->SetActorLocation(target3D, false, nullptr, ETeleportType::TeleportPhysics);
-
-	return EBTNodeResult::Succeeded;
 }
 
 FString UJGTaskNode_TeleportAhead::GetStaticDescription() const
@@ -0,0 +1,57 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Public/JGCorridorVisibility.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FJGCorridorVisibilityTest, "Enfer.Chunk.CorridorVisibility", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FJGCorridorVisibilityTest::RunTest(const FString& parameters)
+{
+	// Sidewalk on Y [0, 500] at eye height [110, 230], one facade along the far side of Y = 0
+	FJGVisibilityBakeSettings settings;
+	settings.SidewalkY = 250.0f;
+	settings.SidewalkHalfWidth = 250.0f;
+	settings.EyeHeight = 170.0f;
+	settings.EyeHeightRange = 60.0f;
+	settings.CellSize = 200.0f;
+	settings.OccluderShrink = 25.0f;
+
+	auto makeComponent = [](const FVector& min, const FVector& max, bool isOccluder)
+	{
+		FJGVisibilityComponent component;
+		component.Bounds = FBox(min, max);
+		component.IsOccluder = isOccluder;
+		return component;
+	};
+
+	TArray<FJGVisibilityComponent> components;
+	const int32 facade = components.Add(makeComponent(FVector(-1000.0f, -300.0f, 0.0f), FVector(1200.0f, -100.0f, 1000.0f), true));
+	const int32 behindFacade = components.Add(makeComponent(FVector(0.0f, -600.0f, 50.0f), FVector(200.0f, -400.0f, 300.0f), false));
+	const int32 onSidewalk = components.Add(makeComponent(FVector(0.0f, 50.0f, 0.0f), FVector(200.0f, 100.0f, 100.0f), false));
+	const int32 aboveFacade = components.Add(makeComponent(FVector(0.0f, -600.0f, 50.0f), FVector(200.0f, -400.0f, 2000.0f), false));
+	const int32 pastFacadeEnd = components.Add(makeComponent(FVector(1500.0f, -600.0f, 50.0f), FVector(2000.0f, -400.0f, 300.0f), false));
+	const int32 behindSeeThrough = components.Add(makeComponent(FVector(0.0f, 600.0f, 0.0f), FVector(200.0f, 800.0f, 300.0f), false));
+	components.Add(makeComponent(FVector(-1000.0f, 520.0f, 0.0f), FVector(1200.0f, 560.0f, 1000.0f), false));
+
+	TestTrue(TEXT("The facade itself is visible"), FJGCorridorVisibility::IsVisibleFromCell(components, facade, 0.0f, 200.0f, settings));
+	TestFalse(TEXT("A component fully behind the facade is hidden"), FJGCorridorVisibility::IsVisibleFromCell(components, behindFacade, 0.0f, 200.0f, settings));
+	TestTrue(TEXT("A component on the sidewalk is visible"), FJGCorridorVisibility::IsVisibleFromCell(components, onSidewalk, 0.0f, 200.0f, settings));
+	TestTrue(TEXT("A component rising above the facade is visible"), FJGCorridorVisibility::IsVisibleFromCell(components, aboveFacade, 0.0f, 200.0f, settings));
+	TestTrue(TEXT("A component past the end of the facade is visible"), FJGCorridorVisibility::IsVisibleFromCell(components, pastFacadeEnd, 0.0f, 200.0f, settings));
+	TestTrue(TEXT("A component behind a non-occluder is visible"), FJGCorridorVisibility::IsVisibleFromCell(components, behindSeeThrough, 0.0f, 200.0f, settings));
+
+	// Seen from far along the sidewalk, the segments slip past the end of the facade
+	TestTrue(TEXT("A component behind the facade is visible from beyond its end"), FJGCorridorVisibility::IsVisibleFromCell(components, behindFacade, 2400.0f, 2600.0f, settings));
+
+	TArray<FJGVisibilityCell> cells;
+	FJGCorridorVisibility::ComputeCells(components, 0.0f, 1000.0f, settings, cells);
+	TestEqual(TEXT("One cell per CellSize"), cells.Num(), 5);
+	TestTrue(TEXT("The first cell hides the component behind the facade"), cells[0].HiddenComponents.Contains(behindFacade));
+	TestFalse(TEXT("The first cell never hides the facade"), cells[0].HiddenComponents.Contains(facade));
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
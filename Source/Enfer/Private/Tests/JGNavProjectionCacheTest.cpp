@@ -0,0 +1,77 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Public/JGNavProjectionCache.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FJGNavProjectionCacheTest, "Enfer.Navigation.ProjectionCache", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FJGNavProjectionCacheTest::RunTest(const FString& parameters)
+{
+	const float cellSize = 25.0f;
+	const FVector queryExtent(50.0f, 50.0f, 250.0f);
+
+	auto makeKey = [cellSize](const FVector& point, const FVector& extent)
+	{
+		FJGNavProjectionKey key;
+		FJGNavProjectionEntries::MakeKey(point, extent, cellSize, key);
+		return key;
+	};
+
+	FJGNavProjectionKey key;
+	TestFalse(TEXT("A cell size of 0 disables the cache"), FJGNavProjectionEntries::MakeKey(FVector::ZeroVector, queryExtent, 0.0f, key));
+	TestTrue(TEXT("Points in the same cell share a key"), makeKey(FVector(101.0f, 1.0f, 0.0f), queryExtent) == makeKey(FVector(124.0f, 24.0f, 24.0f), queryExtent));
+	TestFalse(TEXT("Points in neighbouring cells do not share a key"), makeKey(FVector(124.0f, 0.0f, 0.0f), queryExtent) == makeKey(FVector(125.0f, 0.0f, 0.0f), queryExtent));
+	TestFalse(TEXT("Negative coordinates round down"), makeKey(FVector(-1.0f, 0.0f, 0.0f), queryExtent) == makeKey(FVector(1.0f, 0.0f, 0.0f), queryExtent));
+	TestFalse(TEXT("Query extents do not share a key"), makeKey(FVector::ZeroVector, queryExtent) == makeKey(FVector::ZeroVector, FVector(50.0f)));
+
+	FJGNavProjectionEntries entries;
+	const FJGNavProjectionKey onSidewalk = makeKey(FVector(110.0f, 10.0f, 0.0f), queryExtent);
+	const FJGNavProjectionKey offNavmesh = makeKey(FVector(110.0f, 900.0f, 0.0f), queryExtent);
+	entries.Store(3, onSidewalk, true, FVector(110.0f, 10.0f, 5.0f));
+	entries.Store(3, offNavmesh, false, FVector(1.0f));
+	entries.Store(4, onSidewalk, true, FVector(110.0f, 10.0f, 5.0f));
+
+	const FJGNavProjectionResult* result = entries.Find(3, onSidewalk);
+	if (TestNotNull(TEXT("A stored projection is found"), result))
+	{
+		TestTrue(TEXT("A stored success is found as one"), result->Success && result->Location.Equals(FVector(110.0f, 10.0f, 5.0f)));
+	}
+	result = entries.Find(3, offNavmesh);
+	if (TestNotNull(TEXT("A stored failure is found"), result))
+	{
+		TestFalse(TEXT("A stored failure is found as one"), result->Success);
+	}
+	TestNull(TEXT("Chunks do not share entries"), entries.Find(5, onSidewalk));
+	TestEqual(TEXT("Entries are counted over chunks"), entries.Num(), 3);
+
+	TestTrue(TEXT("Invalidating a chunk with entries reports it"), entries.InvalidateChunk(4));
+	TestNull(TEXT("Invalidating a chunk drops its entries"), entries.Find(4, onSidewalk));
+	TestNotNull(TEXT("Invalidating a chunk keeps the other chunks"), entries.Find(3, onSidewalk));
+	TestFalse(TEXT("Invalidating a chunk without entries reports nothing"), entries.InvalidateChunk(4));
+
+	entries.Store(4, onSidewalk, true, FVector::ZeroVector);
+	TestTrue(TEXT("Marking a chunk rebuilding drops its entries"), entries.MarkRebuilding(4) && !entries.Find(4, onSidewalk));
+	TestTrue(TEXT("A chunk is rebuilding until the generation finished"), entries.IsRebuilding(4) && !entries.IsRebuilding(3));
+
+	TestEqual(TEXT("Finishing the generation invalidates no rebuilt chunk without entries"), entries.OnGenerationFinished(), 0);
+	TestFalse(TEXT("Finishing the generation ends the rebuild"), entries.IsRebuilding(4));
+	TestNull(TEXT("Finishing the generation drops failed results"), entries.Find(3, offNavmesh));
+	TestNotNull(TEXT("Finishing the generation keeps successful results"), entries.Find(3, onSidewalk));
+
+	entries.MarkRebuilding(3);
+	entries.Store(3, onSidewalk, true, FVector::ZeroVector);
+	TestEqual(TEXT("Finishing the generation invalidates the rebuilt chunks"), entries.OnGenerationFinished(), 1);
+	TestEqual(TEXT("Nothing is left of the rebuilt chunks"), entries.Num(), 0);
+
+	entries.Store(6, onSidewalk, true, FVector::ZeroVector);
+	entries.MarkRebuilding(6);
+	entries.Store(6, onSidewalk, true, FVector::ZeroVector);
+	TestTrue(TEXT("Removing a chunk drops its entries"), entries.RemoveChunk(6) && entries.Num() == 0);
+	TestFalse(TEXT("Removing a chunk ends its rebuild"), entries.IsRebuilding(6));
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
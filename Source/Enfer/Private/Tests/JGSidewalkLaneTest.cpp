@@ -0,0 +1,78 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Public/JGSidewalkLane.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FJGSidewalkLaneTest, "Enfer.Navigation.SidewalkLane", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FJGSidewalkLaneTest::RunTest(const FString& parameters)
+{
+	// Chunk on X [0, 1000], the agents' centres walk on Y [50, 450]
+	auto computeIntervals = [](TConstArrayView<FBox2D> obstacles, float minBandWidth)
+	{
+		TArray<FJGLaneInterval> intervals;
+		FJGSidewalkLane::ComputeIntervals(0.0f, 1000.0f, 50.0f, 450.0f, 0.0f, obstacles, minBandWidth, intervals);
+		return intervals;
+	};
+
+	auto testInterval = [this](const TCHAR* what, const FJGLaneInterval& interval, float minX, float maxX, float minY, float maxY)
+	{
+		TestTrue(what, FMath::IsNearlyEqual(interval.MinX, minX) && FMath::IsNearlyEqual(interval.MaxX, maxX)
+			&& FMath::IsNearlyEqual(interval.MinY, minY) && FMath::IsNearlyEqual(interval.MaxY, maxY));
+	};
+
+	TArray<FJGLaneInterval> intervals = computeIntervals({}, 0.0f);
+	if (TestEqual(TEXT("An empty chunk is one interval"), intervals.Num(), 1))
+	{
+		testInterval(TEXT("An empty chunk keeps the whole band"), intervals[0], 0.0f, 1000.0f, 50.0f, 450.0f);
+	}
+
+	const FBox2D acrossSidewalk(FVector2D(400.0f, 0.0f), FVector2D(600.0f, 500.0f));
+	intervals = computeIntervals({ acrossSidewalk }, 0.0f);
+	if (TestEqual(TEXT("An obstacle across the sidewalk cuts the lane"), intervals.Num(), 2))
+	{
+		testInterval(TEXT("The lane stops at the obstacle"), intervals[0], 0.0f, 400.0f, 50.0f, 450.0f);
+		testInterval(TEXT("The lane starts again past the obstacle"), intervals[1], 600.0f, 1000.0f, 50.0f, 450.0f);
+	}
+
+	const FBox2D besideSidewalk(FVector2D(400.0f, 300.0f), FVector2D(600.0f, 500.0f));
+	intervals = computeIntervals({ besideSidewalk }, 0.0f);
+	if (TestEqual(TEXT("An obstacle leaving a gap splits the lane"), intervals.Num(), 3))
+	{
+		testInterval(TEXT("The band is narrowed to the gap beside the obstacle"), intervals[1], 400.0f, 600.0f, 50.0f, 300.0f);
+		testInterval(TEXT("The whole band is back past the obstacle"), intervals[2], 600.0f, 1000.0f, 50.0f, 450.0f);
+	}
+
+	intervals = computeIntervals({ besideSidewalk }, 300.0f);
+	TestEqual(TEXT("A gap narrower than the minimum width cuts the lane"), intervals.Num(), 2);
+
+	// The wider part past the second obstacle can only be reached through it
+	const FBox2D first(FVector2D(200.0f, 150.0f), FVector2D(400.0f, 500.0f));
+	const FBox2D second(FVector2D(400.0f, 100.0f), FVector2D(600.0f, 300.0f));
+	intervals = computeIntervals({ first, second }, 0.0f);
+	if (TestEqual(TEXT("Staggered obstacles give one interval per stretch"), intervals.Num(), 4))
+	{
+		testInterval(TEXT("The band beside the first obstacle"), intervals[1], 200.0f, 400.0f, 50.0f, 150.0f);
+		testInterval(TEXT("The band continuing it beside the second obstacle"), intervals[2], 400.0f, 600.0f, 50.0f, 100.0f);
+	}
+
+	// Queries clamp onto the narrowed band
+	FJGSidewalkLane lane;
+	lane.SetChunkIntervals(0, computeIntervals({ besideSidewalk }, 0.0f));
+
+	FVector walkable;
+	TestTrue(TEXT("A point beside the obstacle projects"), lane.FindNearestWalkablePoint(FVector(500.0f, 400.0f, 100.0f), walkable));
+	TestEqual(TEXT("The projection is moved into the gap, on the ground"), walkable, FVector(500.0f, 300.0f, 0.0f));
+	TestFalse(TEXT("A point too far past the end of the lane does not project"), lane.FindNearestWalkablePoint(FVector(1100.0f, 200.0f, 0.0f), walkable, 50.0f));
+	TestTrue(TEXT("A point past the end of the lane projects without a limit"), lane.FindNearestWalkablePoint(FVector(1100.0f, 200.0f, 0.0f), walkable));
+	TestEqual(TEXT("The projection is clamped to the end of the lane"), walkable, FVector(1000.0f, 200.0f, 0.0f));
+
+	lane.RemoveChunk(0);
+	TestTrue(TEXT("Removing the only chunk empties the lane"), lane.IsEmpty());
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
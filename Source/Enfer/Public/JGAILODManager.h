@@ -0,0 +1,115 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "JGAILODManager.generated.h"
+
+class AJGNPC;
+class UBehaviorTreeComponent;
+
+// How much AI an NPC runs, from the most to the least
+UENUM(BlueprintType)
+enum class EJGAILODTier : uint8
+{
+	// Behavior tree and services at their authored rates
+	Full,
+	// Behavior tree running, services ticking ReducedServiceIntervalScale times less often
+	Reduced,
+	// Brain and movement paused, the NPC slides along the sidewalk lane at the speed it had
+	Far
+};
+
+USTRUCT(BlueprintType)
+struct FJGAILODStats
+{
+	GENERATED_BODY()
+
+	// NPCs per tier, as of the last evaluation
+	UPROPERTY(BlueprintReadOnly, Category = "AI LOD")
+	int32 FullCount = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "AI LOD")
+	int32 ReducedCount = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "AI LOD")
+	int32 FarCount = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "AI LOD")
+	int32 TotalTransitions = 0;
+};
+
+/**
+ * Puts every AJGNPC in an AI LOD tier from its distance to the closest player and whether it was rendered recently:
+ * full near and visible, reduced service rate in the mid range or out of sight, paused brain and a kinematic lane walk far away.
+ * An NPC never goes past its MaxAILODTier. The tier counts are in "stat JGAI" and the JGAI CSV category.
+ */
+UCLASS(ClassGroup=(Custom), meta=(BlueprintSpawnableComponent))
+class ENFER_API UJGAILODManager : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	UJGAILODManager();
+
+	virtual void TickComponent(float deltaTime, ELevelTick tickType, FActorComponentTickFunction* thisTickFunction) override;
+
+	// NPCs closer than this to a player, and rendered, run at the full tier
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "AI LOD", meta = (ClampMin = "0.0"))
+	float FullDistance;
+
+	// NPCs further than this from every player go to the far tier
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "AI LOD", meta = (ClampMin = "0.0"))
+	float FarDistance;
+
+	// Extra distance an NPC has to cover past a threshold to leave its tier, so that it doesn't flicker between two
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "AI LOD", meta = (ClampMin = "0.0"))
+	float Hysteresis;
+
+	// NPCs not rendered for this long are treated as out of sight (s)
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "AI LOD", meta = (ClampMin = "0.0"))
+	float VisibilityTolerance;
+
+	// Multiplier of the service intervals at the reduced tier
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "AI LOD", meta = (ClampMin = "1.0"))
+	float ReducedServiceIntervalScale;
+
+	// Seconds between two tier evaluations, far NPCs are still moved every frame
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "AI LOD", meta = (ClampMin = "0.0"))
+	float EvaluationInterval;
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "AI LOD")
+	FJGAILODStats GetAILODStats() const { return Stats; }
+
+	// AI LOD manager of the world's game mode, nullptr if there is none
+	static UJGAILODManager* Get(const UWorld* world);
+
+	// Multiplier the services of the tree's NPC apply to their interval
+	static float GetServiceIntervalScale(const UBehaviorTreeComponent& ownerComp);
+
+	void RegisterNPC(AJGNPC* npc);
+	void UnregisterNPC(AJGNPC* npc);
+
+	// Back to the full tier right away, for NPCs going back to the pool
+	void ResetTier(AJGNPC* npc);
+
+private:
+	struct FNPCState
+	{
+		TWeakObjectPtr<AJGNPC> NPC;
+
+		// Velocity of the kinematic lane walk at the far tier
+		FVector FarVelocity = FVector::ZeroVector;
+	};
+
+	void EvaluateTiers();
+	void SetTier(FNPCState& state, EJGAILODTier tier);
+	void MoveFarNPCs(float deltaTime);
+
+	TArray<FNPCState> NPCStates;
+
+	float TimeSinceEvaluation;
+
+	FJGAILODStats Stats;
+};
@@ -0,0 +1,66 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "JGAnimationBudgetManager.generated.h"
+
+class USkeletalMeshComponentBudgeted;
+
+/**
+ * Puts the NPC meshes under the world's animation budget allocator with a fixed per-frame budget, and feeds it their
+ * significance every frame: distance to the closest player, lowered behind that player and off-screen. Meshes playing a montage
+ * are never skipped, so that montage notifies and the tasks waiting on them stay responsive.
+ */
+UCLASS(ClassGroup=(Custom), meta=(BlueprintSpawnableComponent))
+class ENFER_API UJGAnimationBudgetManager : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	UJGAnimationBudgetManager();
+
+	virtual void TickComponent(float deltaTime, ELevelTick tickType, FActorComponentTickFunction* thisTickFunction) override;
+
+	// If false the allocator is left as it is and meshes tick at full rate
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Animation Budget")
+	bool UseAnimationBudget;
+
+	// Game thread time per frame the NPC animations may take (ms)
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Animation Budget", meta = (EditCondition = "UseAnimationBudget", ClampMin = "0.1"))
+	float BudgetMs;
+
+	// Least significant meshes tick at most once every this many frames
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Animation Budget", meta = (EditCondition = "UseAnimationBudget", ClampMin = "1"))
+	int32 MaxTickRate;
+
+	// Distance from the player at which a mesh's significance reaches zero
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Animation Budget|Significance", meta = (ClampMin = "1.0"))
+	float SignificanceDistance;
+
+	// Meshes whose direction from the player has a lower dot with the player forward are considered behind the player
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Animation Budget|Significance", meta = (ClampMin = "-1.0", ClampMax = "1.0"))
+	float BehindCameraDot;
+
+	// Multiplier applied to the significance of meshes behind the player
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Animation Budget|Significance", meta = (ClampMin = "0.0", ClampMax = "1.0"))
+	float BehindCameraScale;
+
+	// Multiplier applied to the significance of meshes that were not rendered last frame
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Animation Budget|Significance", meta = (ClampMin = "0.0", ClampMax = "1.0"))
+	float OffscreenScale;
+
+	// Animation budget manager of the world's game mode, nullptr if there is none
+	static UJGAnimationBudgetManager* Get(const UWorld* world);
+
+	// Meshes that are not budgeted are ignored
+	void RegisterMesh(USkeletalMeshComponent* mesh);
+	void UnregisterMesh(USkeletalMeshComponent* mesh);
+
+protected:
+	virtual void BeginPlay() override;
+
+private:
+	TArray<TWeakObjectPtr<USkeletalMeshComponentBudgeted>> Meshes;
+};
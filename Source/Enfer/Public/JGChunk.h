@@ -5,8 +5,97 @@
 #include "CoreMinimal.h"
 #include "GameFramework/Actor.h"
 #include "Components/BoxComponent.h"
+#include "JGCorridorVisibility.h"
 #include "JGChunk.generated.h"
 
+class UMaterialInterface;
+class URecastNavMeshDataChunk;
+class UStaticMesh;
+
+// Replaces the mesh of a named static mesh component of the chunk or its building
+USTRUCT(BlueprintType)
+struct FJGChunkMeshSwap
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Chunk|Variants")
+	FName ComponentName;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Chunk|Variants")
+	UStaticMesh* Mesh = nullptr;
+};
+
+// One variation of a chunk class, applied when the chunk spawns
+USTRUCT(BlueprintType)
+struct FJGChunkVariant
+{
+	GENERATED_BODY()
+
+	// Relative chance of this variant being picked
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Chunk|Variants", meta = (ClampMin = "0.0"))
+	float Chance = 1.0f;
+
+	// Written to the custom primitive data of every rendered component (read by materials through the Custom Primitive Data node)
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Chunk|Variants")
+	TArray<float> CustomPrimitiveData;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Chunk|Variants")
+	TArray<FJGChunkMeshSwap> MeshSwaps;
+
+	// Names of the props removed from the chunk or its building
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Chunk|Variants")
+	TArray<FName> RemovedComponents;
+};
+
+// Rendering settings applied to a chunk by the significance manager
+USTRUCT(BlueprintType)
+struct FJGChunkRenderState
+{
+	GENERATED_BODY()
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Chunk|Significance")
+	bool CastShadows = true;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Chunk|Significance")
+	bool ShowDetails = true;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Chunk|Significance")
+	bool TickEnabled = true;
+
+	bool operator==(const FJGChunkRenderState& other) const
+	{
+		return CastShadows == other.CastShadows && ShowDetails == other.ShowDetails && TickEnabled == other.TickEnabled;
+	}
+
+	bool operator!=(const FJGChunkRenderState& other) const
+	{
+		return !(*this == other);
+	}
+};
+
+// How draw distances are derived from a component's size and its distance to the sidewalk
+USTRUCT(BlueprintType)
+struct FJGCullDistanceSettings
+{
+	GENERATED_BODY()
+
+	// Draw distance granted per unit of bounding sphere radius
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Chunk|Culling", meta = (ClampMin = "0.0"))
+	float DistancePerRadius = 40.0f;
+
+	// Draw distance is never lower than this
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Chunk|Culling", meta = (ClampMin = "0.0"))
+	float MinDistance = 2000.0f;
+
+	// Draw distance is never higher than this
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Chunk|Culling", meta = (ClampMin = "0.0"))
+	float MaxDistance = 25000.0f;
+
+	// Components with a bounding sphere radius above this (facades, roofs) are never culled
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Chunk|Culling", meta = (ClampMin = "0.0"))
+	float NeverCullRadius = 800.0f;
+};
+
 UCLASS()
 class ENFER_API AJGChunk : public AActor
 {
@@ -27,6 +116,54 @@ public:
 
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Chunk")
 	USceneComponent* FloorParent;
+
+	// Variations applied at spawn time, so that one chunk class covers a whole chunk group.
+	// Chunks spawned with a deferred building reuse the extents measured the first time their variant spawned
+	// (variants without mesh swaps or removals share the class's).
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Chunk|Variants")
+	TArray<FJGChunkVariant> Variants;
+
+	UPROPERTY(EditDefaultsOnly, Category = "Chunk|Visibility")
+	FJGVisibilityBakeSettings VisibilityBakeSettings;
+
+	// Average number of NPCs the NPC spawner places on the sidewalk when a chunk of this class spawns,
+	// a mirror chunk adds its own to the pair's
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Chunk|NPC", meta = (ClampMin = "0.0"))
+	float NPCSpawnDensity = 0.0f;
+
+	// Building components the visibility cells refer to, baked by SetupVisibilitySets
+	UPROPERTY(VisibleDefaultsOnly, Category = "Chunk|Visibility")
+	TArray<FName> VisibilityComponentNames;
+
+	// Hidden building components per camera cell along the sidewalk, baked by SetupVisibilitySets
+	UPROPERTY()
+	TArray<FJGVisibilityCell> VisibilityCells;
+
+	// Chunk space X at which the first visibility cell starts
+	UPROPERTY()
+	float VisibilityCellsMinX = 0.0f;
+
+	// Offset of the mirror chunk on Y used by the nav tile bake, set it to the level generator's MirrorYOffset
+	// (tiles baked with another offset are not attached)
+	UPROPERTY(EditDefaultsOnly, Category = "Chunk|Navigation")
+	float NavBakeMirrorYOffset = 500.0f;
+
+	// Navmesh tiles of the chunk and its mirror chunk, baked by SetupNavTiles into their own package next to the chunk Blueprint
+	// (the Blueprint's defaults do not keep subobjects across recompiles)
+	UPROPERTY()
+	URecastNavMeshDataChunk* BakedNavTiles = nullptr;
+
+	// Recast tile of the chunk's first tile when the tiles were baked
+	UPROPERTY()
+	FIntPoint BakedNavTileOrigin = FIntPoint::ZeroValue;
+
+	// NavBakeMirrorYOffset when the tiles were baked
+	UPROPERTY()
+	float BakedNavMirrorYOffset = 0.0f;
+
+	// Nav tile size the tiles were baked with, they are unusable with another one
+	UPROPERTY()
+	float BakedNavTileSize = 0.0f;
 	
 	void SetIndex(int32 index);
 	void GetBuildingBounds(FVector& location, FVector& extent) const;
@@ -34,5 +171,112 @@ public:
 	void SetupTriggerBox();
 	void SetupWallBoxCollision();
 
+	// Bake the visibility cells of the building from a temporary instance of it
+	void SetupVisibilitySets();
+
+	// Bake the navmesh tiles of the chunk and its mirror chunk, using the navmesh and bounds volume of the editor world
+	void SetupNavTiles();
+
+	// False for a chunk whose variant swaps or removes components, the bake only matches the authored geometry,
+	// and for tiles baked with another tile size or mirror offset than the level's
+	bool HasBakedNavTiles(float navTileSize, float mirrorYOffset) const;
+
+	// Take the chunk and its building out of navmesh generation, for chunks whose nav tiles are attached from the bake.
+	// Must be called in the frame the components registered, so that their registration is dropped without dirtying the navmesh.
+	void DisableNavigationRelevance();
+
+	// Take the components that do not reach into the nav bounds on Y and Z (roofs, facades) out of navmesh generation,
+	// the floors and what stands on the sidewalk stay relevant. Same timing constraint as DisableNavigationRelevance.
+	void DisableNavigationRelevanceOutside(const FBox& navBounds);
+
+	// Hide the building components that cannot be seen from the camera cell, show them back when it moves to another cell
+	void UpdateVisibilityCell(const FVector& cameraLocation);
+
+	// Pick a variant index according to the variants' chances (INDEX_NONE if the chunk has no variant)
+	int32 PickRandomVariant(const FRandomStream& randomStream) const;
+
+	// Apply the variant to the chunk and its building, a deferred building gets it once created
+	void ApplyVariant(int32 variantIndex);
+
+	int32 GetVariantIndex() const { return VariantIndex; }
+
+	// Whether the variant swaps or removes components, which changes the footprint and the navigable geometry
+	bool DoesVariantChangeGeometry(int32 variantIndex) const;
+
+	// Hide the floor pieces and drop their collision, when the level generator provides a continuous floor strip instead.
+	// They stay in the navmesh as its walkable geometry, stretched over [navMinX, navMaxX] in world space to cover the tile padding.
+	void DisableLocalFloor(float navMinX, float navMaxX);
+
+	// Material of the first floor piece, nullptr if the chunk has none
+	UMaterialInterface* GetFloorMaterial() const;
+
+	// Bounds of the whole chunk (building included), computed once after spawning
+	const FBox& GetChunkBounds();
+
+	// Toggle shadow casting, detail visibility and ticking of the building components
+	void ApplyRenderState(const FJGChunkRenderState& renderState, FName detailComponentTag, float detailMaxRadius);
+
+	const FJGChunkRenderState& GetRenderState() const { return RenderState; }
+
+	// Assign draw distances to the rendered components from their size and their lateral distance to the sidewalk line.
+	// A scale of 0 restores the authored draw distances.
+	void ApplyCullDistances(const FJGCullDistanceSettings& settings, float sidewalkCenterY, float scale);
+
+	// Estimated memory of the meshes, materials and textures used by the chunk and its building, in bytes
+	int64 EstimateAssetMemory() const;
+
+	// Keep the building child actor from being created, call from the spawn's CustomPreSpawnInitalization
+	// (native components register before SpawnActor returns)
+	void DeferBuilding();
+
+	// Create the building of a chunk spawned with DeferBuilding
+	void FinishDeferredBuilding();
+
+	// True once the building exists, with its collision in the physics scene
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Chunk")
+	bool IsCollisionReady() const;
+
+	// Static meshes of a chunk class and its building class, read from the class defaults without spawning anything
+	static void GetClassStaticMeshes(UClass* chunkClass, TArray<UStaticMesh*>& outMeshes);
+
 	int32 ChunkLogicalIndex;
+
+private:
+	// Register the building child actor component, which spawns the building where the chunk stands
+	void CreateBuilding();
+
+	int32 VariantIndex = INDEX_NONE;
+
+	bool IsBuildingDeferred = false;
+
+	// Visibility cell currently applied (INDEX_NONE when every component is shown)
+	int32 CurrentVisibilityCell = INDEX_NONE;
+
+	// Building components matching VisibilityComponentNames, resolved on first use
+	TArray<TWeakObjectPtr<UPrimitiveComponent>> VisibilityComponents;
+	bool HasResolvedVisibilityComponents = false;
+
+	// Gather the building components the render state acts upon (done once, on first use)
+	void CacheRenderComponents(FName detailComponentTag, float detailMaxRadius);
+
+	FBox CachedChunkBounds = FBox(ForceInit);
+
+	FJGChunkRenderState RenderState;
+
+	bool HasCachedRenderComponents = false;
+
+	// Components that were authored to cast shadows
+	TArray<TWeakObjectPtr<UPrimitiveComponent>> ShadowComponents;
+
+	// Small props and components tagged as detail
+	TArray<TWeakObjectPtr<UPrimitiveComponent>> DetailComponents;
+
+	// Components whose tick was enabled when the chunk spawned
+	TArray<TWeakObjectPtr<UActorComponent>> TickingComponents;
+
+	// Actors (building child actor included) whose tick was enabled when the chunk spawned
+	TArray<TWeakObjectPtr<AActor>> TickingActors;
+
+	// Draw distances authored on the components before ApplyCullDistances first changed them
+	TMap<TWeakObjectPtr<UPrimitiveComponent>, float> AuthoredCullDistances;
 };
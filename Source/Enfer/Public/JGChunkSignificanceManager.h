@@ -0,0 +1,91 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "JGChunk.h"
+#include "JGChunkSignificanceManager.generated.h"
+
+class UJGLevelGenerator;
+
+/**
+ * Scores every active chunk once per frame from its distance and facing relative to the player camera,
+ * and toggles shadow casting, detail visibility and ticking of the least significant ones in batches
+ */
+UCLASS(ClassGroup=(Custom), meta=(BlueprintSpawnableComponent))
+class ENFER_API UJGChunkSignificanceManager : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	UJGChunkSignificanceManager();
+
+	virtual void TickComponent(float deltaTime, ELevelTick tickType, FActorComponentTickFunction* thisTickFunction) override;
+
+	// Distance from the camera at which a chunk's significance reaches zero
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Significance", meta = (ClampMin = "1.0"))
+	float SignificanceDistance;
+
+	// Chunks whose direction from the camera has a lower dot with the camera forward are considered behind the camera
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Significance", meta = (ClampMin = "-1.0", ClampMax = "1.0"))
+	float BehindCameraDot;
+
+	// Multiplier applied to the significance of chunks behind the camera
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Significance", meta = (ClampMin = "0.0", ClampMax = "1.0"))
+	float BehindCameraScale;
+
+	// Chunks below this significance stop casting dynamic shadows
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Significance|Thresholds", meta = (ClampMin = "0.0", ClampMax = "1.0"))
+	float ShadowThreshold;
+
+	// Chunks below this significance hide their detail components
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Significance|Thresholds", meta = (ClampMin = "0.0", ClampMax = "1.0"))
+	float DetailThreshold;
+
+	// Chunks below this significance stop ticking their building actor
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Significance|Thresholds", meta = (ClampMin = "0.0", ClampMax = "1.0"))
+	float TickThreshold;
+
+	// Components carrying this tag are treated as detail components
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Significance|Details")
+	FName DetailComponentTag;
+
+	// Components with a bounding sphere radius below this are treated as detail components (0 = tag only)
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Significance|Details", meta = (ClampMin = "0.0"))
+	float DetailMaxRadius;
+
+	// Maximum number of chunks whose render state changes in a single frame
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Significance", meta = (ClampMin = "1"))
+	int32 ChunksPerBatch;
+
+	// If true, building components the chunk's baked visibility cells mark as hidden from the camera cell are not rendered
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Significance")
+	bool UseVisibilitySets;
+
+	// Compute the significance of a chunk for the given camera, in [0, 1]
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Significance")
+	float ComputeSignificance(AJGChunk* chunk, const FVector& cameraLocation, const FVector& cameraForward) const;
+
+protected:
+	virtual void BeginPlay() override;
+
+	// Reference to the level generator (automatically found)
+	UPROPERTY(Transient)
+	UJGLevelGenerator* LevelGenerator;
+
+private:
+	struct FPendingRenderState
+	{
+		TWeakObjectPtr<AJGChunk> Chunk;
+		FJGChunkRenderState RenderState;
+		float Significance;
+	};
+
+	FJGChunkRenderState GetRenderStateForSignificance(float significance) const;
+
+	void EvaluateChunk(AJGChunk* chunk, const FVector& cameraLocation, const FVector& cameraForward);
+
+	// Chunks whose render state differs from the one they should have this frame
+	TArray<FPendingRenderState> PendingRenderStates;
+};
@@ -0,0 +1,92 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "JGCorridorVisibility.generated.h"
+
+// Where the camera can be relative to a chunk, and which components may hide others, for the visibility bake
+USTRUCT(BlueprintType)
+struct FJGVisibilityBakeSettings
+{
+	GENERATED_BODY()
+
+	// Y of the sidewalk center in chunk space (half the level generator's MirrorYOffset, also true for mirror chunks)
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Chunk|Visibility")
+	float SidewalkY = 250.0f;
+
+	// Camera positions are sampled this far on both sides of the sidewalk center
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Chunk|Visibility", meta = (ClampMin = "0.0"))
+	float SidewalkHalfWidth = 250.0f;
+
+	// Camera height above the chunk ground
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Chunk|Visibility")
+	float EyeHeight = 170.0f;
+
+	// Camera positions are sampled this far above and below EyeHeight
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Chunk|Visibility", meta = (ClampMin = "0.0"))
+	float EyeHeightRange = 60.0f;
+
+	// Length of a camera cell along the sidewalk
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Chunk|Visibility", meta = (ClampMin = "10.0"))
+	float CellSize = 200.0f;
+
+	// Cells cover the chunk and this far before and after it, where the camera stands in neighbouring chunks
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Chunk|Visibility", meta = (ClampMin = "0.0"))
+	float NeighbourDistance = 3000.0f;
+
+	// Components at least this tall and this wide along one horizontal axis hide what is behind them (facades, walls)
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Chunk|Visibility", meta = (ClampMin = "0.0"))
+	float OccluderMinSize = 300.0f;
+
+	// Occluder boxes are shrunk by this much on every side, since a mesh rarely fills its bounding box
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Chunk|Visibility", meta = (ClampMin = "0.0"))
+	float OccluderShrink = 25.0f;
+
+	// Components carrying this tag never hide anything (glass, fences, see-through facades)
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Chunk|Visibility")
+	FName SeeThroughTag = TEXT("SeeThrough");
+};
+
+// Components that cannot be seen from anywhere in one camera cell
+USTRUCT()
+struct FJGVisibilityCell
+{
+	GENERATED_BODY()
+
+	// Indices into the chunk's visibility components, in increasing order
+	UPROPERTY()
+	TArray<int32> HiddenComponents;
+};
+
+// A component as seen by the visibility solver, in chunk space
+struct FJGVisibilityComponent
+{
+	FBox Bounds = FBox(ForceInit);
+	bool IsOccluder = false;
+};
+
+/**
+ * Offline, CPU-only visibility solver for a first-person camera walking the sidewalk of a chunk row.
+ * The sidewalk is cut into cells along X, and a component is hidden in a cell only if a single occluder blocks every segment
+ * from the cell's whole camera volume to the component's whole bounding box, so the result is conservative.
+ * Only the chunk's own occluders are used, so the result stays valid whatever chunks end up next to it.
+ */
+struct ENFER_API FJGCorridorVisibility
+{
+	// Compute one cell per settings.CellSize from minX to maxX
+	static void ComputeCells(TConstArrayView<FJGVisibilityComponent> components, float minX, float maxX, const FJGVisibilityBakeSettings& settings, TArray<FJGVisibilityCell>& outCells);
+
+	// Whether the component can be seen from any camera position of the cell [cellMinX, cellMaxX]
+	static bool IsVisibleFromCell(TConstArrayView<FJGVisibilityComponent> components, int32 componentIndex, float cellMinX, float cellMaxX, const FJGVisibilityBakeSettings& settings);
+
+	// Whether a box of this size hides what is behind it
+	static bool IsOccluderSize(const FBox& bounds, const FJGVisibilityBakeSettings& settings);
+
+	// Whether every segment from the camera box to the target box goes through the occluder
+	static bool IsBoxHiddenBy(const FBox& cameraBox, const FBox& targetBounds, const FBox& occluder);
+
+private:
+	// Volume the camera can be in while it stands in the cell
+	static FBox GetCameraBox(float cellMinX, float cellMaxX, const FJGVisibilityBakeSettings& settings);
+};
@@ -0,0 +1,57 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MassEntityTypes.h"
+#include "JGCrowdFragments.generated.h"
+
+UENUM(BlueprintType)
+enum class EJGCrowdLOD : uint8
+{
+	// Promoted to a full AJGNPC actor
+	Actor,
+	// Instance of one of the crowd meshes
+	Instanced,
+	// Only simulated
+	Hidden
+};
+
+// Lane walking state of a crowd agent
+USTRUCT()
+struct FJGCrowdAgentFragment : public FMassFragment
+{
+	GENERATED_BODY()
+
+	// On the ground of the sidewalk
+	FVector Location = FVector::ZeroVector;
+
+	// 1 walks toward +X, -1 toward -X
+	float Direction = 1.0f;
+
+	float Speed = 0.0f;
+
+	// Index in the crowd manager's CrowdMeshes
+	int32 VisualIndex = 0;
+
+	// Lost its lane this frame, the entity is destroyed at the end of the phase
+	bool IsOffLane = false;
+};
+
+USTRUCT()
+struct FJGCrowdRepresentationFragment : public FMassFragment
+{
+	GENERATED_BODY()
+
+	EJGCrowdLOD LOD = EJGCrowdLOD::Hidden;
+
+	// 2D distance to the closest player, as of the last representation update
+	float PlayerDistance = 0.0f;
+};
+
+// Agents whose movement is driven by their promoted actor
+USTRUCT()
+struct FJGCrowdPromotedTag : public FMassTag
+{
+	GENERATED_BODY()
+};
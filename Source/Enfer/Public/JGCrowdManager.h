@@ -0,0 +1,151 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "MassArchetypeTypes.h"
+#include "MassEntityTypes.h"
+#include "JGCrowdFragments.h"
+#include "JGCrowdManager.generated.h"
+
+class AJGNPC;
+class UInstancedStaticMeshComponent;
+class UJGLevelGenerator;
+class UJGNPCPool;
+class UMassEntitySubsystem;
+class UStaticMesh;
+struct FJGChunkWindowChange;
+
+USTRUCT(BlueprintType)
+struct FJGCrowdStats
+{
+	GENERATED_BODY()
+
+	// Live crowd agents
+	UPROPERTY(BlueprintReadOnly, Category = "Crowd")
+	int32 AgentCount = 0;
+
+	// Agents by representation, as of the last frame
+	UPROPERTY(BlueprintReadOnly, Category = "Crowd")
+	int32 ActorCount = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Crowd")
+	int32 InstancedCount = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Crowd")
+	int32 HiddenCount = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Crowd")
+	int32 TotalSpawned = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Crowd")
+	int32 TotalPromotions = 0;
+};
+
+/**
+ * Ambient pedestrian crowd of the sidewalk, simulated as Mass entities. Agents are spawned in the chunks entering the window,
+ * walked along the sidewalk lane by UJGCrowdLaneFollowProcessor and represented by UJGCrowdRepresentationProcessor:
+ * instanced meshes in the visible range, and full CrowdActorClass actors from the NPC pool near the player, up to MaxPromotedAgents.
+ * The scripted front and back NPCs are not part of the crowd.
+ */
+UCLASS(ClassGroup=(Custom), meta=(BlueprintSpawnableComponent))
+class ENFER_API UJGCrowdManager : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	UJGCrowdManager();
+
+	// Average number of agents spawned in each chunk entering the window (0 = no crowd)
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Crowd", meta = (ClampMin = "0.0"))
+	float AgentsPerChunk;
+
+	// No agent is spawned past this many live agents
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Crowd", meta = (ClampMin = "0"))
+	int32 MaxAgents;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Crowd", meta = (ClampMin = "0.0"))
+	float MinWalkSpeed;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Crowd", meta = (ClampMin = "0.0"))
+	float MaxWalkSpeed;
+
+	// Meshes of the instanced representation, each agent picks one when it spawns
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Crowd|Representation")
+	TArray<UStaticMesh*> CrowdMeshes;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Crowd|Representation")
+	bool CastInstanceShadows;
+
+	// Agents further than this from every player are not rendered
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Crowd|Representation", meta = (ClampMin = "0.0"))
+	float VisibleDistance;
+
+	// Actor class agents are promoted to, it should not run the scripted NPCs' behavior tree (None = no promotion)
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Crowd|Promotion")
+	TSubclassOf<AJGNPC> CrowdActorClass;
+
+	// Agents closer than this to a player are promoted to an actor
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Crowd|Promotion", meta = (ClampMin = "0.0"))
+	float PromoteDistance;
+
+	// Promoted agents further than this from every player go back to the simulation, keep it above PromoteDistance
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Crowd|Promotion", meta = (ClampMin = "0.0"))
+	float DemoteDistance;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Crowd|Promotion", meta = (ClampMin = "0"))
+	int32 MaxPromotedAgents;
+
+	// Distance ahead of a promoted actor at which it turns back before the end of its walkable interval
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Crowd|Promotion", meta = (ClampMin = "0.0"))
+	float PromotedLookAhead;
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Crowd")
+	FJGCrowdStats GetCrowdStats() const { return Stats; }
+
+	// Crowd manager of the world's game mode, nullptr if there is none
+	static UJGCrowdManager* Get(const UWorld* world);
+
+	// Called by the processors
+	void BeginRepresentation();
+	void AddInstance(const FJGCrowdAgentFragment& agent);
+	void CountAgent(EJGCrowdLOD lod);
+	void EndRepresentation();
+	AJGNPC* PromoteAgent(const FMassEntityHandle& entity, const FJGCrowdAgentFragment& agent);
+	void DemoteAgent(const FMassEntityHandle& entity, FJGCrowdAgentFragment& agent);
+	AJGNPC* GetPromotedActor(const FMassEntityHandle& entity) const;
+	void NotifyAgentsDestroyed(int32 count);
+
+protected:
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	// Reference to the level generator (automatically found)
+	UPROPERTY(Transient)
+	UJGLevelGenerator* LevelGenerator;
+
+	UPROPERTY(Transient)
+	UMassEntitySubsystem* EntitySubsystem;
+
+	UPROPERTY(Transient)
+	UJGNPCPool* NPCPool;
+
+	// One per crowd mesh
+	UPROPERTY(Transient)
+	TArray<UInstancedStaticMeshComponent*> InstanceComponents;
+
+private:
+	void OnChunkWindowChanged(const FJGChunkWindowChange& windowChange);
+	void SpawnAgentsInChunk(int32 chunkIndex);
+	void CreateInstanceComponents();
+
+	FMassArchetypeHandle AgentArchetype;
+
+	// Instance transforms of the frame, per crowd mesh
+	TArray<TArray<FTransform>> InstanceTransforms;
+
+	TMap<FMassEntityHandle, TWeakObjectPtr<AJGNPC>> PromotedActors;
+
+	FJGCrowdStats Stats;
+};
@@ -0,0 +1,48 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MassProcessor.h"
+#include "MassEntityQuery.h"
+#include "JGCrowdProcessors.generated.h"
+
+/**
+ * Walks the crowd agents along the sidewalk lane, turning them back at the end of a walkable interval.
+ * Agents whose lane left the window are destroyed. Promoted agents are moved by their actor instead.
+ */
+UCLASS()
+class ENFER_API UJGCrowdLaneFollowProcessor : public UMassProcessor
+{
+	GENERATED_BODY()
+
+public:
+	UJGCrowdLaneFollowProcessor();
+
+protected:
+	virtual void ConfigureQueries(const TSharedRef<FMassEntityManager>& entityManager) override;
+	virtual void Execute(FMassEntityManager& entityManager, FMassExecutionContext& context) override;
+
+private:
+	FMassEntityQuery EntityQuery;
+};
+
+/**
+ * Picks the representation of every crowd agent from its distance to the closest player: a full actor when close,
+ * an instanced mesh in the visible range, nothing beyond. Promotes and demotes agents through the crowd manager.
+ */
+UCLASS()
+class ENFER_API UJGCrowdRepresentationProcessor : public UMassProcessor
+{
+	GENERATED_BODY()
+
+public:
+	UJGCrowdRepresentationProcessor();
+
+protected:
+	virtual void ConfigureQueries(const TSharedRef<FMassEntityManager>& entityManager) override;
+	virtual void Execute(FMassEntityManager& entityManager, FMassExecutionContext& context) override;
+
+private:
+	FMassEntityQuery EntityQuery;
+};
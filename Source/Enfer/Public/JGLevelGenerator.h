@@ -5,9 +5,15 @@
 #include "CoreMinimal.h"
 #include "Components/ActorComponent.h"
 #include "JGChunk.h"
+#include "JGNavTileGrid.h"
+#include "JGSidewalkLane.h"
 #include "JGLevelGenerator.generated.h"
 
 class AJGNPC;
+class UMaterialInterface;
+class UStaticMesh;
+class UStaticMeshComponent;
+struct FStreamableHandle;
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnPlayerEnteredChunk, int32, NewChunkIndex, int32, PreviousChunkIndex);
 
 USTRUCT(BlueprintType)
@@ -24,13 +30,19 @@ struct FChunkData
 	// The extents of the chunk actor
 	FVector ActorExtents;
 
+	// World bounds of the chunk and its mirror chunk
+	FBox Bounds;
+
+	// Bounds nav is generated in for the pair, the sidewalk band only with UseSidewalkNavBounds
+	FBox NavBounds;
+
 	FChunkData()
-		: ChunkActor(nullptr), MirrorChunkActor(nullptr), ActorExtents(FVector::ZeroVector)
+		: ChunkActor(nullptr), MirrorChunkActor(nullptr), ActorExtents(FVector::ZeroVector), Bounds(ForceInit), NavBounds(ForceInit)
 	{
 	}
 
-	FChunkData(AJGChunk* chunkActor, AJGChunk* mirrorChunk, const FVector& actorExtents)
-		: ChunkActor(chunkActor), MirrorChunkActor(mirrorChunk) , ActorExtents(actorExtents)
+	FChunkData(AJGChunk* chunkActor, AJGChunk* mirrorChunk, const FVector& actorExtents, const FBox& bounds, const FBox& navBounds)
+		: ChunkActor(chunkActor), MirrorChunkActor(mirrorChunk) , ActorExtents(actorExtents), Bounds(bounds), NavBounds(navBounds)
 	{
 	}
 
@@ -40,6 +52,82 @@ struct FChunkData
     }
 };
 
+// A chunk entering or leaving the active window
+struct FJGChunkWindowEntry
+{
+	int32 LogicalIndex = 0;
+
+	// World bounds of the chunk and its mirror chunk
+	FBox Bounds = FBox(ForceInit);
+
+	// Bounds nav is generated in for the pair
+	FBox NavBounds = FBox(ForceInit);
+
+	// Still valid for removed chunks during the broadcast, they are destroyed right after
+	TWeakObjectPtr<AJGChunk> ChunkActor;
+	TWeakObjectPtr<AJGChunk> MirrorChunkActor;
+};
+
+// Read-only view of a change of the active window, only valid during the broadcast
+struct FJGChunkWindowChange
+{
+	TConstArrayView<FJGChunkWindowEntry> AddedChunks;
+	TConstArrayView<FJGChunkWindowEntry> RemovedChunks;
+
+	int32 CenterChunkIndex = 0;
+
+	// INDEX_NONE for the initial window
+	int32 PreviousCenterChunkIndex = INDEX_NONE;
+};
+
+DECLARE_MULTICAST_DELEGATE_OneParam(FOnChunkWindowChanged, const FJGChunkWindowChange&);
+
+// Residency of a streamed chunk class
+struct FJGChunkClassResidency
+{
+	TSharedPtr<FStreamableHandle> LoadHandle;
+
+	// Estimated memory of the class' meshes, materials and textures, measured the first time it spawns
+	int64 MemoryCost = 0;
+
+	// Number of active chunks (mirror chunks excluded) of this class
+	int32 ActiveCount = 0;
+
+	// Time at which the last chunk of this class left the window
+	double LastUsedTime = 0.0;
+
+	int32 EvictionCount = 0;
+};
+
+// Memory report of the streamed chunk classes
+USTRUCT(BlueprintType)
+struct FJGChunkAssetStats
+{
+	GENERATED_BODY()
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Level Generation|Streaming")
+	float BudgetMB = 0.0f;
+
+	// Estimated memory of the loaded streamed classes
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Level Generation|Streaming")
+	float UsedMB = 0.0f;
+
+	// Loaded classes with chunks in the window
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Level Generation|Streaming")
+	int32 InUseClasses = 0;
+
+	// Loaded classes without chunks in the window, candidates for eviction
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Level Generation|Streaming")
+	int32 CachedClasses = 0;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Level Generation|Streaming")
+	int32 Evictions = 0;
+
+	// Evicted classes that were loaded again
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Level Generation|Streaming")
+	int32 Reloads = 0;
+};
+
 UCLASS(ClassGroup=(Custom), meta=(BlueprintSpawnableComponent))
 class ENFER_API UJGLevelGenerator : public UActorComponent
 {
@@ -52,13 +140,105 @@ public:
 	UPROPERTY(EditAnywhere, Category = "Level Generation", meta = (ClampMin = "1"))
 	int32 NumChunksOnEitherSide;
 
+	// Seed of the chunk class and variant picks, 0 picks a new seed every session
+	UPROPERTY(EditAnywhere, Category = "Level Generation")
+	int32 RandomSeed;
+
+	// Chunk classes that stay loaded for the whole session
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Level Generation")
 	TArray<TSubclassOf<AJGChunk>> ChunkClasses;
 
+	// Chunk classes loaded asynchronously when picked, and released once out of the window when over ChunkAssetBudgetMB
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Level Generation|Streaming")
+	TArray<TSoftClassPtr<AJGChunk>> StreamedChunkClasses;
+
+	// Memory the streamed chunk classes may keep loaded, least recently used classes out of the window are released above it (0 = no limit)
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Level Generation|Streaming", meta = (ClampMin = "0"))
+	int32 ChunkAssetBudgetMB;
+
+	// If true, chunks of classes that spawned before are created without their building, which is created later in a time-sliced batch
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Level Generation|Streaming")
+	bool UseDeferredBuildings;
+
+	// Time per frame spent creating deferred buildings and preparing chunk collision (ms)
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Level Generation|Streaming", meta = (EditCondition = "UseDeferredBuildings", ClampMin = "0.0"))
+	float DeferredWorkBudgetMs;
+
+	// Deferred buildings this close to the player's chunk are created right away when the player changes chunk
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Level Generation|Streaming", meta = (EditCondition = "UseDeferredBuildings", ClampMin = "0"))
+	int32 CollisionReadyDistance;
+
 	// Offset applied on Y axis when spawning the mirror chunk
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Level Generation")
 	float MirrorYOffset;
 
+	// If true, the generator owns one continuous floor strip covering both rows of active chunks,
+	// and the chunks' own floor pieces are hidden when they spawn (their wall collision is kept, it follows the facades).
+	// The strip does not affect navigation, the hidden chunk floors stay in the navmesh.
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Level Generation|Corridor")
+	bool UseCorridorStrips;
+
+	// Mesh stretched along the active chunks to form the floor strip (1m unit mesh centered on its pivot, like the chunk floors)
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Level Generation|Corridor", meta = (EditCondition = "UseCorridorStrips"))
+	UStaticMesh* FloorStripMesh;
+
+	// Material of the floor strip, the floor material of the first spawned chunk is used when not set
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Level Generation|Corridor", meta = (EditCondition = "UseCorridorStrips"))
+	UMaterialInterface* FloorStripMaterial;
+
+	// Width of a chunk floor on the Y axis (the floor strip covers the floors of both rows)
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Level Generation|Corridor", meta = (EditCondition = "UseCorridorStrips", ClampMin = "0.0"))
+	float FloorStripWidth;
+
+	// Thickness of the floor strip, its top is at the chunks' ground level
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Level Generation|Corridor", meta = (EditCondition = "UseCorridorStrips", ClampMin = "1.0"))
+	float FloorStripThickness;
+
+	// If true, chunk boundaries are padded to line up with the nav tiles of the Recast navmesh,
+	// and chunk classes that waste less padding are preferred
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Level Generation|Navigation")
+	bool AlignChunksToNavTiles;
+
+	// If true, chunks whose class has baked nav tiles are left out of navmesh generation, the nav mesh manager attaches their tiles instead
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Level Generation|Navigation", meta = (EditCondition = "AlignChunksToNavTiles"))
+	bool UsePrebakedNavTiles;
+
+	// Chunk classes whose padding to the next nav tile boundary exceeds this fraction of a tile are avoided when possible
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Level Generation|Navigation", meta = (EditCondition = "AlignChunksToNavTiles", ClampMin = "0.0", ClampMax = "1.0"))
+	float MaxNavTilePadding;
+
+	// If true, nav is only generated over the sidewalk band between the two rows of facades,
+	// and the chunk and building components entirely outside of it are left out of navmesh generation
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Level Generation|Navigation")
+	bool UseSidewalkNavBounds;
+
+	// Height above the ground covered by the sidewalk nav bounds, should be above the agent height
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Level Generation|Navigation", meta = (EditCondition = "UseSidewalkNavBounds", ClampMin = "0.0"))
+	float SidewalkNavHeight;
+
+	// If true, the draw distance of every chunk component is derived from its size and its distance to the sidewalk line
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Level Generation|Culling")
+	bool UseAutomaticCullDistances;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Level Generation|Culling", meta = (EditCondition = "UseAutomaticCullDistances"))
+	FJGCullDistanceSettings CullDistanceSettings;
+
+	// The sidewalk lane stays this far from the edges of the floor (agent radius)
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Level Generation|Lane", meta = (ClampMin = "0.0"))
+	float LaneEdgeMargin;
+
+	// Gaps narrower than this beside an obstacle are not walked through, obstacles leaving no wider gap cut the sidewalk lane
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Level Generation|Lane", meta = (ClampMin = "0.0"))
+	float LaneMinPassableWidth;
+
+	// Colliding components below this height above the ground can be stepped over and don't cut the lane
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Level Generation|Lane", meta = (ClampMin = "0.0"))
+	float LaneMaxStepHeight;
+
+	// Colliding components starting this high above the ground pass over the agents' heads (awnings, signs) and don't cut the lane
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Level Generation|Lane", meta = (ClampMin = "0.0"))
+	float LaneAgentHeight;
+
 	// Actor class to spawn 200m in front of player spawn
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Level Generation")
 	TSubclassOf<AJGNPC> FrontNPCClass;
@@ -78,6 +258,13 @@ protected:
 	UPROPERTY()
 	int32 PlayerCurrentChunkIndex;
 
+	// Number of chunks currently kept on either side, NumChunksOnEitherSide unless a streaming governor changes it
+	UPROPERTY(Transient)
+	int32 EffectiveChunksOnEitherSide;
+
+	// Location of the first chunk spawned into an empty window, which takes the player's chunk index
+	FVector EmptyWindowLocation;
+
 	// References to the spawned front and back actors
 	UPROPERTY()
 	AJGNPC* FrontActor;
@@ -85,15 +272,40 @@ protected:
 	UPROPERTY()
 	AJGNPC* BackActor;
 
+	// Nav tile grid the chunks are aligned to (invalid if alignment is off or there is no Recast navmesh)
+	FJGNavTileGrid NavTileGrid;
+
+	// Extents of each chunk class, learnt the first time it spawns (by path, so that streamed classes can be unloaded).
+	// Variants that swap or remove components are measured on their own, the key's variant is INDEX_NONE for the others.
+	TMap<TPair<FSoftObjectPath, int32>, FVector> ChunkClassExtents;
+
+	// Bounds of each chunk class relative to the chunk transform, learnt the first time it spawns (same keys)
+	TMap<TPair<FSoftObjectPath, int32>, FBox> ChunkClassLocalBounds;
+
+	// Residency of the streamed chunk classes that have been requested at least once
+	TMap<FSoftObjectPath, FJGChunkClassResidency> StreamedClassResidency;
+
+	int32 ChunkClassEvictions;
+	int32 ChunkClassReloads;
+
+	// Continuous floor covering the active chunks
+	UPROPERTY(Transient)
+	UStaticMeshComponent* FloorStripComponent;
+
 public:
+	virtual void TickComponent(float deltaTime, ELevelTick tickType, FActorComponentTickFunction* thisTickFunction) override;
+
 	// Called when a player enters a new chunk
 	UFUNCTION()
 	void OnPlayerEnteredChunk(int32 newChunkIndex, int32 previousChunkIndex);
 
-	// Delegate that broadcasts when player enters a new chunk
+	// Delegate that broadcasts when player enters a new chunk (Blueprint adapter of OnChunkWindowChanged)
 	UPROPERTY(BlueprintAssignable, Category = "Level Generation")
 	FOnPlayerEnteredChunk OnPlayerEnteredChunkDelegate;
 
+	// Native event broadcast with the chunks added to and removed from the window, before the removed ones are destroyed
+	FOnChunkWindowChanged& OnChunkWindowChanged() { return ChunkWindowChangedEvent; }
+
 	// Get bounds for a range of chunks (for nav mesh generation)
 	UFUNCTION(BlueprintCallable, Category = "Level Generation")
 	FBox GetChunkRangeBounds(int32 centerChunkIndex, int32 bufferSize) const;
@@ -102,11 +314,132 @@ public:
 	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Level Generation")
 	const TArray<FChunkData>& GetActiveChunks() const { return ActiveChunks; }
 
+	// Y coordinate of the middle of the sidewalk between the chunk row and the mirror row
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Level Generation")
+	float GetSidewalkCenterY() const;
+
+	// Nav bounds of the sidewalk band along a chunk pair, from below the floor strip to SidewalkNavHeight above the ground
+	FBox GetSidewalkNavBounds(const FVector& chunkLocation, float chunkLength) const;
+
+	// Nav tile grid the chunks are aligned to
+	const FJGNavTileGrid& GetNavTileGrid() const { return NavTileGrid; }
+
+	// UsePrebakedNavTiles, unless the nav mesh manager covers the navmesh with invokers (they remove the tiles they don't cover, attached ones included)
+	bool ShouldUsePrebakedNavTiles() const;
+
+	// Whether the chunk's baked nav tiles are used instead of generating its navmesh
+	bool ShouldAttachBakedNavTiles(const AJGChunk* chunk) const;
+
+	// Logical index of the active chunk spanning x (padding up to the next chunk included), INDEX_NONE outside the window
+	int32 FindChunkIndexAt(float x) const;
+
+	// Restart the chunk class and variant picks from a seed, chunks spawned from now on follow the same sequence for the same seed
+	void SetRandomSeed(int32 seed);
+
+	// Walkable intervals of the sidewalk over the active chunks
+	const FJGSidewalkLane& GetSidewalkLane() const { return SidewalkLane; }
+
+	AJGNPC* GetFrontActor() const { return FrontActor; }
+	AJGNPC* GetBackActor() const { return BackActor; }
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Level Generation|Streaming")
+	FJGChunkAssetStats GetChunkAssetStats() const;
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Level Generation")
+	int32 GetEffectiveChunksOnEitherSide() const { return EffectiveChunksOnEitherSide; }
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Level Generation")
+	int32 GetPlayerCurrentChunkIndex() const { return PlayerCurrentChunkIndex; }
+
+	// Grow or shrink the window around the player's chunk, spawning or despawning chunks right away
+	UFUNCTION(BlueprintCallable, Category = "Level Generation")
+	void SetEffectiveChunksOnEitherSide(int32 numChunks);
+
+	// Despawn the whole window and spawn it again from the player's chunk, with the chunk picks following the current seed
+	void RespawnWindow();
+
 private:
-	void SpawnChunk(bool foward);
+	// Returns false if no chunk could be spawned
+	bool SpawnChunk(bool foward);
 	void DespawnExtremityChunk(bool forward);
 	void SpawnInitialChunks();
 	void SpawnFrontAndBackActors();
+
+	// Spawn and despawn chunks at both ends until the window spans EffectiveChunksOnEitherSide around the player's chunk
+	void RebalanceWindow();
+
+	// Setup that needs the building of a freshly spawned chunk (cull distances)
+	void FinalizeChunk(AJGChunk* chunk);
+
+	// Take the components of a chunk with baked nav tiles out of navmesh generation, or those outside navBounds when it
+	// is valid. Must run in the frame they register, so when the chunk spawns and again when its deferred building is created.
+	void ApplyNavigationRelevance(AJGChunk* chunk, const FBox& navBounds);
+
+	// Compute the walkable intervals of a chunk pair from its colliding components and add them to the lane
+	void UpdateSidewalkLane(int32 chunkIndex, AJGChunk* chunk, AJGChunk* mirrorChunk, float chunkLength);
+
+	FJGSidewalkLane SidewalkLane;
+
+	FRandomStream ChunkRandomStream;
+
+	// Re-apply cull distances to every active chunk when the scale cvar changed since they were spawned
+	void RefreshCullDistancesIfNeeded();
+
+	// Cull distance scale the active chunks were set up with
+	float AppliedCullDistanceScale;
+
+	// Create the floor strip owned by the generator
+	void CreateCorridorStrips();
+
+	// Extend or trim the floor strip to the active chunks
+	void UpdateCorridorStrips();
 	
 	FChunkData GetExtremityChunkData(bool foward);
+
+	// Pick the class of the next chunk, preferring classes that fit the nav tile grid.
+	// A streamed class that is not loaded is requested and a loaded class is used in the meantime.
+	TSubclassOf<AJGChunk> PickChunkClass();
+
+	bool HasChunkClasses() const { return ChunkClasses.Num() > 0 || StreamedChunkClasses.Num() > 0; }
+
+	// Start loading a streamed chunk class, synchronously if nothing else can be spawned
+	void RequestChunkClassLoad(const TSoftClassPtr<AJGChunk>& chunkClass, bool synchronous);
+
+	// Count a chunk of a streamed class entering or leaving the window
+	void RetainChunkClass(AJGChunk* chunk);
+	void ReleaseChunkClass(UClass* chunkClass);
+
+	// Release the least recently used streamed classes out of the window until under budget
+	void TrimChunkClassResidency();
+
+	int64 GetStreamedClassesMemory() const;
+
+	void OnChunkClassLoaded(FSoftObjectPath chunkClassPath);
+
+	// Create the physics meshes of the class' static meshes, so that spawning its chunks does not cook or load them
+	void PrewarmChunkClassCollision(const FSoftObjectPath& chunkClassPath);
+
+	void QueueDeferredBuilding(AJGChunk* chunk);
+
+	// Create the building of a deferred chunk and finalize it
+	void FinishChunkBuilding(AJGChunk* chunk);
+
+	// Create the deferred buildings within maxDistance chunks of the player's chunk
+	void FlushDeferredBuildings(int32 maxDistance);
+
+	// Chunk classes whose collision still has to be prepared
+	TArray<FSoftObjectPath> CollisionPrewarmQueue;
+	TSet<FSoftObjectPath> PrewarmedChunkClasses;
+
+	// Chunks waiting for their building, mirror chunks included
+	TArray<TWeakObjectPtr<AJGChunk>> PendingBuildingChunks;
+
+	// Broadcast the chunks added and removed since the last broadcast, then destroy the removed ones
+	void BroadcastWindowChange(int32 centerChunkIndex, int32 previousCenterChunkIndex);
+
+	FOnChunkWindowChanged ChunkWindowChangedEvent;
+
+	// Window changes accumulated until the next broadcast
+	TArray<FJGChunkWindowEntry> AddedWindowEntries;
+	TArray<FJGChunkWindowEntry> RemovedWindowEntries;
 };
@@ -4,6 +4,7 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/Character.h"
+#include "JGAILODManager.h"
 #include "JGNPC.generated.h"
 
 class USkeletalMesh;
@@ -33,9 +34,10 @@ class ENFER_API AJGNPC : public ACharacter
 	GENERATED_BODY()
 
 public:
-	AJGNPC();
+	AJGNPC(const FObjectInitializer& objectInitializer);
 
 	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type endPlayReason) override;
 	void UpdateCastShadow() const;
 
 	virtual void Tick(float deltaSeconds) override;
@@ -46,6 +48,14 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "NPC|Mesh")
 	TArray<FWeightedSkeletalMesh> WeightedMeshes;
 
+	// Furthest AI LOD tier the AI LOD manager may put this NPC in
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "NPC|AI LOD")
+	EJGAILODTier MaxAILODTier;
+
+	// Set by the AI LOD manager
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly, Transient, Category = "NPC|AI LOD")
+	EJGAILODTier AILODTier;
+
 	UFUNCTION(BlueprintCallable, Category = "NPC|Mesh")
 	void ApplyRandomMesh();
 };
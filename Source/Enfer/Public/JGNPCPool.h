@@ -0,0 +1,98 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "JGNPCPool.generated.h"
+
+class AJGNPC;
+
+USTRUCT(BlueprintType)
+struct FJGNPCPoolStats
+{
+	GENERATED_BODY()
+
+	// Acquisitions served by a pooled NPC
+	UPROPERTY(BlueprintReadOnly, Category = "NPC Pool")
+	int32 Hits = 0;
+
+	// Acquisitions that had to spawn a new NPC
+	UPROPERTY(BlueprintReadOnly, Category = "NPC Pool")
+	int32 Misses = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "NPC Pool")
+	int32 PrewarmedCount = 0;
+
+	// NPCs currently handed out
+	UPROPERTY(BlueprintReadOnly, Category = "NPC Pool")
+	int32 ActiveCount = 0;
+
+	// NPCs waiting in the pool
+	UPROPERTY(BlueprintReadOnly, Category = "NPC Pool")
+	int32 FreeCount = 0;
+};
+
+USTRUCT()
+struct FJGNPCPoolBucket
+{
+	GENERATED_BODY()
+
+	UPROPERTY(Transient)
+	TArray<AJGNPC*> FreeNPCs;
+
+	// NPCs of the class are spawned without an AI controller, and acquiring one never restarts a brain
+	bool IsControllerless = false;
+};
+
+/**
+ * Pool of AJGNPC actors per class. Released NPCs are hidden, stop colliding and ticking, and their behavior tree is stopped,
+ * their AI controller stays possessing them. Acquiring one puts it back on the ground, rerolls its mesh and restarts its
+ * behavior tree with a cleared blackboard. NPCs are only spawned when the pool of their class is empty.
+ * Classes driven by something else than their behavior tree (the crowd's promoted actors) can be made controllerless.
+ */
+UCLASS(ClassGroup=(Custom), meta=(BlueprintSpawnableComponent))
+class ENFER_API UJGNPCPool : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	UJGNPCPool();
+
+	// Pooled NPCs wait here, out of sight
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "NPC Pool")
+	FVector ParkingLocation;
+
+	// Spawn the NPCs of the class without possessing them, call before the first Prewarm or Acquire of the class
+	void SetControllerless(TSubclassOf<AJGNPC> npcClass);
+
+	// Spawn NPCs of a class until the pool holds count of them
+	UFUNCTION(BlueprintCallable, Category = "NPC Pool")
+	void Prewarm(TSubclassOf<AJGNPC> npcClass, int32 count);
+
+	// NPC of the class standing at groundLocation, nullptr if it could not be spawned
+	UFUNCTION(BlueprintCallable, Category = "NPC Pool")
+	AJGNPC* Acquire(TSubclassOf<AJGNPC> npcClass, const FVector& groundLocation, const FRotator& rotation);
+
+	UFUNCTION(BlueprintCallable, Category = "NPC Pool")
+	void Release(AJGNPC* npc);
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "NPC Pool")
+	FJGNPCPoolStats GetPoolStats() const { return Stats; }
+
+protected:
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	// Free NPCs by class
+	UPROPERTY(Transient)
+	TMap<UClass*, FJGNPCPoolBucket> Buckets;
+
+	UPROPERTY(Transient)
+	TArray<AJGNPC*> ActiveNPCs;
+
+private:
+	AJGNPC* SpawnNPC(UClass* npcClass, const FTransform& transform);
+	void SetPooled(AJGNPC* npc, bool isPooled);
+
+	FJGNPCPoolStats Stats;
+};
@@ -0,0 +1,70 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "JGNPCSpawner.generated.h"
+
+class AJGChunk;
+class AJGNPC;
+class UJGLevelGenerator;
+class UJGNPCPool;
+struct FJGChunkWindowChange;
+struct FJGChunkWindowEntry;
+
+/**
+ * Places NPCs on the sidewalk of every chunk entering the window, from the NPCSpawnDensity of the chunk's class,
+ * and hands them back to the NPC pool when that chunk leaves the window, wherever they walked to
+ */
+UCLASS(ClassGroup=(Custom), meta=(BlueprintSpawnableComponent))
+class ENFER_API UJGNPCSpawner : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	UJGNPCSpawner();
+
+	// NPC class placed in the chunks (None = no NPC)
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "NPC Spawner")
+	TSubclassOf<AJGNPC> NPCClass;
+
+	// Multiplier of the chunk classes' NPCSpawnDensity
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "NPC Spawner", meta = (ClampMin = "0.0"))
+	float DensityScale;
+
+	// No NPC is placed past this many spawned NPCs
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "NPC Spawner", meta = (ClampMin = "0"))
+	int32 MaxSpawnedNPCs;
+
+	// NPCs constructed in the pool when play starts, so that the first chunks don't spawn any
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "NPC Spawner", meta = (ClampMin = "0"))
+	int32 PrewarmCount;
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "NPC Spawner")
+	int32 GetSpawnedNPCCount() const { return SpawnedNPCCount; }
+
+protected:
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	// Reference to the level generator (automatically found)
+	UPROPERTY(Transient)
+	UJGLevelGenerator* LevelGenerator;
+
+	UPROPERTY(Transient)
+	UJGNPCPool* NPCPool;
+
+private:
+	void OnChunkWindowChanged(const FJGChunkWindowChange& windowChange);
+	void SpawnChunkNPCs(int32 chunkIndex, const AJGChunk* chunk, const AJGChunk* mirrorChunk);
+	void ReleaseChunkNPCs(int32 chunkIndex);
+
+	// Move the NPCs to the chunk they stand in now, INDEX_NONE for the ones outside the window
+	void RebucketNPCs();
+
+	// NPCs by the chunk they were last known to stand in, the pool keeps them alive
+	TMap<int32, TArray<TWeakObjectPtr<AJGNPC>>> ChunkNPCs;
+
+	int32 SpawnedNPCCount;
+};
@@ -0,0 +1,95 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "JGNavBenchmark.generated.h"
+
+class UJGLevelGenerator;
+class UJGNavMeshManager;
+class UJGStreamingGovernor;
+
+/**
+ * Streams a seeded sequence of chunk transitions and measures how long the navmesh takes to be ready after each one.
+ * Only runs with -JGNavBenchmark on the command line, typically with -nullrhi, and writes one CSV row per transition:
+ *   -JGNavBenchmarkSeed=1234 -JGNavBenchmarkTransitions=50 -JGNavBenchmarkBuffers=1,2,3 -JGNavBenchmarkOut=Path.csv
+ * The coverage mode is fixed for a session, compare the modes with one run per -ExecCmds="jg.Nav.CoverageMode 0/1"
+ */
+UCLASS(ClassGroup=(Custom), meta=(BlueprintSpawnableComponent))
+class ENFER_API UJGNavBenchmark : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	UJGNavBenchmark();
+
+	virtual void TickComponent(float deltaTime, ELevelTick tickType, FActorComponentTickFunction* thisTickFunction) override;
+
+	// Seconds to wait after play starts, and after each buffer size change, before the first transition
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Benchmark", meta = (ClampMin = "0.0"))
+	float SettleTime;
+
+	// A transition whose navmesh is not ready after this many seconds is recorded as timed out
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Benchmark", meta = (ClampMin = "1.0"))
+	float NavReadyTimeout;
+
+	// Chance that a transition goes back one chunk instead of forward
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Benchmark", meta = (ClampMin = "0.0", ClampMax = "1.0"))
+	float BackwardStepChance;
+
+	// Chance that a transition jumps two or three chunks forward
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Benchmark", meta = (ClampMin = "0.0", ClampMax = "1.0"))
+	float JumpStepChance;
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Benchmark")
+	bool IsRunning() const { return IsActive; }
+
+protected:
+	virtual void InitializeComponent() override;
+	virtual void BeginPlay() override;
+
+	UPROPERTY(Transient)
+	UJGLevelGenerator* LevelGenerator;
+
+	UPROPERTY(Transient)
+	UJGNavMeshManager* NavMeshManager;
+
+	UPROPERTY(Transient)
+	UJGStreamingGovernor* StreamingGovernor;
+
+private:
+	void StartBufferSize();
+	void StartTransition();
+	void FinishTransition(bool timedOut);
+	void FinishBenchmark();
+	bool IsNavReady() const;
+	void MovePlayerToChunk(int32 chunkIndex);
+	void WriteRows();
+
+	bool IsActive;
+	int32 Seed;
+	int32 TransitionCount;
+	TArray<int32> BufferSizes;
+	FString OutputPath;
+
+	int32 BufferIndex;
+	int32 TransitionIndex;
+	float SettleRemaining;
+	FRandomStream StepStream;
+
+	// The transition being measured
+	bool IsWaitingForNav;
+	int32 FromChunkIndex;
+	int32 ToChunkIndex;
+	double TransitionStartTime;
+	double NavSubmitTime;
+	int32 StartRequestedTiles;
+	TMap<int32, uint32> StartTileSalts;
+	double ProcessCpuSeconds;
+	double GameThreadSeconds;
+	double RenderThreadSeconds;
+
+	// CSV rows not written yet
+	TArray<FString> PendingRows;
+};
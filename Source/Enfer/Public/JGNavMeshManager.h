@@ -7,8 +7,77 @@
 #include "NavigationSystem.h"
 #include "NavMesh/NavMeshBoundsVolume.h"
 #include "JGLevelGenerator.h"
+#include "JGNavTileGrid.h"
 #include "JGNavMeshManager.generated.h"
 
+class URecastNavMeshDataChunk;
+class UNavigationInvokerComponent;
+
+UENUM(BlueprintType)
+enum class EJGNavCoverageMode : uint8
+{
+	// The nav mesh bounds volume slides over the chunks in ChunkBufferSize
+	BoundsVolume,
+	// The volume covers the whole window and nav is only built around the player and the front/back NPCs.
+	// Needs "Generate Navigation Only Around Navigation Invokers" in the navigation system settings.
+	Invokers
+};
+
+USTRUCT(BlueprintType)
+struct FJGNavCoverageStats
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly, Category = "Navigation")
+	EJGNavCoverageMode Mode = EJGNavCoverageMode::BoundsVolume;
+
+	// Tiles currently in the navmesh
+	UPROPERTY(BlueprintReadOnly, Category = "Navigation")
+	int32 TileCount = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Navigation")
+	float MemoryKB = 0.0f;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Navigation")
+	float PeakMemoryKB = 0.0f;
+
+	// Tiles built or rebuilt during the last sample interval, per second
+	UPROPERTY(BlueprintReadOnly, Category = "Navigation")
+	float TilesBuiltPerSecond = 0.0f;
+
+	// Tiles built or rebuilt since the start, over the sampled time
+	UPROPERTY(BlueprintReadOnly, Category = "Navigation")
+	float AverageTilesBuiltPerSecond = 0.0f;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Navigation")
+	int32 TotalTilesBuilt = 0;
+
+	// Tiles removed by the manager since the start, for despawned chunks or outside the coverage
+	UPROPERTY(BlueprintReadOnly, Category = "Navigation")
+	int32 TotalTilesEvicted = 0;
+
+	// Chunks taken off the nav buffer to stay under NavMemoryBudgetKB
+	UPROPERTY(BlueprintReadOnly, Category = "Navigation")
+	int32 BudgetBufferReduction = 0;
+};
+
+// Nav tile count and memory at one stats sample
+USTRUCT(BlueprintType)
+struct FJGNavMemorySample
+{
+	GENERATED_BODY()
+
+	// Sampled time when it was taken (s)
+	UPROPERTY(BlueprintReadOnly, Category = "Navigation")
+	float Time = 0.0f;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Navigation")
+	int32 TileCount = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Navigation")
+	float MemoryKB = 0.0f;
+};
+
 UCLASS(ClassGroup=(Custom), meta=(BlueprintSpawnableComponent))
 class ENFER_API UJGNavMeshManager : public UActorComponent
 {
@@ -21,7 +90,44 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Navigation", meta = (ClampMin = "1"))
 	int32 ChunkBufferSize = 2;
 
+	// How the nav coverage follows the chunks, jg.Nav.CoverageMode overrides it
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Navigation")
+	EJGNavCoverageMode CoverageMode = EJGNavCoverageMode::BoundsVolume;
+
+	// Distance around each invoker inside which tiles are built
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Navigation|Invokers", meta = (ClampMin = "0"))
+	float InvokerGenerationRadius = 3000.0f;
+
+	// Distance around each invoker beyond which its tiles are removed, should be larger than the generation radius
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Navigation|Invokers", meta = (ClampMin = "0"))
+	float InvokerRemovalRadius = 5000.0f;
+
+	// Seconds between two samples of the navmesh tiles for the coverage stats, 0 disables sampling
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Navigation|Stats", meta = (ClampMin = "0"))
+	float StatsSampleInterval = 1.0f;
+
+	// Seconds the window changes are accumulated before one merged nav update is submitted, 0 submits every change right away
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Navigation|Throttling", meta = (ClampMin = "0"))
+	float NavUpdateCoalesceTime = 0.25f;
+
+	// While the navmesh is still building, changes keep accumulating up to this many seconds
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Navigation|Throttling", meta = (ClampMin = "0"))
+	float MaxNavUpdateDelay = 1.0f;
+
+	// Nav memory the navmesh may use (KB, 0 = no limit). Above it the nav buffer shrinks one chunk at a time, down to one chunk.
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Navigation|Memory", meta = (ClampMin = "0"))
+	int32 NavMemoryBudgetKB = 0;
+
+	// The nav buffer only grows back while nav memory is below this fraction of NavMemoryBudgetKB
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Navigation|Memory", meta = (ClampMin = "0.0", ClampMax = "1.0"))
+	float NavMemoryRecoverFraction = 0.6f;
+
+	// Number of stats samples kept in the nav memory history
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Navigation|Stats", meta = (ClampMin = "0"))
+	int32 NavMemoryHistoryLength = 300;
+
 protected:
+	virtual void InitializeComponent() override;
 	virtual void BeginPlay() override;
 	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 
@@ -44,15 +150,106 @@ protected:
 	// Box extent for nav mesh rebuilding
 	FBox CurrentNavMeshBounds;
 
+	// Nav bounds of the chunks in the level generator's window (the sidewalk band with UseSidewalkNavBounds), by logical index
+	TMap<int32, FBox> ChunkBounds;
+
+	// Tile grid of the navmesh, the bounds volume slides over it one tile at a time
+	FJGNavTileGrid NavTileGrid;
+
+	// Baked nav tiles attached for the chunks in nav range, by logical index
+	UPROPERTY(Transient)
+	TMap<int32, URecastNavMeshDataChunk*> AttachedNavTiles;
+
+	// Tiles requested for rebuild by the last chunk transition, and since the start (the navmesh may build more)
+	int32 LastTransitionTileCount;
+	int32 TotalRebuiltTileCount;
+
+	// CoverageMode after the console override, fixed for the session
+	EJGNavCoverageMode ActiveCoverageMode;
+
+	// Invokers this manager added to the player and the NPCs
+	UPROPERTY(Transient)
+	TArray<UNavigationInvokerComponent*> AddedInvokers;
+
+	// Salt of each navmesh tile at the last sample, by tile index. A tile is new or rebuilt when its salt changes.
+	TMap<int32, uint32> SampledTileSalts;
+
+	FJGNavCoverageStats CoverageStats;
+	float SampledTime;
+	float TimeSinceStatsSample;
+
+	// Window changes waiting for the next merged nav update
+	bool HasPendingNavUpdate;
+	int32 PendingCenterChunkIndex;
+	float PendingNavUpdateAge;
+	int32 PendingWindowChangeCount;
+
+	// Chunks added and removed since the last nav update, a chunk added then removed before it is cancels out
+	TMap<int32, FJGChunkWindowEntry> PendingAddedChunks;
+	TMap<int32, FBox> PendingRemovedChunks;
+
+	// Merged nav updates submitted, and skipped because the coverage had not changed
+	int32 SubmittedNavUpdateCount;
+	int32 SkippedNavUpdateCount;
+
+	// Chunks taken off the buffer by the memory budget
+	int32 BudgetBufferReduction;
+	bool HasWarnedOverBudget;
+
+	// Tile count and memory at each stats sample, oldest first
+	TArray<FJGNavMemorySample> NavMemoryHistory;
+
 public:
-	// Called when player enters a new chunk
-	UFUNCTION()
-	void OnPlayerEnteredChunk(int32 newChunkIndex, int32 previousChunkIndex);
+	virtual void TickComponent(float deltaTime, ELevelTick tickType, FActorComponentTickFunction* thisTickFunction) override;
+
+	// Called when the level generator's window changes
+	void OnChunkWindowChanged(const FJGChunkWindowChange& windowChange);
 
 	// Manually update nav mesh for specific chunk range
 	UFUNCTION(BlueprintCallable, Category = "Navigation")
 	void UpdateNavMeshForChunkRange(int32 centerChunkIndex, int32 bufferSize);
 
+	// ChunkBufferSize clamped to the chunks the level generator keeps resident
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Navigation")
+	int32 GetEffectiveBufferSize() const;
+
+	// Number of nav tiles the last chunk transition asked to rebuild, the navmesh may rebuild more
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Navigation")
+	int32 GetLastTransitionTileCount() const { return LastTransitionTileCount; }
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Navigation")
+	int32 GetTotalRebuiltTileCount() const { return TotalRebuiltTileCount; }
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Navigation")
+	int32 GetSubmittedNavUpdateCount() const { return SubmittedNavUpdateCount; }
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Navigation")
+	int32 GetSkippedNavUpdateCount() const { return SkippedNavUpdateCount; }
+
+	// Tile count and nav memory at the last NavMemoryHistoryLength stats samples, oldest first
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Navigation")
+	const TArray<FJGNavMemorySample>& GetNavMemoryHistory() const { return NavMemoryHistory; }
+
+	// True while window changes are waiting for the next merged nav update
+	bool IsNavUpdatePending() const { return HasPendingNavUpdate; }
+
+	// Tiles in the navmesh and the memory they use, counted now
+	void GetNavMeshTileStats(int32& outTileCount, int64& outMemory) const;
+
+	// Salt of each tile in the navmesh by tile index, a tile that was rebuilt since an earlier call has a new salt
+	void GetNavMeshTileSalts(TMap<int32, uint32>& outTileSalts) const;
+
+	// Submit the accumulated window changes now
+	UFUNCTION(BlueprintCallable, Category = "Navigation")
+	void FlushPendingNavUpdate();
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Navigation")
+	EJGNavCoverageMode GetCoverageMode() const { return ActiveCoverageMode; }
+
+	// Tile count, nav memory and tile build rate, sampled every StatsSampleInterval
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Navigation")
+	FJGNavCoverageStats GetCoverageStats() const { return CoverageStats; }
+
 	// Get the current nav mesh bounds
 	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Navigation")
 	FBox GetCurrentNavMeshBounds() const { return CurrentNavMeshBounds; }
@@ -67,6 +264,54 @@ private:
 	// Calculate nav mesh bounds for given chunk range
 	FBox CalculateNavMeshBounds(int32 centerChunkIndex, int32 bufferSize);
 
-	// Update the nav mesh bounds volume and trigger rebuild
-	void UpdateNavMeshBounds(const FBox& newBounds);
+	// Slide the nav mesh bounds volume, the tiles entering it are requested and the tiles leaving it are dropped.
+	// Returns false if the volume did not move.
+	bool UpdateNavMeshBounds(const FBox& newBounds, TSet<FIntPoint>& rebuiltTiles);
+
+	// Remove the tiles that left the volume (tile grid coordinates), with their queued and running builds
+	void CancelTileBuilds(const TArray<FIntPoint>& tiles);
+
+	bool ShouldFlushPendingNavUpdate() const;
+
+	// Tick every frame while an update is pending, at the stats interval otherwise
+	void UpdateTickInterval();
+
+	// Dirty the part of a chunk inside the nav mesh bounds
+	void DirtyChunkArea(const FBox& chunkBounds, TSet<FIntPoint>& rebuiltTiles);
+
+	void AddTiles(const FBox& bounds, TSet<FIntPoint>& tiles) const;
+
+	// Attach the baked tiles of the chunks entering the nav range and detach the ones of chunks leaving it
+	void UpdateBakedNavTiles();
+
+	bool AttachChunkNavTiles(AJGChunk* chunk, int32 chunkIndex);
+	void DetachChunkNavTiles(URecastNavMeshDataChunk* navTiles);
+
+	void ReportRebuiltTiles(const TSet<FIntPoint>& rebuiltTiles, int32 centerChunkIndex);
+
+	// Chunks on either side of the center covered by the bounds volume in the active coverage mode
+	int32 GetCoverageBufferSize() const;
+
+	// Give the player and the front/back NPCs an invoker if they don't have one yet
+	void UpdateInvokers();
+
+	void SampleCoverageStats(float elapsedTime);
+
+	// Seconds between two stats samples, the memory budget needs them even with StatsSampleInterval at 0
+	float GetSampleInterval() const;
+
+	// Remove the generated tiles of a despawned chunk that no resident chunk overlaps. Returns the number of tiles kept.
+	int32 EvictChunkNavTiles(const FBox& navBounds);
+
+	// Remove the navmesh tiles entirely outside the nav mesh bounds
+	void EvictTilesOutsideCoverage();
+
+	// Remove navmesh tiles at Recast tile coordinates, with their queued and running builds
+	void RemoveNavTiles(const TArray<FIntPoint>& recastTiles);
+
+	// Shrink or grow the nav buffer back from the sampled nav memory
+	void ApplyNavMemoryBudget();
+
+	// Submit a nav update for the current center on the next tick, after a change of the coverage itself
+	void RequestCoverageUpdate();
 };
\ No newline at end of file
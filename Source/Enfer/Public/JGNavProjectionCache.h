@@ -0,0 +1,146 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "JGNavProjectionCache.generated.h"
+
+class ANavigationData;
+class UJGLevelGenerator;
+struct FJGChunkWindowChange;
+
+USTRUCT(BlueprintType)
+struct FJGNavProjectionCacheStats
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly, Category = "Navigation")
+	int32 Hits = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Navigation")
+	int32 Misses = 0;
+
+	// Queries outside the active chunks or in chunks whose tiles are being rebuilt, not cached
+	UPROPERTY(BlueprintReadOnly, Category = "Navigation")
+	int32 Bypasses = 0;
+
+	// Chunks whose entries were dropped, because they despawned or their tiles were rebuilt
+	UPROPERTY(BlueprintReadOnly, Category = "Navigation")
+	int32 InvalidatedChunks = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Navigation")
+	int32 Entries = 0;
+
+	float GetHitRate() const { return Hits + Misses > 0 ? (float)Hits / (Hits + Misses) : 0.0f; }
+};
+
+struct FJGNavProjectionKey
+{
+	FIntVector Cell;
+	int32 Extent;
+
+	bool operator==(const FJGNavProjectionKey& other) const { return Cell == other.Cell && Extent == other.Extent; }
+	friend uint32 GetTypeHash(const FJGNavProjectionKey& key) { return HashCombine(GetTypeHash(key.Cell), GetTypeHash(key.Extent)); }
+};
+
+struct FJGNavProjectionResult
+{
+	FVector Location;
+	bool Success;
+};
+
+/**
+ * Cached projections by chunk logical index, and the chunks that are not cached while their tiles are rebuilt.
+ * Knows nothing of the world, the cache maps points to chunks.
+ */
+class ENFER_API FJGNavProjectionEntries
+{
+public:
+	// Quantize a query to cellSize, false if the cell size disables the cache
+	static bool MakeKey(const FVector& point, const FVector& queryExtent, float cellSize, FJGNavProjectionKey& outKey);
+
+	const FJGNavProjectionResult* Find(int32 chunkIndex, const FJGNavProjectionKey& key) const;
+	void Store(int32 chunkIndex, const FJGNavProjectionKey& key, bool success, const FVector& location);
+
+	// Drop the entries of the chunk, true if it had some
+	bool InvalidateChunk(int32 chunkIndex);
+
+	// Drop the entries of the chunk and stop caching it until the generation finished, true if it had some
+	bool MarkRebuilding(int32 chunkIndex);
+	bool IsRebuilding(int32 chunkIndex) const { return RebuildingChunks.Contains(chunkIndex); }
+
+	// The chunk despawned, true if it had entries
+	bool RemoveChunk(int32 chunkIndex);
+
+	// Drop the failed results and the entries of the rebuilt chunks, returns the number of chunks invalidated
+	int32 OnGenerationFinished();
+
+	int32 Num() const;
+	void Reset();
+
+private:
+	TMap<int32, TMap<FJGNavProjectionKey, FJGNavProjectionResult>> ChunkEntries;
+
+	// Chunks waiting for the navmesh to finish building
+	TSet<int32> RebuildingChunks;
+};
+
+/**
+ * Navmesh point projections shared by the JG AI nodes, keyed by chunk and quantized position.
+ * Entries of a chunk are dropped when it despawns or the nav mesh manager rebuilds its tiles.
+ */
+UCLASS()
+class ENFER_API UJGNavProjectionCache : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void OnWorldBeginPlay(UWorld& world) override;
+	virtual void Deinitialize() override;
+
+	// ProjectPointToNavigation through the world's cache, or straight to the navigation system when there is none
+	static bool ProjectPoint(const UWorld* world, const FVector& point, const FVector& queryExtent, FVector& outLocation);
+
+	bool ProjectPoint(const FVector& point, const FVector& queryExtent, FVector& outLocation);
+
+	// Look a projection up without querying the navmesh, false on a miss or if the point cannot be cached
+	bool FindProjection(const FVector& point, const FVector& queryExtent, bool& outSuccess, FVector& outLocation);
+
+	// Store a projection made outside the cache (asynchronous queries)
+	void StoreProjection(const FVector& point, const FVector& queryExtent, bool success, const FVector& location);
+
+	// Drop the entries of the chunks overlapping area and stop caching them until the navmesh finished building
+	void MarkAreaRebuilding(const FBox& area);
+
+	// Drop the entries of the chunks overlapping area, for nav changes that are immediate (attached tiles)
+	void InvalidateArea(const FBox& area);
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Navigation")
+	FJGNavProjectionCacheStats GetStats() const;
+
+	void LogStats() const;
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type worldType) const override;
+
+private:
+	FJGNavProjectionEntries Projections;
+
+	TWeakObjectPtr<UJGLevelGenerator> LevelGenerator;
+
+	FJGNavProjectionCacheStats Stats;
+
+	void OnChunkWindowChanged(const FJGChunkWindowChange& windowChange);
+
+	UFUNCTION()
+	void OnNavigationGenerationFinished(ANavigationData* navData);
+
+	void InvalidateChunk(int32 chunkIndex);
+
+	// False if the point is outside the active chunks, in a chunk being rebuilt, or the cache is disabled
+	bool GetProjectionKey(const FVector& point, const FVector& queryExtent, int32& outChunkIndex, FJGNavProjectionKey& outKey) const;
+
+	// Logical indices of the active chunks overlapping area on X
+	void GetChunksInArea(const FBox& area, TArray<int32>& outChunkIndices) const;
+};
\ No newline at end of file
@@ -0,0 +1,92 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "AI/Navigation/NavigationTypes.h"
+#include "JGNavQueryService.generated.h"
+
+struct FJGNavProjectionResult
+{
+	FVector Location = FVector::ZeroVector;
+	bool Success = false;
+};
+
+// Results in the order of the requested points
+DECLARE_DELEGATE_OneParam(FJGNavProjectionsDelegate, TConstArrayView<FJGNavProjectionResult>);
+DECLARE_DELEGATE_TwoParams(FJGNavPathDelegate, bool, FNavPathSharedPtr);
+
+// Node memory of the tasks waiting on the query service
+struct FJGNavQueryTaskMemory
+{
+	uint32 RequestId = 0;
+};
+
+/**
+ * Navigation queries of the AI nodes, run in batches once per frame instead of inside behavior tree execution.
+ * Projections run on worker threads while the game thread waits, so the navmesh (only modified on the game thread)
+ * cannot change under them. Paths go through the navigation system's asynchronous path finding.
+ */
+UCLASS()
+class ENFER_API UJGNavQueryService : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+	virtual void Tick(float deltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	// Project points on the navmesh in a later frame, onCompleted is not called if the request is cancelled
+	uint32 RequestProjections(TConstArrayView<FVector> points, const FVector& queryExtent, FJGNavProjectionsDelegate onCompleted);
+
+	uint32 RequestPath(const FVector& start, const FVector& end, const FNavAgentProperties& agentProperties, FJGNavPathDelegate onCompleted);
+
+	void CancelRequest(uint32 requestId);
+
+	// Navmesh queries run during the last frame, cache hits excluded
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Navigation")
+	int32 GetQueriesLastFrame() const { return QueriesLastFrame; }
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Navigation")
+	int32 GetPendingRequestCount() const { return PendingProjections.Num() + PendingPaths.Num(); }
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type worldType) const override;
+
+private:
+	struct FProjectionRequest
+	{
+		uint32 Id = 0;
+		TArray<FVector> Points;
+		FVector QueryExtent = FVector::ZeroVector;
+		FJGNavProjectionsDelegate OnCompleted;
+	};
+
+	struct FPathRequest
+	{
+		uint32 Id = 0;
+		FVector Start = FVector::ZeroVector;
+		FVector End = FVector::ZeroVector;
+		FNavAgentProperties AgentProperties;
+		FJGNavPathDelegate OnCompleted;
+	};
+
+	TArray<FProjectionRequest> PendingProjections;
+	TArray<FPathRequest> PendingPaths;
+
+	// Path requests handed to the navigation system, by its query id
+	TMap<uint32, FPathRequest> RunningPaths;
+
+	// Requests cancelled by a callback of the batch being delivered
+	TSet<uint32> CancelledDuringDelivery;
+	bool IsDelivering = false;
+
+	uint32 NextRequestId = 1;
+	int32 QueriesLastFrame = 0;
+
+	void RunProjections(int32& queryBudget);
+	void StartPaths(int32& queryBudget);
+	void OnPathFound(uint32 queryId, ENavigationQueryResult::Type result, FNavPathSharedPtr path);
+};
\ No newline at end of file
@@ -0,0 +1,99 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class ARecastNavMesh;
+class UWorld;
+
+/**
+ * Tile grid of the world's Recast navmesh on the XY plane, used to line chunk boundaries up with nav tiles.
+ * Tiles are counted along the world axes from Origin, which is not how Recast numbers them: convert them with
+ * GetRecastTile before handing them to the navmesh or its generator.
+ */
+struct ENFER_API FJGNavTileGrid
+{
+	// Size of a nav tile in world units (0 if there is no Recast navmesh)
+	float TileSize = 0.0f;
+
+	// World position of a tile corner
+	FVector2D Origin = FVector2D::ZeroVector;
+
+	// Read the tile size and origin from the default Recast navmesh of the world
+	static FJGNavTileGrid FromWorld(const UWorld* world);
+
+	bool IsValid() const { return TileSize > 0.0f; }
+
+	// Closest tile boundary at or above value on the X axis
+	float SnapUpX(float value) const
+	{
+		return IsValid() ? Origin.X + FMath::CeilToFloat((value - Origin.X) / TileSize - KINDA_SMALL_NUMBER) * TileSize : value;
+	}
+
+	// Closest tile boundary at or below value on the X axis
+	float SnapDownX(float value) const
+	{
+		return IsValid() ? Origin.X + FMath::FloorToFloat((value - Origin.X) / TileSize + KINDA_SMALL_NUMBER) * TileSize : value;
+	}
+
+	// Space left between a length and the next whole number of tiles
+	float GetPadding(float length) const
+	{
+		return IsValid() ? FMath::CeilToFloat(length / TileSize - KINDA_SMALL_NUMBER) * TileSize - length : 0.0f;
+	}
+
+	// Tile coordinates of a world location
+	FIntPoint GetTileCoord(const FVector& location) const
+	{
+		return FIntPoint(
+			FMath::FloorToInt((location.X - Origin.X) / TileSize),
+			FMath::FloorToInt((location.Y - Origin.Y) / TileSize));
+	}
+
+	// World location of the center of a tile, at Z = 0
+	FVector GetTileCenter(const FIntPoint& tile) const
+	{
+		return FVector(Origin.X + (tile.X + 0.5f) * TileSize, Origin.Y + (tile.Y + 0.5f) * TileSize, 0.0f);
+	}
+
+	// Recast's coordinates of a tile (Recast works in its own flipped space), false without a Recast navmesh
+	bool GetRecastTile(const ARecastNavMesh* navMesh, const FIntPoint& tile, FIntPoint& outRecastTile) const;
+
+	// Recast's coordinates of the tiles of an inclusive range
+	void GetRecastTiles(const ARecastNavMesh* navMesh, const FIntRect& range, TArray<FIntPoint>& outRecastTiles) const;
+
+	// Inclusive range of tiles overlapped by a box
+	FIntRect GetTileRange(const FBox& bounds) const
+	{
+		const FIntPoint minTile = GetTileCoord(bounds.Min);
+		const FIntPoint maxTile = GetTileCoord(bounds.Max - FVector(KINDA_SMALL_NUMBER));
+		return FIntRect(minTile, maxTile);
+	}
+
+	// Box grown on X and Y to the boundaries of the tiles it overlaps
+	FBox SnapToTiles(const FBox& bounds) const
+	{
+		if (!IsValid() || !bounds.IsValid)
+		{
+			return bounds;
+		}
+
+		const FIntRect range = GetTileRange(bounds);
+		return FBox(
+			FVector(Origin.X + range.Min.X * TileSize, Origin.Y + range.Min.Y * TileSize, bounds.Min.Z),
+			FVector(Origin.X + (range.Max.X + 1) * TileSize, Origin.Y + (range.Max.Y + 1) * TileSize, bounds.Max.Z));
+	}
+
+	// Number of tiles overlapped by a box
+	int32 CountTiles(const FBox& bounds) const
+	{
+		if (!IsValid() || !bounds.IsValid)
+		{
+			return 0;
+		}
+
+		const FIntRect range = GetTileRange(bounds);
+		return (range.Max.X - range.Min.X + 1) * (range.Max.Y - range.Min.Y + 1);
+	}
+};
@@ -0,0 +1,97 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "JGPlayerContextSubsystem.generated.h"
+
+// Kinematic state of one player's pawn, captured once per frame
+USTRUCT(BlueprintType)
+struct FJGPlayerContext
+{
+	GENERATED_BODY()
+
+	// Index of the player controller, as in GetPlayerPawn
+	UPROPERTY(BlueprintReadOnly, Category = "Player Context")
+	int32 PlayerIndex = 0;
+
+	// False while the player has no pawn, the rest is then left from the last frame it had one
+	UPROPERTY(BlueprintReadOnly, Category = "Player Context")
+	bool HasPawn = false;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Player Context")
+	FVector Location = FVector::ZeroVector;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Player Context")
+	FVector Velocity = FVector::ZeroVector;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Player Context")
+	FVector Forward = FVector::ForwardVector;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Player Context")
+	FVector2D Location2D = FVector2D::ZeroVector;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Player Context")
+	FVector2D Velocity2D = FVector2D::ZeroVector;
+
+	// Normalized, zero if the pawn faces straight up or down
+	UPROPERTY(BlueprintReadOnly, Category = "Player Context")
+	FVector2D Forward2D = FVector2D::ZeroVector;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Player Context")
+	float Speed2D = 0.0f;
+
+	TWeakObjectPtr<APawn> Pawn;
+};
+
+/**
+ * Location, velocity and facing of every player's pawn, read from the pawns once per frame and shared by the AI nodes
+ * and the NPCs instead of each of them fetching the player. The first read of a frame captures it, so readers always
+ * see the current frame. A short history of the pawn locations is kept for trajectory queries (jg.PlayerContext.HistorySeconds).
+ * Returned contexts are only valid until the next frame.
+ */
+UCLASS()
+class ENFER_API UJGPlayerContextSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Tick(float deltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	// Context of the player with a pawn closest to location, nullptr if no player has a pawn
+	static const FJGPlayerContext* FindClosest(const UWorld* world, const FVector& location);
+
+	// Context of a player, nullptr if it does not exist or has no pawn
+	static const FJGPlayerContext* Find(const UWorld* world, int32 playerIndex = 0);
+
+	const TArray<FJGPlayerContext>& GetPlayers();
+
+	UFUNCTION(BlueprintCallable, Category = "Player Context")
+	FJGPlayerContext GetPlayerContext(int32 playerIndex);
+
+	// Pawn location secondsAgo, interpolated from the history. False if the history does not reach that far back.
+	UFUNCTION(BlueprintCallable, Category = "Player Context")
+	bool GetPastLocation(int32 playerIndex, float secondsAgo, FVector& outLocation);
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type worldType) const override;
+
+private:
+	struct FLocationSample
+	{
+		double Time = 0.0;
+		FVector Location = FVector::ZeroVector;
+	};
+
+	void CaptureIfStale();
+
+	TArray<FJGPlayerContext> Players;
+
+	// Pawn locations of each player over the last jg.PlayerContext.HistorySeconds, oldest first
+	TArray<TArray<FLocationSample>> LocationHistories;
+
+	uint64 CapturedFrame = 0;
+	double CapturedTime = 0.0;
+};
@@ -29,5 +29,8 @@ protected:
 
 	virtual void TickNode(UBehaviorTreeComponent& ownerComp, uint8* nodeMemory, float deltaSeconds) override;
 
+	// Stretches Interval for NPCs at the reduced AI LOD tier
+	virtual void ScheduleNextTick(UBehaviorTreeComponent& ownerComp, uint8* nodeMemory) override;
+
 	virtual void OnSearchStart(FBehaviorTreeSearchData& searchData) override;
 };
\ No newline at end of file
@@ -30,4 +30,7 @@ protected:
 	float NormalWalkSpeed;
 
 	virtual void TickNode(UBehaviorTreeComponent& ownerComp, uint8* nodeMemory, float deltaSeconds) override;
+
+	// Stretches Interval for NPCs at the reduced AI LOD tier
+	virtual void ScheduleNextTick(UBehaviorTreeComponent& ownerComp, uint8* nodeMemory) override;
 };
\ No newline at end of file
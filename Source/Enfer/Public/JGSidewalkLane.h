@@ -0,0 +1,63 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class UWorld;
+
+// Stretch of sidewalk that can be walked end to end
+struct FJGLaneInterval
+{
+	float MinX = 0.0f;
+	float MaxX = 0.0f;
+
+	// Lateral bounds of the walkable band
+	float MinY = 0.0f;
+	float MaxY = 0.0f;
+
+	float GroundZ = 0.0f;
+
+	// Logical index of the chunk the interval belongs to
+	int32 ChunkIndex = INDEX_NONE;
+};
+
+/**
+ * One dimensional view of the sidewalk: the walkable X intervals of the active chunks, sorted and non overlapping.
+ * AI only ever looks for a point along +/-X on the sidewalk, which this answers without a navmesh query.
+ */
+class ENFER_API FJGSidewalkLane
+{
+public:
+	// Replace the intervals of a chunk
+	void SetChunkIntervals(int32 chunkIndex, TConstArrayView<FJGLaneInterval> chunkIntervals);
+
+	void RemoveChunk(int32 chunkIndex);
+
+	void Reset() { Intervals.Reset(); }
+
+	bool IsEmpty() const { return Intervals.Num() == 0; }
+
+	const TArray<FJGLaneInterval>& GetIntervals() const { return Intervals; }
+
+	// Closest walkable point to location, on the ground. Fails if it is more than maxDistanceX away along the lane.
+	bool FindNearestWalkablePoint(const FVector& location, FVector& outLocation, float maxDistanceX = UE_BIG_NUMBER) const;
+
+	// Random point on the ground of a chunk's intervals, uniform over their area. Fails if the chunk has none.
+	bool FindRandomPointInChunk(int32 chunkIndex, FVector& outLocation) const;
+
+	// Walkable intervals of [minX, maxX] on the band [minY, maxY] around obstacle footprints, grown beforehand by the agents' radius.
+	// Each stretch between obstacle ends keeps one free part of the band, preferably the one continuing the previous stretch,
+	// otherwise the widest. Stretches whose free parts are all narrower than minBandWidth cut the lane.
+	static void ComputeIntervals(float minX, float maxX, float minY, float maxY, float groundZ, TConstArrayView<FBox2D> obstacles,
+		float minBandWidth, TArray<FJGLaneInterval>& outIntervals);
+
+	// Lane of the level generator of the world's game mode, nullptr if there is none or it has no chunk yet
+	static const FJGSidewalkLane* Get(const UWorld* world);
+
+	// Shortcut for the AI nodes: nearest walkable point on the world's lane
+	static bool ProjectPoint(const UWorld* world, const FVector& location, FVector& outLocation, float maxDistanceX = UE_BIG_NUMBER);
+
+private:
+	TArray<FJGLaneInterval> Intervals;
+};
\ No newline at end of file
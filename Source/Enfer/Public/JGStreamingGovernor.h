@@ -0,0 +1,97 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "JGStreamingGovernor.generated.h"
+
+class UJGLevelGenerator;
+
+/**
+ * Grows or shrinks the level generator's chunk window from game thread time, async loading queue depth and memory use.
+ * Pressure has to be sustained before the window changes by one chunk, and grow thresholds sit below shrink thresholds
+ * so that the window does not oscillate around a single value
+ */
+UCLASS(ClassGroup=(Custom), meta=(BlueprintSpawnableComponent))
+class ENFER_API UJGStreamingGovernor : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	UJGStreamingGovernor();
+
+	virtual void TickComponent(float deltaTime, ELevelTick tickType, FActorComponentTickFunction* thisTickFunction) override;
+
+	// Smallest number of chunks kept on either side of the player
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Streaming", meta = (ClampMin = "1"))
+	int32 MinChunksOnEitherSide;
+
+	// Largest number of chunks kept on either side of the player, never below the level generator's NumChunksOnEitherSide
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Streaming", meta = (ClampMin = "1", EditCondition = "!CapAtAuthoredWindow"))
+	int32 MaxChunksOnEitherSide;
+
+	// If true, the window never grows past the level generator's NumChunksOnEitherSide, the governor only shrinks it under pressure
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Streaming")
+	bool CapAtAuthoredWindow;
+
+	// The window only grows while the smoothed game thread time is below this (ms)
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Streaming|Thresholds", meta = (ClampMin = "0.0"))
+	float GrowGameThreadMs;
+
+	// The window shrinks while the smoothed game thread time is above this (ms)
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Streaming|Thresholds", meta = (ClampMin = "0.0"))
+	float ShrinkGameThreadMs;
+
+	// The window only grows while at most this many packages are being loaded asynchronously
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Streaming|Thresholds", meta = (ClampMin = "0"))
+	int32 GrowMaxAsyncPackages;
+
+	// The window shrinks while more than this many packages are being loaded asynchronously
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Streaming|Thresholds", meta = (ClampMin = "0"))
+	int32 ShrinkAsyncPackages;
+
+	// The window shrinks while the process uses more physical memory than this (MB, 0 = ignore memory)
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Streaming|Thresholds", meta = (ClampMin = "0"))
+	int32 MemoryBudgetMB;
+
+	// The window only grows while memory use is below this fraction of MemoryBudgetMB
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Streaming|Thresholds", meta = (ClampMin = "0.0", ClampMax = "1.0"))
+	float GrowMemoryFraction;
+
+	// Weight of the latest frame in the smoothed game thread time
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Streaming", meta = (ClampMin = "0.01", ClampMax = "1.0"))
+	float GameThreadSmoothing;
+
+	// How long the grow conditions have to hold before the window grows (s)
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Streaming", meta = (ClampMin = "0.0"))
+	float GrowSustainTime;
+
+	// How long the shrink conditions have to hold before the window shrinks (s)
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Streaming", meta = (ClampMin = "0.0"))
+	float ShrinkSustainTime;
+
+	// Time after a window change during which the governor does not change it again (s), spawning chunks is a spike of its own
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Streaming", meta = (ClampMin = "0.0"))
+	float ChangeCooldown;
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Streaming")
+	float GetSmoothedGameThreadMs() const { return SmoothedGameThreadMs; }
+
+protected:
+	virtual void BeginPlay() override;
+
+	// Reference to the level generator (automatically found)
+	UPROPERTY(Transient)
+	UJGLevelGenerator* LevelGenerator;
+
+private:
+	void ChangeWindow(int32 numChunks);
+
+	int32 GetMaxChunksOnEitherSide() const;
+
+	float SmoothedGameThreadMs;
+	float GrowPressureTime;
+	float ShrinkPressureTime;
+	float CooldownRemaining;
+};
@@ -6,6 +6,8 @@
 #include "BehaviorTree/BTTaskNode.h"
 #include "BehaviorTree/BlackboardComponent.h"
 #include "NavigationSystem.h"
+class UCharacterMovementComponent;
+
 #include "JGTaskNode_FindCutOffLocation.generated.h"
 
 /**
@@ -21,6 +23,8 @@ public:
 	UJGTaskNode_FindCutOffLocation();
 
 	virtual EBTNodeResult::Type ExecuteTask(UBehaviorTreeComponent& ownerComp, uint8* nodeMemory) override;
+	virtual EBTNodeResult::Type AbortTask(UBehaviorTreeComponent& ownerComp, uint8* nodeMemory) override;
+	virtual uint16 GetInstanceMemorySize() const override;
 	virtual FString GetStaticDescription() const override;
 
 protected:
@@ -44,18 +48,30 @@ protected:
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Cutoff", meta = (ClampMin = "0.0"))
 	float MaxSpeedBonus;
 
+	// If true, the navmesh projections go through the nav query service in one batch and the task finishes when it is done
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Cutoff")
+	bool UseAsyncQueries;
+
 private:
 	// Cached normal walk speed for temporary boost calculations
 	UPROPERTY(Transient)
 	float CachedNormalWalkSpeed;
 
-	// Compute a cutoff location ahead of the player, aligned with the movement direction, and project to navmesh
-	bool FindCutoffLocation(UNavigationSystemV1* navSystem,
-		const FVector& npcLocation,
+	// Points to project in order of preference: ahead of the player, stepping back and forth around it, then ahead of the NPC
+	void GetCutoffCandidates(const FVector& npcLocation,
 		const FVector& direction,
 		const FVector& playerLocation,
 		const FVector& playerVelocity,
 		float aheadDistance,
 		float maxSearchRadius,
-		FVector& outLocation) const;
+		TArray<FVector, TInlineAllocator<18>>& outCandidates) const;
+
+	// Cutoff location from the sidewalk lane, false if the lane has no chunk yet
+	bool FindLaneCutoffLocation(UWorld* world, TConstArrayView<FVector> candidates, float maxSearchRadius, FVector& outLocation) const;
+
+	// First candidate that projects to the navmesh
+	bool FindCutoffLocation(UWorld* world, TConstArrayView<FVector> candidates, float maxSearchRadius, FVector& outLocation) const;
+
+	// Boost the speed and store the target
+	void ApplyCutoffLocation(UBehaviorTreeComponent& ownerComp, UCharacterMovementComponent* moveComp, const FVector& targetLocation) const;
 };
@@ -14,6 +14,8 @@ public:
 	UJGTaskNode_SetTargetAlongDirection();
 
 	virtual EBTNodeResult::Type ExecuteTask(UBehaviorTreeComponent& ownerComp, uint8* nodeMemory) override;
+	virtual EBTNodeResult::Type AbortTask(UBehaviorTreeComponent& ownerComp, uint8* nodeMemory) override;
+	virtual uint16 GetInstanceMemorySize() const override;
 	virtual FString GetStaticDescription() const override;
 
 protected:
@@ -36,6 +38,14 @@ protected:
 	// Optional: reset NPC's normal walking speed when setting the target
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Movement", meta = (ClampMin = "0.0"))
 	float NormalWalkSpeed;
+
+	// If true, the navmesh projection goes through the nav query service and the task finishes when it is done
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Movement")
+	bool UseAsyncQueries;
+
+private:
+	// Store the target and reset the walking speed
+	void ApplyTarget(UBehaviorTreeComponent& ownerComp, APawn* npc, const FVector& out) const;
 };
 
 
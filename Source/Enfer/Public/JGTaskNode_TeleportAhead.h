@@ -14,6 +14,8 @@ public:
 	UJGTaskNode_TeleportAhead();
 
 	virtual EBTNodeResult::Type ExecuteTask(UBehaviorTreeComponent& ownerComp, uint8* nodeMemory) override;
+	virtual EBTNodeResult::Type AbortTask(UBehaviorTreeComponent& ownerComp, uint8* nodeMemory) override;
+	virtual uint16 GetInstanceMemorySize() const override;
 	virtual FString GetStaticDescription() const override;
 
 protected:
@@ -32,6 +34,14 @@ protected:
 	// Radius for navmesh projection when enabled
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Teleport", meta = (ClampMin = "0.0"))
 	float MaxSearchRadius;
+
+	// If true, the navmesh projection goes through the nav query service and the task finishes when it is done
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Teleport")
+	bool UseAsyncQueries;
+
+private:
+	// Teleport the NPC standing on target3D
+	void TeleportNpc(APawn* npc, FVector target3D) const;
 };
 
 
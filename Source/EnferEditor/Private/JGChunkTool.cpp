@@ -18,6 +18,7 @@ void UJGChunkTool::SetupChunk()
 	SetupWallBoxCollisionOnSelected();
 	SetupTriggerBoxOnSelected();
 	SetupFloorOnSelected();
+	SetupVisibilitySetsOnSelected();
 }
 
 void UJGChunkTool::ProcessSelectedChunkBlueprints(TFunction<void(AJGChunk*)> setupFunction, const FString& operationName)
@@ -94,4 +95,20 @@ void UJGChunkTool::SetupTriggerBoxOnSelected()
 	{
 		chunk->SetupTriggerBox();
 	}, TEXT("SetupTriggerBox"));
+}
+
+void UJGChunkTool::SetupVisibilitySetsOnSelected()
+{
+	ProcessSelectedChunkBlueprints([](AJGChunk* chunk)
+	{
+		chunk->SetupVisibilitySets();
+	}, TEXT("SetupVisibilitySets"));
+}
+
+void UJGChunkTool::SetupNavTilesOnSelected()
+{
+	ProcessSelectedChunkBlueprints([](AJGChunk* chunk)
+	{
+		chunk->SetupNavTiles();
+	}, TEXT("SetupNavTiles"));
 }
\ No newline at end of file
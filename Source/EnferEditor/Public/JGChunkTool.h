@@ -30,6 +30,13 @@ public:
 	UFUNCTION(CallInEditor, Category = "Chunk Tool")
 	void SetupTriggerBoxOnSelected();
 
+	UFUNCTION(CallInEditor, Category = "Chunk Tool")
+	void SetupVisibilitySetsOnSelected();
+
+	// Needs a level with a Recast navmesh and a NavMeshBoundsVolume open, with the game's navmesh settings
+	UFUNCTION(CallInEditor, Category = "Chunk Tool")
+	void SetupNavTilesOnSelected();
+
 private:
 	// Helper method to process selected chunk blueprints
 	static void ProcessSelectedChunkBlueprints(TFunction<void(AJGChunk*)> setupFunction, const FString& operationName);